@@ -0,0 +1,114 @@
+/*
+ * libtcod tileset cache tool
+ * Converts a tilesheet, TrueType font, or BDF font into a precompiled tileset cache.
+ * It's in the public domain.
+ */
+#include <libtcod.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_usage(const char* program) {
+  fprintf(
+      stderr,
+      "Usage: %s [options] <source> <cache>\n"
+      "\n"
+      "Options:\n"
+      "  --type tilesheet|truetype|bdf  Type of the source file, by default this is taken from its extension.\n"
+      "  --columns N --rows N           Layout of a tilesheet, defaults to 16 by 16.\n"
+      "  --charmap cp437|tcod           Character map of a tilesheet, defaults to cp437.\n"
+      "  --size W H                     Tile size of a TrueType font, defaults to 0 by 16.\n",
+      program);
+}
+
+/* Guess the source type from the file extension of `path`. */
+static TCOD_TilesetSourceType type_from_path(const char* path) {
+  const char* extension = strrchr(path, '.');
+  if (extension && (strcmp(extension, ".ttf") == 0 || strcmp(extension, ".otf") == 0)) {
+    return TCOD_TILESET_SOURCE_TRUETYPE;
+  }
+  if (extension && strcmp(extension, ".bdf") == 0) {
+    return TCOD_TILESET_SOURCE_BDF;
+  }
+  return TCOD_TILESET_SOURCE_TILESHEET;
+}
+
+int main(int argc, char** argv) {
+  TCOD_TilesetSource source = {
+      .columns = 16,
+      .rows = 16,
+      .charmap_length = 256,
+      .charmap = TCOD_CHARMAP_CP437,
+      .tile_width = 0,
+      .tile_height = 16,
+  };
+  const char* type_name = NULL;
+  const char* cache_path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--type") == 0 && i + 1 < argc) {
+      type_name = argv[++i];
+    } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+      source.columns = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+      source.rows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--charmap") == 0 && i + 1 < argc) {
+      ++i;
+      if (strcmp(argv[i], "cp437") == 0) {
+        source.charmap = TCOD_CHARMAP_CP437;
+      } else if (strcmp(argv[i], "tcod") == 0) {
+        source.charmap = TCOD_CHARMAP_TCOD;
+      } else {
+        fprintf(stderr, "Unknown charmap: %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+      source.tile_width = atoi(argv[++i]);
+      source.tile_height = atoi(argv[++i]);
+    } else if (argv[i][0] == '-') {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    } else if (!source.path) {
+      source.path = argv[i];
+    } else if (!cache_path) {
+      cache_path = argv[i];
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!source.path || !cache_path) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (!type_name) {
+    source.type = type_from_path(source.path);
+  } else if (strcmp(type_name, "tilesheet") == 0) {
+    source.type = TCOD_TILESET_SOURCE_TILESHEET;
+  } else if (strcmp(type_name, "truetype") == 0) {
+    source.type = TCOD_TILESET_SOURCE_TRUETYPE;
+  } else if (strcmp(type_name, "bdf") == 0) {
+    source.type = TCOD_TILESET_SOURCE_BDF;
+  } else {
+    fprintf(stderr, "Unknown source type: %s\n", type_name);
+    return EXIT_FAILURE;
+  }
+
+  uint64_t source_hash;
+  if (TCOD_tileset_source_hash(&source, &source_hash) < 0) {
+    fprintf(stderr, "%s\n", TCOD_get_error());
+    return EXIT_FAILURE;
+  }
+  TCOD_Tileset* tileset = TCOD_tileset_load_source(&source);
+  if (!tileset) {
+    fprintf(stderr, "%s\n", TCOD_get_error());
+    return EXIT_FAILURE;
+  }
+  if (TCOD_tileset_save_cache(tileset, cache_path, source_hash) < 0) {
+    fprintf(stderr, "%s\n", TCOD_get_error());
+    TCOD_tileset_delete(tileset);
+    return EXIT_FAILURE;
+  }
+  printf("Wrote %d %dx%d tiles to %s\n", tileset->tiles_count, tileset->tile_width, tileset->tile_height, cache_path);
+  TCOD_tileset_delete(tileset);
+  return EXIT_SUCCESS;
+}
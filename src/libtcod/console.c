@@ -32,10 +32,22 @@
 #include "console.h"
 
 #include <stdlib.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif  // _MSC_VER
 
 #include "libtcod_int.h"
 #include "utility.h"
 
+#if defined(__AVX2__)
+#define TCOD_CONSOLE_DIFF_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TCOD_CONSOLE_DIFF_SSE2
+#include <emmintrin.h>
+#endif
+
 static TCOD_Error TCOD_console_data_alloc(struct TCOD_Console* console) {
   if (!console) {
     return TCOD_E_ERROR;
@@ -55,6 +67,108 @@ static void TCOD_console_data_free(struct TCOD_Console* con) {
     con->tiles = NULL;
   }
 }
+/**
+    A console with dirty tracking and its tracking state.
+
+    TCOD_Console is a public struct which bindings construct directly, so it can not gain a field for this state.
+    Tracked consoles are looked up by address instead.
+ */
+typedef struct DirtyEntry {
+  const TCOD_Console* console;
+  struct TCOD_ConsoleDirty* dirty;
+} DirtyEntry;
+static DirtyEntry* g_dirty_entries = NULL;  // Guarded by `g_dirty_lock`.
+static int g_dirty_capacity = 0;  // Guarded by `g_dirty_lock`.
+static int g_dirty_count = 0;  // Only changed while `g_dirty_lock` is held, but read without it.
+static unsigned int g_dirty_generation = 0;  // Changed with every added or removed entry, read without the lock.
+#ifndef TCOD_NO_THREADS
+static TCOD_mutex_t g_dirty_lock = NULL;  // Created by the first call to `dirty_lock`.
+#endif  // TCOD_NO_THREADS
+#ifdef TCOD_THREAD_LOCAL
+/// The last lookup made by this thread, it is valid while `g_dirty_generation` is unchanged.
+static TCOD_THREAD_LOCAL DirtyEntry t_dirty_last;
+static TCOD_THREAD_LOCAL unsigned int t_dirty_last_generation;
+#endif  // TCOD_THREAD_LOCAL
+static int load_relaxed_int(const int* value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(value, __ATOMIC_RELAXED);
+#else
+  return *(const volatile int*)value;
+#endif
+}
+static unsigned int load_relaxed_uint(const unsigned int* value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(value, __ATOMIC_RELAXED);
+#else
+  return *(const volatile unsigned int*)value;
+#endif
+}
+/// Add `add` to the entry count and invalidate the lookups cached by every thread.  The lock must be held.
+static void dirty_entries_changed(int add) {
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(&g_dirty_count, g_dirty_count + add, __ATOMIC_RELAXED);
+  __atomic_store_n(&g_dirty_generation, g_dirty_generation + 1, __ATOMIC_RELAXED);
+#else
+  *(volatile int*)&g_dirty_count = g_dirty_count + add;
+  *(volatile unsigned int*)&g_dirty_generation = g_dirty_generation + 1;
+#endif
+}
+/// Lock the tracked console entries, returns false if the lock could not be created.
+static bool dirty_lock(void) {
+#ifndef TCOD_NO_THREADS
+#if defined(__GNUC__) || defined(__clang__)
+  TCOD_mutex_t lock = __atomic_load_n(&g_dirty_lock, __ATOMIC_ACQUIRE);
+#else
+  TCOD_mutex_t lock = *(TCOD_mutex_t volatile*)&g_dirty_lock;  // MSVC treats volatile reads as acquire loads.
+#endif
+  if (!lock) {
+    TCOD_mutex_t new_lock = TCOD_mutex_new();
+    if (!new_lock) return false;
+    // Another thread may have created the lock first, in which case that lock is used.
+#if defined(__GNUC__) || defined(__clang__)
+    TCOD_mutex_t expected = NULL;
+    if (__atomic_compare_exchange_n(&g_dirty_lock, &expected, new_lock, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      lock = new_lock;
+    } else {
+      lock = expected;
+    }
+#elif defined(_MSC_VER)
+    lock = _InterlockedCompareExchangePointer((void* volatile*)&g_dirty_lock, new_lock, NULL);
+    if (!lock) lock = new_lock;
+#else
+    lock = g_dirty_lock = new_lock;
+#endif
+    if (lock != new_lock) TCOD_mutex_delete(new_lock);
+  }
+  TCOD_mutex_in(lock);
+#endif  // TCOD_NO_THREADS
+  return true;
+}
+static void dirty_unlock(void) {
+#ifndef TCOD_NO_THREADS
+  TCOD_mutex_out(g_dirty_lock);
+#endif  // TCOD_NO_THREADS
+}
+/// Return the index of `console` in `g_dirty_entries` or -1.  The lock must be held.
+static int dirty_find_index(const TCOD_Console* console) {
+  for (int i = 0; i < g_dirty_count; ++i) {
+    if (g_dirty_entries[i].console == console) return i;
+  }
+  return -1;
+}
+/// Remove the tracking of `console` and return it, or return NULL if it was not tracked.
+static struct TCOD_ConsoleDirty* dirty_remove(const TCOD_Console* console) {
+  if (!load_relaxed_int(&g_dirty_count) || !dirty_lock()) return NULL;
+  struct TCOD_ConsoleDirty* dirty = NULL;
+  const int index = dirty_find_index(console);
+  if (index >= 0) {
+    dirty = g_dirty_entries[index].dirty;
+    g_dirty_entries[index] = g_dirty_entries[g_dirty_count - 1];
+    dirty_entries_changed(-1);
+  }
+  dirty_unlock();
+  return dirty;
+}
 static bool TCOD_console_init_(TCOD_Console* con) {
   con = TCOD_console_validate_(con);
   if (!con) {
@@ -98,6 +212,7 @@ void TCOD_console_delete(TCOD_Console* con) {
       console->on_delete(console);
     }
     TCOD_console_data_free(console);
+    free(dirty_remove(console));
     free(console);
   }
   if (console == TCOD_ctx.root) {
@@ -120,6 +235,205 @@ void TCOD_console_resize_(TCOD_Console* console, int width, int height) {
   console->h = height;
   console->elements = width * height;
   TCOD_console_data_alloc(console);
+  struct TCOD_ConsoleDirty* dirty = dirty_remove(console);
+  if (dirty) {
+    free(dirty);
+    (void)TCOD_console_set_dirty_tracking(console, true);
+  }
+}
+uint64_t TCOD_console_next_version_(void) {
+  // Consoles may be changed on different threads, each change must still get its own version.
+#if defined(__GNUC__) || defined(__clang__)
+  static uint64_t last_version = 0;
+  return __atomic_add_fetch(&last_version, 1, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+  static volatile __int64 last_version = 0;
+  return (uint64_t)_InterlockedIncrement64(&last_version);
+#else
+  static uint64_t last_version = 0;
+  return ++last_version;
+#endif
+}
+/// Return the tracking of `console` from the entries or from the last lookup of this thread.
+static struct TCOD_ConsoleDirty* dirty_lookup(const TCOD_Console* console) {
+#ifdef TCOD_THREAD_LOCAL
+  if (t_dirty_last.console == console && t_dirty_last_generation == load_relaxed_uint(&g_dirty_generation)) {
+    return t_dirty_last.dirty;
+  }
+#endif  // TCOD_THREAD_LOCAL
+  if (!dirty_lock()) return NULL;
+  const int index = dirty_find_index(console);
+  struct TCOD_ConsoleDirty* dirty = index >= 0 ? g_dirty_entries[index].dirty : NULL;
+#ifdef TCOD_THREAD_LOCAL
+  t_dirty_last = (DirtyEntry){console, dirty};
+  t_dirty_last_generation = g_dirty_generation;
+#endif  // TCOD_THREAD_LOCAL
+  dirty_unlock();
+  return dirty;
+}
+struct TCOD_ConsoleDirty* TCOD_console_get_dirty_(const TCOD_Console* console) {
+  if (!console || !load_relaxed_int(&g_dirty_count)) return NULL;  // Programs without tracking stop here.
+  struct TCOD_ConsoleDirty* dirty = dirty_lookup(console);
+  // A mismatch means the console was freed and replaced without TCOD_console_delete, its rows are not trusted.
+  if (dirty && dirty->rows_length != console->h) return NULL;
+  return dirty;
+}
+const struct TCOD_ConsoleDirty* TCOD_console_observe_dirty_(const TCOD_Console* console) {
+  struct TCOD_ConsoleDirty* dirty = TCOD_console_get_dirty_(console);
+  if (!dirty) return NULL;
+  const uint64_t version = TCOD_console_next_version_();
+  // Several threads may draw the same console, writes to the console itself are never done while it is drawn.
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(&dirty->version, version, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+  _InterlockedExchange64((volatile __int64*)&dirty->version, (__int64)version);
+#else
+  dirty->version = version;
+#endif
+  return dirty;
+}
+TCOD_Error TCOD_console_set_dirty_tracking(TCOD_Console* console, bool enable) {
+  console = TCOD_console_validate_(console);
+  if (!console) {
+    TCOD_set_errorv("Console must not be NULL or root console must exist.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (!enable) {
+    free(dirty_remove(console));
+    return TCOD_E_OK;
+  }
+  if (TCOD_console_get_dirty_(console)) {
+    return TCOD_E_OK;
+  }
+  struct TCOD_ConsoleDirty* dirty = malloc(sizeof(*dirty) + sizeof(*dirty->rows) * console->h);
+  if (!dirty) {
+    TCOD_set_errorv("Out of memory while allocating console dirty rows.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  dirty->version = TCOD_console_next_version_();
+  dirty->rows_length = console->h;
+  dirty->rows = (uint64_t*)(dirty + 1);
+  for (int y = 0; y < console->h; ++y) dirty->rows[y] = dirty->version;  // Every row starts as changed.
+  if (!dirty_lock()) {
+    free(dirty);
+    TCOD_set_errorv("Could not create the console dirty tracking lock.");
+    return TCOD_E_ERROR;
+  }
+  if (g_dirty_count == g_dirty_capacity) {
+    const int new_capacity = g_dirty_capacity ? g_dirty_capacity * 2 : 16;
+    DirtyEntry* new_entries = realloc(g_dirty_entries, sizeof(*new_entries) * new_capacity);
+    if (!new_entries) {
+      dirty_unlock();
+      free(dirty);
+      TCOD_set_errorv("Out of memory while allocating console dirty rows.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    g_dirty_entries = new_entries;
+    g_dirty_capacity = new_capacity;
+  }
+  g_dirty_entries[g_dirty_count] = (DirtyEntry){console, dirty};
+  dirty_entries_changed(1);
+  dirty_unlock();
+  return TCOD_E_OK;
+}
+void TCOD_console_mark_dirty(TCOD_Console* console, int x, int y, int width, int height) {
+  console = TCOD_console_validate_(console);
+  if (!console || x >= console->w || x + width <= 0 || width <= 0) {
+    return;
+  }
+  const int y_begin = TCOD_MAX(0, y);
+  const int y_end = TCOD_MIN(console->h, y + height);
+  if (y_begin >= y_end) return;
+  struct TCOD_ConsoleDirty* dirty = TCOD_console_get_dirty_(console);
+  if (!dirty) return;
+  for (int row = y_begin; row < y_end; ++row) dirty->rows[row] = dirty->version;
+}
+uint64_t TCOD_console_get_row_version(const TCOD_Console* console, int y) {
+  console = TCOD_console_validate_(console);
+  if (!console || y < 0 || y >= console->h) {
+    return 0;
+  }
+  const struct TCOD_ConsoleDirty* dirty = TCOD_console_get_dirty_(console);
+  if (!dirty) return 0;
+  const uint64_t version = dirty->rows[y];
+  // Once the current version has been seen, later changes must be given a different one.
+  if (version == dirty->version) (void)TCOD_console_observe_dirty_(console);
+  return version;
+}
+/**
+    Keep every third bit of the lowest 48 bits of `x` and pack them into the lowest 16 bits.
+ */
+static uint64_t compress_every_third_bit(uint64_t x) {
+  x &= 0x249249249249;
+  x = (x | x >> 2) & 0x0C30C30C30C3;
+  x = (x | x >> 4) & 0x00F00F00F00F;
+  x = (x | x >> 8) & 0x0000FF0000FF;
+  x = (x | x >> 16) & 0xFFFF;
+  return x;
+}
+/**
+    Return a mask of the 48 differing 32-bit lanes of 16 tiles, three lanes per tile in the order: ch, fg, bg.
+ */
+static uint64_t diff_16_tiles(const TCOD_ConsoleTile* __restrict tiles, const TCOD_ConsoleTile* __restrict cache) {
+  uint64_t lanes = 0;
+#if defined(TCOD_CONSOLE_DIFF_AVX2)
+  for (int i = 0; i < 6; ++i) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)tiles + i);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)cache + i);
+    const int equal = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    lanes |= (uint64_t)(equal ^ 0xFF) << (i * 8);
+  }
+#elif defined(TCOD_CONSOLE_DIFF_SSE2)
+  for (int i = 0; i < 12; ++i) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)tiles + i);
+    const __m128i b = _mm_loadu_si128((const __m128i*)cache + i);
+    const int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+    lanes |= (uint64_t)(equal ^ 0xF) << (i * 4);
+  }
+#else
+  uint32_t a[48];
+  uint32_t b[48];
+  memcpy(a, tiles, sizeof(a));
+  memcpy(b, cache, sizeof(b));
+  for (int i = 0; i < 48; ++i) lanes |= (uint64_t)(a[i] != b[i]) << i;
+#endif
+  return lanes;
+}
+bool TCOD_console_diff_tiles(
+    const TCOD_ConsoleTile* __restrict tiles,
+    const TCOD_ConsoleTile* __restrict cache,
+    int count,
+    uint64_t* __restrict bg_changed,
+    uint64_t* __restrict fg_changed) {
+  uint64_t any_changed = 0;
+  for (int word = 0; word * 64 < count; ++word) {
+    const int begin = word * 64;
+    const int end = TCOD_MIN(count, begin + 64);
+    uint64_t bg = 0;
+    uint64_t fg = 0;
+    int i = begin;
+    if (sizeof(TCOD_ConsoleTile) == 12) {
+      for (; i + 16 <= end; i += 16) {
+        const uint64_t lanes = diff_16_tiles(tiles + i, cache + i);
+        if (!lanes) continue;
+        bg |= compress_every_third_bit(lanes >> 2) << (i - begin);
+        fg |= compress_every_third_bit(lanes | lanes >> 1) << (i - begin);
+      }
+    }
+    for (; i < end; ++i) {
+      const TCOD_ConsoleTile* a = &tiles[i];
+      const TCOD_ConsoleTile* b = &cache[i];
+      const bool bg_differs = a->bg.r != b->bg.r || a->bg.g != b->bg.g || a->bg.b != b->bg.b || a->bg.a != b->bg.a;
+      const bool fg_differs = a->ch != b->ch || a->fg.r != b->fg.r || a->fg.g != b->fg.g || a->fg.b != b->fg.b ||
+                              a->fg.a != b->fg.a;
+      bg |= (uint64_t)bg_differs << (i - begin);
+      fg |= (uint64_t)fg_differs << (i - begin);
+    }
+    bg_changed[word] = bg;
+    fg_changed[word] = fg;
+    any_changed |= bg | fg;
+  }
+  return any_changed != 0;
 }
 int TCOD_console_get_width(const TCOD_Console* con) {
   con = TCOD_console_validate_(con);
@@ -241,6 +555,7 @@ void TCOD_console_blit_key_color(
   if (xDst + wSrc < 0 || yDst + hSrc < 0 || xDst >= dst->w || yDst >= dst->h) {
     return;
   }
+  TCOD_console_mark_dirty(dst, xDst, yDst, wSrc, hSrc);
   for (int cx = xSrc; cx < xSrc + wSrc; ++cx) {
     for (int cy = ySrc; cy < ySrc + hSrc; ++cy) {
       /* Check if we're outside the dest console. */
@@ -290,7 +605,7 @@ void TCOD_console_put_char(TCOD_Console* con, int x, int y, int c, TCOD_bkgnd_fl
   if (!TCOD_console_is_index_valid_(con, x, y)) {
     return;
   }
-  con->tiles[y * con->w + x].ch = c;
+  con->tiles[y * con->w + x].ch = c;  // The row is marked as changed by the color setters.
   TCOD_console_set_char_foreground(con, x, y, con->fore);
   TCOD_console_set_char_background(con, x, y, con->back, flag);
 }
@@ -299,7 +614,7 @@ void TCOD_console_put_char_ex(TCOD_Console* con, int x, int y, int c, TCOD_color
   if (!TCOD_console_is_index_valid_(con, x, y)) {
     return;
   }
-  con->tiles[y * con->w + x].ch = c;
+  con->tiles[y * con->w + x].ch = c;  // The row is marked as changed by the color setters.
   TCOD_console_set_char_foreground(con, x, y, fore);
   TCOD_console_set_char_background(con, x, y, back, TCOD_BKGND_SET);
 }
@@ -316,6 +631,7 @@ void TCOD_console_clear(TCOD_Console* con) {
   for (int i = 0; i < con->elements; ++i) {
     con->tiles[i] = fill;
   }
+  TCOD_console_mark_dirty(con, 0, 0, con->w, con->h);
 }
 TCOD_color_t TCOD_console_get_char_background(const TCOD_Console* con, int x, int y) {
   con = TCOD_console_validate_(con);
@@ -331,6 +647,7 @@ void TCOD_console_set_char_foreground(TCOD_Console* con, int x, int y, TCOD_colo
   if (!TCOD_console_is_index_valid_(con, x, y)) {
     return;
   }
+  TCOD_console_mark_row_dirty_(con, y);
   struct TCOD_ColorRGBA* out = &con->tiles[y * con->w + x].fg;
   out->r = col.r;
   out->g = col.g;
@@ -400,6 +717,7 @@ void TCOD_console_set_char_background(TCOD_Console* con, int x, int y, TCOD_colo
   if (!TCOD_console_is_index_valid_(con, x, y)) {
     return;
   }
+  TCOD_console_mark_row_dirty_(con, y);
   struct TCOD_ColorRGBA* bg = &con->tiles[y * con->w + x].bg;
   if (flag == TCOD_BKGND_DEFAULT) {
     flag = con->bkgnd_flag;
@@ -467,6 +785,7 @@ void TCOD_console_set_char(TCOD_Console* con, int x, int y, int c) {
     return;
   }
   con->tiles[y * con->w + x].ch = c;
+  TCOD_console_mark_row_dirty_(con, y);
 }
 void TCOD_console_set_default_foreground(TCOD_Console* con, TCOD_color_t col) {
   con = TCOD_console_validate_(con);
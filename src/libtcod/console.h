@@ -273,6 +273,69 @@ TCOD_PUBLIC TCOD_NODISCARD int TCOD_console_get_width(const TCOD_Console* con);
  */
 TCOD_PUBLIC TCOD_NODISCARD int TCOD_console_get_height(const TCOD_Console* con);
 TCOD_PUBLIC void TCOD_console_set_key_color(TCOD_Console* con, TCOD_color_t col);
+/**
+    Enable or disable tracking which rows of `console` have changed.
+
+    \rst
+    While enabled, the console functions of libtcod record the rows they write to and renderers skip rows which
+    have not changed since they last drew this console.
+    Code which writes to the `tiles` array directly must call :any:`TCOD_console_mark_dirty` for the changed area.
+
+    Enabling tracking marks every row as changed.
+    A console which is freed without :any:`TCOD_console_delete` must have its tracking disabled first.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_console_set_dirty_tracking(TCOD_Console* console, bool enable);
+/**
+    Mark the tiles in a rectangle of `console` as changed.
+
+    \rst
+    Use this after writing to the `tiles` array directly.
+    The rectangle is clipped to the console.  Does nothing if dirty tracking is disabled.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_console_mark_dirty(TCOD_Console* console, int x, int y, int width, int height);
+/**
+    Return the version of row `y` of `console`, this changes every time the row is changed.
+
+    \rst
+    A renderer can skip a row which has the same version as when it was last drawn.
+    Versions are unique to each console and are never reused, even after tracking is disabled and enabled again.
+
+    Returns zero if dirty tracking is disabled or `y` is out of bounds, such rows should always be treated as changed.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_NODISCARD uint64_t TCOD_console_get_row_version(const TCOD_Console* console, int y);
+/**
+    Compare `count` tiles of `tiles` against `cache` and output which tiles have changed as bitmasks.
+
+    \rst
+    Bit ``i % 64`` of ``bg_changed[i / 64]`` is set if the background color of tile `i` differs.
+    The same bit of `fg_changed` is set if the glyph or foreground color of tile `i` differs.
+    `bg_changed` and `fg_changed` must each have room for ``(count + 63) / 64`` words, bits past `count` are cleared.
+
+    Tiles are compared bit for bit, several tiles at a time.  This is meant for renderers which keep a copy of the
+    last tiles they drew.
+
+    Returns true if any tile has changed.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC bool TCOD_console_diff_tiles(
+    const TCOD_ConsoleTile* __restrict tiles,
+    const TCOD_ConsoleTile* __restrict cache,
+    int count,
+    uint64_t* __restrict bg_changed,
+    uint64_t* __restrict fg_changed);
 /**
  *  Blit from one console to another.
  *
@@ -71,6 +71,7 @@ void TCOD_console_put_rgb(
   int console_index = y * console->w + x;
   if (ch > 0) {
     console->tiles[console_index].ch = ch;
+    TCOD_console_mark_row_dirty_(console, y);
   }
   if (fg) {
     TCOD_console_set_char_foreground(console, x, y, *fg);
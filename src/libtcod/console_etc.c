@@ -134,14 +134,9 @@ TCOD_Error TCOD_console_flush_ex(TCOD_Console* console, struct TCOD_ViewportOpti
 }
 TCOD_Error TCOD_console_flush(void) { return TCOD_console_flush_ex(NULL, NULL); }
 /**
- *  Manually mark a region of a console as dirty.
+ *  Manually mark a region of the root console as dirty.
  */
-void TCOD_console_set_dirty(int dx, int dy, int dw, int dh) {
-  (void)dx;
-  (void)dy;
-  (void)dw;
-  (void)dh;  // Ignore.
-}
+void TCOD_console_set_dirty(int dx, int dy, int dw, int dh) { TCOD_console_mark_dirty(NULL, dx, dy, dw, dh); }
 /**
  *  \brief Set a font image to be loaded during initialization.
  *
@@ -565,6 +565,16 @@ typedef enum TCOD_renderer_t {
       \endrst
    */
   TCOD_RENDERER_XTERM,
+  /***************************************************************************
+      @brief A software renderer which draws into memory instead of a window.
+
+      This renderer does not need SDL or a display.  See TCOD_renderer_init_headless.
+
+      \rst
+      .. versionadded:: Unreleased
+      \endrst
+   */
+  TCOD_RENDERER_HEADLESS,
   TCOD_NB_RENDERERS,
 } TCOD_renderer_t;
 #endif  // TCOD_CONSOLE_TYPES_H_
@@ -36,6 +36,7 @@
 #define TCOD_FOV_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #ifdef __cplusplus
 #include <memory>
 #endif  // __cplusplus
@@ -123,6 +124,196 @@ TCOD_PUBLIC int TCOD_map_get_height(const TCOD_Map* map);
     Return the total number of cells in `map`.
  */
 TCOD_PUBLIC int TCOD_map_get_nb_cells(const TCOD_Map* map);
+/**
+    Calculate the field-of-view and output the visible cells to `out`.
+
+    \rst
+    This takes the same parameters as :any:`TCOD_map_compute_fov`, but only the area within `max_radius` of the
+    point-of-view is cleared and scanned, so the cost no longer depends on the total size of the map.
+    The fov flags of `map` are updated as usual for the cells within this area.
+
+    The cells listed in `out` by a previous call are cleared from `map` before the new computation.
+    Reuse the same `out` with the same `map` so that the old view is erased.
+    Cells marked visible by other means outside of the new area will not be cleared.
+
+    If `max_radius` is zero or less then the entire map is scanned.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_compute_fov_visible(
+    TCOD_Map* __restrict map,
+    int pov_x,
+    int pov_y,
+    int max_radius,
+    bool light_walls,
+    TCOD_fov_algorithm_t algo,
+    TCOD_FOVVisible* __restrict out);
+/**
+    Append the visible cells of `map` within the given rectangle to `out`.
+
+    \rst
+    The rectangle is clipped to the bounds of `map`.
+    Call :any:`TCOD_fov_visible_clear` first if the old contents of `out` should be discarded.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_get_fov_visible(
+    const TCOD_Map* __restrict map, int x, int y, int width, int height, TCOD_FOVVisible* __restrict out);
+/**
+    Remove all cells from `visible` while keeping its allocated buffers.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_fov_visible_clear(TCOD_FOVVisible* visible);
+/**
+    Free the buffers held by `visible`, the struct itself is not freed.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_fov_visible_uninit(TCOD_FOVVisible* visible);
+/**
+    Output the transparency of every cell of `map` as packed bit rows.
+
+    \rst
+    Each row takes `(width + 63) / 64` words of `out`, the cell at `{x, y}` is bit `x % 64` of
+    `out[y * ((width + 63) / 64) + x / 64]`.
+    Unused bits at the end of each row are set to zero.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_get_transparent_bits(const TCOD_Map* __restrict map, uint64_t* __restrict out);
+/**
+    Output the field-of-view flags of `map` as packed bit rows.
+
+    \rst
+    The layout is the same as :any:`TCOD_map_get_transparent_bits`.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_get_fov_bits(const TCOD_Map* __restrict map, uint64_t* __restrict out);
+/**
+    Set the field-of-view flags of `map` from packed bit rows.
+
+    \rst
+    The layout is the same as :any:`TCOD_map_get_transparent_bits`.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_set_fov_bits(TCOD_Map* __restrict map, const uint64_t* __restrict bits);
+/**
+    Free the scratch memory kept by field-of-view algorithms on the calling thread.
+
+    \rst
+    Some algorithms such as :any:`FOV_PERMISSIVE_0` and :any:`FOV_DIAMOND` keep a working buffer for each thread
+    which grows to fit the largest map seen and is reused to avoid allocating on every call.
+    :any:`FOV_BASIC` keeps a table of precomputed rays for each radius used.
+    Call this to return that memory, for example before a worker thread exits.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_fov_free_scratch(void);
+/**
+    Check line-of-sight for a batch of endpoint pairs.
+
+    \rst
+    `endpoints` is an array of `count` pairs, each as `{x1, y1, x2, y2}`.
+
+    A pair has line-of-sight if every cell strictly between its endpoints on the Bresenham line
+    traced by :any:`TCOD_line_init_mt` is transparent.
+    The endpoints themselves are not checked, so a wall can see and be seen.
+    Pairs with an endpoint outside of `map` do not have line-of-sight.
+
+    The result of pair `i` is written to bit `i % 8` of `out[i / 8]`,
+    `out` must be at least `(count + 7) / 8` bytes long.
+
+    Rays are traced once per unique displacement and shared by all pairs with that displacement.
+    Large batches are split over multiple threads.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_compute_line_of_sight(
+    const TCOD_Map* __restrict map, int count, const int (*__restrict endpoints)[4], uint8_t* __restrict out);
+/**
+    Find which observers can see a target cell.
+
+    \rst
+    `observers` is an array of `count` positions as `{x, y}`.
+    The indexes of the observers which can see `{target_x, target_y}` are written to `out` in increasing order,
+    and the number of indexes written is stored in `out_count`.
+    `out` must have room for `count` indexes.
+
+    Visibility is computed with a single :any:`FOV_SYMMETRIC_SHADOWCAST` view from the target,
+    so this is the same as computing that view from each observer with `max_radius` and `light_walls` enabled,
+    as long as both the target and the observer are on transparent cells.
+    Observers outside of `map` can not see the target.
+
+    The fov flags of `map` are not modified.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_compute_observers(
+    const TCOD_Map* __restrict map,
+    int target_x,
+    int target_y,
+    int max_radius,
+    int count,
+    const int (*__restrict observers)[2],
+    int* __restrict out,
+    int* __restrict out_count);
+/**
+    Calculate the field-of-view over a stack of map layers.
+
+    \rst
+    `layers` is an array of `layer_count` maps of the same size, ordered from the bottom layer up.
+    The `transparent` attribute of each layer is used for walls within that layer.
+
+    `floors` is an optional array of `layer_count` maps which describe the floor of each layer.
+    A transparent cell in `floors[z]` is an opening in the floor of layer `z`, such as a chasm,
+    which light can pass through between that cell and the same cell of layer `z - 1`.
+    The floor of the bottom layer is always solid.
+    If `floors` is NULL, or an item of it is NULL, then those floors are fully solid.
+
+    `pov_x`, `pov_y`, and `pov_z` are the point-of-view, `pov_z` being the index of its layer.
+    Layers are one cell tall, `max_radius` is a spherical radius over all three axes.
+
+    The view is computed with rays in a single pass over all layers,
+    using bitplanes for the area within `max_radius` of each layer.
+    Afterwards the fov flags of every layer are set as with :any:`TCOD_map_compute_fov`.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_map_compute_fov_layers(
+    TCOD_Map* const* __restrict layers,
+    const TCOD_Map* const* __restrict floors,
+    int layer_count,
+    int pov_x,
+    int pov_y,
+    int pov_z,
+    int max_radius,
+    bool light_walls);
 /// @}
 #ifdef __cplusplus
 }  // extern "C"
@@ -29,12 +29,65 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "fov.h"
 #include "libtcod_int.h"
 #include "utility.h"
+
+/**
+    Reusable memory for field-of-view algorithms, kept by each thread.
+ */
+typedef struct FOVScratch {
+  void* data;
+  size_t capacity;  // The allocated size of `data` in bytes.
+  bool in_use;  // True while an algorithm holds `data`.
+} FOVScratch;
+#ifdef TCOD_THREAD_LOCAL
+static TCOD_THREAD_LOCAL FOVScratch fov_scratch = {0};
+#endif  // TCOD_THREAD_LOCAL
+void* TCOD_fov_scratch_acquire(size_t size) {
+  if (size == 0) size = 1;
+#ifdef TCOD_THREAD_LOCAL
+  if (!fov_scratch.in_use) {
+    if (fov_scratch.capacity < size) {
+      // The old contents are not kept, so avoid the copy done by realloc.
+      free(fov_scratch.data);
+      fov_scratch.data = malloc(size);
+      fov_scratch.capacity = fov_scratch.data ? size : 0;
+      if (!fov_scratch.data) {
+        TCOD_set_errorv("Out of memory.");
+        return NULL;
+      }
+    }
+    fov_scratch.in_use = true;
+    return fov_scratch.data;
+  }
+#endif  // TCOD_THREAD_LOCAL
+  // No thread-local storage or the scratch buffer is already taken, fall back to a temporary allocation.
+  void* data = malloc(size);
+  if (!data) TCOD_set_errorv("Out of memory.");
+  return data;
+}
+void TCOD_fov_scratch_release(void* scratch) {
+#ifdef TCOD_THREAD_LOCAL
+  if (scratch && scratch == fov_scratch.data) {
+    fov_scratch.in_use = false;
+    return;
+  }
+#endif  // TCOD_THREAD_LOCAL
+  free(scratch);
+}
+void TCOD_fov_free_scratch(void) {
+  TCOD_fov_circular_raycasting_free_tables();
+#ifdef TCOD_THREAD_LOCAL
+  if (fov_scratch.in_use) return;
+  free(fov_scratch.data);
+  fov_scratch = (FOVScratch){0};
+#endif  // TCOD_THREAD_LOCAL
+}
 struct TCOD_Map* TCOD_map_new(int width, int height) {
   if (width <= 0 || height <= 0) {
     return NULL;
@@ -91,48 +144,160 @@ void TCOD_map_delete(struct TCOD_Map* map) {
   free(map->cells);
   free(map);
 }
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_WIN32)
+#define TCOD_MAP_PACK_WORDS 1
+#endif
+#ifdef TCOD_MAP_PACK_WORDS
+/**
+    Move the lowest bit of each byte of `bytes` into a single byte.
+
+    Every byte must be zero or one.
+ */
+static uint64_t gather_byte_bits(uint64_t bytes) { return (bytes * 0x0102040810204080u) >> 56; }
+/**
+    Keep every third bit of the lowest 24 bits of `x` and pack them into the lowest 8 bits.
+ */
+static uint64_t compress_every_third_bit(uint64_t x) {
+  x &= 0x249249;
+  x = (x | x >> 2) & 0x0C30C3;
+  x = (x | x >> 4) & 0x00F00F;
+  x = (x | x >> 8) & 0x0000FF;
+  return x;
+}
+#endif  // TCOD_MAP_PACK_WORDS
+/**
+    Return `count` cells, up to 64, as a word where bit `i` is set if cell `i` has all of `fields` set.
+
+    If `opaque` is not NULL then it is set to a word where bit `i` is set if cell `i` is not transparent.
+ */
+static uint64_t pack_cells(const struct TCOD_MapCell* __restrict cells, int count, int fields, uint64_t* opaque) {
+  uint64_t bits = 0;
+  uint64_t opaque_bits = 0;
+  int i = 0;
+#ifdef TCOD_MAP_PACK_WORDS
+  if (sizeof(struct TCOD_MapCell) == 3) {
+    // Load 8 cells as 24 bytes, then select one bit from each group of 3 fields.
+    for (; i + 8 <= count; i += 8) {
+      uint64_t words[3];
+      memcpy(words, &cells[i], sizeof(words));
+      const uint64_t all = gather_byte_bits(words[0]) | gather_byte_bits(words[1]) << 8 |
+                           gather_byte_bits(words[2]) << 16;
+      uint64_t selected = ~(uint64_t)0;
+      if (fields & TCOD_MAP_CELL_TRANSPARENT) selected &= all;
+      if (fields & TCOD_MAP_CELL_WALKABLE) selected &= all >> 1;
+      if (fields & TCOD_MAP_CELL_FOV) selected &= all >> 2;
+      bits |= compress_every_third_bit(selected) << i;
+      if (opaque) opaque_bits |= compress_every_third_bit(~all) << i;
+    }
+  }
+#endif  // TCOD_MAP_PACK_WORDS
+  for (; i < count; ++i) {
+    const bool set = (!(fields & TCOD_MAP_CELL_TRANSPARENT) || cells[i].transparent) &&
+                     (!(fields & TCOD_MAP_CELL_WALKABLE) || cells[i].walkable) && (!(fields & TCOD_MAP_CELL_FOV) || cells[i].fov);
+    bits |= (uint64_t)set << i;
+    opaque_bits |= (uint64_t)!cells[i].transparent << i;
+  }
+  if (opaque) *opaque = opaque_bits;
+  return bits;
+}
+void TCOD_map_pack_bits(
+    const TCOD_Map* __restrict map,
+    int x0,
+    int y0,
+    int width,
+    int height,
+    int fields,
+    uint64_t* __restrict out,
+    uint64_t* __restrict opaque) {
+  const int stride = (width + 63) / 64;
+  for (int y = 0; y < height; ++y) {
+    const struct TCOD_MapCell* __restrict row = &map->cells[x0 + (y0 + y) * map->width];
+    for (int word = 0; word < stride; ++word) {
+      out[y * stride + word] = pack_cells(
+          &row[word * 64], TCOD_MIN(64, width - word * 64), fields, opaque ? &opaque[y * stride + word] : NULL);
+    }
+  }
+}
+TCOD_Error TCOD_map_get_transparent_bits(const TCOD_Map* __restrict map, uint64_t* __restrict out) {
+  if (!map || !out) return TCOD_set_errorv("Map and output must not be NULL.");
+  TCOD_map_pack_bits(map, 0, 0, map->width, map->height, TCOD_MAP_CELL_TRANSPARENT, out, NULL);
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_map_get_fov_bits(const TCOD_Map* __restrict map, uint64_t* __restrict out) {
+  if (!map || !out) return TCOD_set_errorv("Map and output must not be NULL.");
+  TCOD_map_pack_bits(map, 0, 0, map->width, map->height, TCOD_MAP_CELL_FOV, out, NULL);
+  return TCOD_E_OK;
+}
+void TCOD_map_unpack_fov_bits(
+    TCOD_Map* __restrict map, int x0, int y0, int width, int height, const uint64_t* __restrict bits) {
+  const int stride = (width + 63) / 64;
+  for (int y = 0; y < height; ++y) {
+    struct TCOD_MapCell* __restrict row = &map->cells[x0 + (y0 + y) * map->width];
+    for (int x = 0; x < width; ++x) row[x].fov = (bits[y * stride + x / 64] >> (x % 64)) & 1;
+  }
+}
+TCOD_Error TCOD_map_set_fov_bits(TCOD_Map* __restrict map, const uint64_t* __restrict bits) {
+  if (!map || !bits) return TCOD_set_errorv("Map and bits must not be NULL.");
+  TCOD_map_unpack_fov_bits(map, 0, 0, map->width, map->height, bits);
+  return TCOD_E_OK;
+}
+/**
+    Return the bits of `word` which are within the columns `x0` to `x1` inclusive.
+ */
+static uint64_t column_mask(int word, int x0, int x1) {
+  const int begin = word * 64;
+  if (x1 < begin || x0 >= begin + 64) return 0;
+  const uint64_t low = x0 <= begin ? ~(uint64_t)0 : ~(uint64_t)0 << (x0 - begin);
+  const uint64_t high = x1 >= begin + 63 ? ~(uint64_t)0 : ~(uint64_t)0 >> (63 - (x1 - begin));
+  return low & high;
+}
 /**
     Spread lighting to walls to avoid lighting artifacts.
 
     `x0`, `y0` are the lower bounds.  `x1`, `y1` are the upper bounds.
 
     `dx`, `dy` is the cast direction.
+
+    A visible floor at `{x, y}` lights `{x + dx, y}`, `{x, y + dy}`, and `{x + dx, y + dy}`,
+    as long as both cells are within the bounds.
+    For each row this is a shift of the floor bits from the same row and from the previous row.
  */
-static void TCOD_map_postprocess_quadrant(TCOD_Map* __restrict map, int x0, int y0, int x1, int y1, int dx, int dy) {
-  if (abs(dx) != 1 || abs(dy) != 1) {
-    return;  // Bad parameters.
-  }
-  for (int cx = x0; cx <= x1; cx++) {
-    for (int cy = y0; cy <= y1; cy++) {
-      const int x2 = cx + dx;
-      const int y2 = cy + dy;
-      const int offset = cx + cy * map->width;
-      if (offset < map->nbcells && map->cells[offset].fov == 1 && map->cells[offset].transparent) {
-        if (x2 >= x0 && x2 <= x1) {
-          const int offset2 = x2 + cy * map->width;
-          if (offset2 < map->nbcells && !map->cells[offset2].transparent) {
-            map->cells[offset2].fov = 1;
-          }
-        }
-        if (y2 >= y0 && y2 <= y1) {
-          const int offset2 = cx + y2 * map->width;
-          if (offset2 < map->nbcells && !map->cells[offset2].transparent) {
-            map->cells[offset2].fov = 1;
-          }
-        }
-        if (x2 >= x0 && x2 <= x1 && y2 >= y0 && y2 <= y1) {
-          const int offset2 = x2 + y2 * map->width;
-          if (offset2 < map->nbcells && !map->cells[offset2].transparent) {
-            map->cells[offset2].fov = 1;
-          }
-        }
+static void postprocess_quadrant(
+    const uint64_t* __restrict floors,
+    uint64_t* __restrict lit,
+    int stride,
+    int x0,
+    int y0,
+    int x1,
+    int y1,
+    int dx,
+    int dy) {
+  const int word_begin = x0 / 64;
+  const int word_end = x1 / 64 + 1;
+  for (int y = y0; y <= y1; ++y) {
+    const uint64_t* row = &floors[y * stride];
+    const uint64_t* prev_row = (y - dy >= y0 && y - dy <= y1) ? &floors[(y - dy) * stride] : NULL;
+    // The floor bits which light this row, with and without the shift along x.
+    uint64_t carry = 0;  // Bits shifted in from the neighboring word.
+    if (dx > 0) {
+      for (int word = word_begin; word < word_end; ++word) {
+        const uint64_t mask = column_mask(word, x0, x1);
+        const uint64_t prev = prev_row ? prev_row[word] & mask : 0;
+        const uint64_t both = (row[word] & mask) | prev;
+        lit[y * stride + word] |= (prev | (both << 1) | carry) & mask;
+        carry = both >> 63;
+      }
+    } else {
+      for (int word = word_end - 1; word >= word_begin; --word) {
+        const uint64_t mask = column_mask(word, x0, x1);
+        const uint64_t prev = prev_row ? prev_row[word] & mask : 0;
+        const uint64_t both = (row[word] & mask) | prev;
+        lit[y * stride + word] |= (prev | (both >> 1) | carry) & mask;
+        carry = both << 63;
       }
     }
   }
 }
-/**
-    Spread lighting to walls to avoid lighting artifacts.
- */
 TCOD_Error TCOD_map_postprocess(TCOD_Map* __restrict map, int pov_x, int pov_y, int radius) {
   int x_min = 0;
   int y_min = 0;
@@ -144,16 +309,39 @@ TCOD_Error TCOD_map_postprocess(TCOD_Map* __restrict map, int pov_x, int pov_y,
     x_max = TCOD_MIN(x_max, pov_x + radius + 1);
     y_max = TCOD_MIN(y_max, pov_y + radius + 1);
   }
-  TCOD_map_postprocess_quadrant(map, x_min, y_min, pov_x, pov_y, -1, -1);
-  TCOD_map_postprocess_quadrant(map, pov_x, y_min, x_max - 1, pov_y, 1, -1);
-  TCOD_map_postprocess_quadrant(map, x_min, pov_y, pov_x, y_max - 1, -1, 1);
-  TCOD_map_postprocess_quadrant(map, pov_x, pov_y, x_max - 1, y_max - 1, 1, 1);
+  const int width = x_max - x_min;
+  const int height = y_max - y_min;
+  const int stride = (width + 63) / 64;
+  const size_t plane_size = (size_t)stride * height;
+  uint64_t* scratch = TCOD_fov_scratch_acquire(sizeof(*scratch) * plane_size * 3);
+  if (!scratch) {
+    TCOD_set_errorv("Out of memory while lighting walls.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  uint64_t* __restrict floors = scratch;  // Visible transparent cells.
+  uint64_t* __restrict walls = scratch + plane_size;  // Cells which are not transparent.
+  uint64_t* __restrict lit = scratch + plane_size * 2;  // Cells next to visible floors.
+  TCOD_map_pack_bits(map, x_min, y_min, width, height, TCOD_MAP_CELL_TRANSPARENT | TCOD_MAP_CELL_FOV, floors, walls);
+  memset(lit, 0, sizeof(*lit) * plane_size);
+  const int px = pov_x - x_min;
+  const int py = pov_y - y_min;
+  postprocess_quadrant(floors, lit, stride, 0, 0, px, py, -1, -1);
+  postprocess_quadrant(floors, lit, stride, px, 0, width - 1, py, 1, -1);
+  postprocess_quadrant(floors, lit, stride, 0, py, px, height - 1, -1, 1);
+  postprocess_quadrant(floors, lit, stride, px, py, width - 1, height - 1, 1, 1);
+  for (int y = 0; y < height; ++y) {
+    for (int word = 0; word < stride; ++word) {
+      // Only walls are lit, the bits past the end of the row are never set in `lit`.
+      uint64_t bits = lit[y * stride + word] & walls[y * stride + word];
+      for (; bits; bits &= bits - 1) {
+        map->cells[x_min + word * 64 + TCOD_lowest_bit_(bits) + (y_min + y) * map->width].fov = true;
+      }
+    }
+  }
+  TCOD_fov_scratch_release(scratch);
   return TCOD_E_OK;
 }
-/**
-    Reset the map FOV flag to zeros.
- */
-static void TCOD_map_clear_fov(TCOD_Map* __restrict map) {
+void TCOD_map_clear_fov(TCOD_Map* __restrict map) {
   if (!map) {
     return;
   }
@@ -161,22 +349,16 @@ static void TCOD_map_clear_fov(TCOD_Map* __restrict map) {
     map->cells[i].fov = 0;
   }
 }
-TCOD_Error TCOD_map_compute_fov(
+/**
+    Run the field-of-view algorithm `algo` on a map with already cleared fov flags.
+ */
+static TCOD_Error TCOD_map_compute_fov_dispatch(
     struct TCOD_Map* __restrict map,
     int pov_x,
     int pov_y,
     int max_radius,
     bool light_walls,
     TCOD_fov_algorithm_t algo) {
-  if (!map) {
-    TCOD_set_errorv("Map must not be NULL.");
-    return TCOD_E_INVALID_ARGUMENT;
-  }
-  if (!TCOD_map_in_bounds(map, pov_x, pov_y)) {
-    TCOD_set_errorvf("Point of view {%i, %i} is out of bounds.", pov_x, pov_y);
-    return TCOD_E_INVALID_ARGUMENT;
-  }
-  TCOD_map_clear_fov(map);
   switch (algo) {
     case FOV_BASIC:
       return TCOD_map_compute_fov_circular_raycasting(map, pov_x, pov_y, max_radius, light_walls);
@@ -202,6 +384,24 @@ TCOD_Error TCOD_map_compute_fov(
       return TCOD_E_INVALID_ARGUMENT;
   }
 }
+TCOD_Error TCOD_map_compute_fov(
+    struct TCOD_Map* __restrict map,
+    int pov_x,
+    int pov_y,
+    int max_radius,
+    bool light_walls,
+    TCOD_fov_algorithm_t algo) {
+  if (!map) {
+    TCOD_set_errorv("Map must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (!TCOD_map_in_bounds(map, pov_x, pov_y)) {
+    TCOD_set_errorvf("Point of view {%i, %i} is out of bounds.", pov_x, pov_y);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  TCOD_map_clear_fov(map);
+  return TCOD_map_compute_fov_dispatch(map, pov_x, pov_y, max_radius, light_walls, algo);
+}
 bool TCOD_map_is_in_fov(const struct TCOD_Map* map, int x, int y) {
   if (!TCOD_map_in_bounds(map, x, y)) {
     return 0;
@@ -244,3 +444,116 @@ int TCOD_map_get_nb_cells(const struct TCOD_Map* map) {
   }
   return map->nbcells;
 }
+/**
+    Make sure `visible` can hold at least `count` more cells and `spans_count` more spans.
+ */
+static TCOD_Error TCOD_fov_visible_reserve(TCOD_FOVVisible* __restrict visible, int count, int spans_count) {
+  if (visible->count + count > visible->capacity) {
+    int new_capacity = TCOD_MAX(visible->capacity * 2, 64);
+    while (new_capacity < visible->count + count) new_capacity *= 2;
+    int(*new_cells)[2] = realloc(visible->cells, sizeof(*visible->cells) * new_capacity);
+    if (!new_cells) {
+      TCOD_set_errorv("Out of memory while reallocating visible cells.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    visible->cells = new_cells;
+    visible->capacity = new_capacity;
+  }
+  if (visible->spans_count + spans_count > visible->spans_capacity) {
+    int new_capacity = TCOD_MAX(visible->spans_capacity * 2, 16);
+    while (new_capacity < visible->spans_count + spans_count) new_capacity *= 2;
+    TCOD_FOVSpan* new_spans = realloc(visible->spans, sizeof(*visible->spans) * new_capacity);
+    if (!new_spans) {
+      TCOD_set_errorv("Out of memory while reallocating visible spans.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    visible->spans = new_spans;
+    visible->spans_capacity = new_capacity;
+  }
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_map_get_fov_visible(
+    const struct TCOD_Map* __restrict map, int x, int y, int width, int height, TCOD_FOVVisible* __restrict out) {
+  if (!map || !out) {
+    TCOD_set_errorv("map and out must be non-NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  const int x_min = TCOD_MAX(x, 0);
+  const int y_min = TCOD_MAX(y, 0);
+  const int x_max = TCOD_MIN(x + width, map->width);
+  const int y_max = TCOD_MIN(y + height, map->height);
+  for (int cy = y_min; cy < y_max; ++cy) {
+    const struct TCOD_MapCell* __restrict row = &map->cells[cy * map->width];
+    int cx = x_min;
+    while (cx < x_max) {
+      if (!row[cx].fov) {
+        ++cx;
+        continue;
+      }
+      const int x_begin = cx;
+      while (cx < x_max && row[cx].fov) ++cx;
+      TCOD_Error err = TCOD_fov_visible_reserve(out, cx - x_begin, 1);
+      if (err < 0) return err;
+      out->spans[out->spans_count++] = (TCOD_FOVSpan){.y = cy, .x_begin = x_begin, .x_end = cx};
+      for (int i = x_begin; i < cx; ++i) {
+        out->cells[out->count][0] = i;
+        out->cells[out->count][1] = cy;
+        ++out->count;
+      }
+    }
+  }
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_map_compute_fov_visible(
+    struct TCOD_Map* __restrict map,
+    int pov_x,
+    int pov_y,
+    int max_radius,
+    bool light_walls,
+    TCOD_fov_algorithm_t algo,
+    TCOD_FOVVisible* __restrict out) {
+  if (!map || !out) {
+    TCOD_set_errorv("map and out must be non-NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (!TCOD_map_in_bounds(map, pov_x, pov_y)) {
+    TCOD_set_errorvf("Point of view {%i, %i} is out of bounds.", pov_x, pov_y);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  // Erase the previous view.
+  for (int i = 0; i < out->spans_count; ++i) {
+    const TCOD_FOVSpan span = out->spans[i];
+    if (span.y < 0 || span.y >= map->height) continue;
+    const int x_end = TCOD_MIN(span.x_end, map->width);
+    for (int x = TCOD_MAX(span.x_begin, 0); x < x_end; ++x) map->cells[x + span.y * map->width].fov = false;
+  }
+  TCOD_fov_visible_clear(out);
+  // Every algorithm only writes within this area.
+  int x_min = 0;
+  int y_min = 0;
+  int x_max = map->width;
+  int y_max = map->height;
+  if (max_radius > 0) {
+    x_min = TCOD_MAX(x_min, pov_x - max_radius);
+    y_min = TCOD_MAX(y_min, pov_y - max_radius);
+    x_max = TCOD_MIN(x_max, pov_x + max_radius + 1);
+    y_max = TCOD_MIN(y_max, pov_y + max_radius + 1);
+  }
+  for (int y = y_min; y < y_max; ++y) {
+    for (int x = x_min; x < x_max; ++x) map->cells[x + y * map->width].fov = false;
+  }
+  TCOD_Error err = TCOD_map_compute_fov_dispatch(map, pov_x, pov_y, max_radius, light_walls, algo);
+  if (err < 0) return err;
+  return TCOD_map_get_fov_visible(map, x_min, y_min, x_max - x_min, y_max - y_min, out);
+}
+void TCOD_fov_visible_clear(TCOD_FOVVisible* visible) {
+  if (!visible) return;
+  visible->count = 0;
+  visible->spans_count = 0;
+}
+void TCOD_fov_visible_uninit(TCOD_FOVVisible* visible) {
+  if (!visible) return;
+  free(visible->cells);
+  free(visible->spans);
+  *visible = (TCOD_FOVVisible){0};
+}
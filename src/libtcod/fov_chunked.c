@@ -0,0 +1,368 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "fov_chunked.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fov.h"
+#include "libtcod_int.h"
+#include "utility.h"
+
+#define CHUNK_CELLS (TCOD_MAP_CHUNK_SIZE * TCOD_MAP_CHUNK_SIZE)
+/// The most missing chunks remembered before they are all forgotten.
+#define MAX_MISSING_CHUNKS 4096
+/**
+    A single resident chunk of a chunked map.
+
+    A chunk which `load` had nothing for is kept as a missing chunk, which has no cells allocated.
+ */
+typedef struct MapChunk {
+  int chunk_x, chunk_y;  // The position of this chunk in chunk units.
+  uint64_t last_used;  // The tick of the last access, used to pick chunks to evict.
+  bool missing;  // True if this chunk has the map defaults and `cells` was not allocated.
+  struct TCOD_MapCell cells[];  // CHUNK_CELLS cells unless `missing` is true.
+} MapChunk;
+struct TCOD_ChunkedMap {
+  bool default_transparent;
+  bool default_walkable;
+  int max_chunks;  // Number of resident chunks before eviction, or zero.
+  TCOD_ChunkedMapCallbacks callbacks;
+  int nb_chunks;  // Number of resident chunks.
+  int nb_missing;  // Number of missing chunks in `table`.
+  int table_capacity;  // Length of `table`, always a power of two.
+  MapChunk** table;  // Open addressing hash table of resident chunks.
+  MapChunk* last_chunk;  // The most recently accessed chunk.
+  uint64_t tick;  // Incremented on each chunk access.
+  TCOD_Map* window;  // The area used by the last field-of-view computation.
+  int window_x, window_y;  // The world position of `window`.
+};
+/**
+    Return the chunk coordinate for a world coordinate, rounding towards negative infinity.
+ */
+static int to_chunk(int v) { return v >= 0 ? v / TCOD_MAP_CHUNK_SIZE : (v + 1) / TCOD_MAP_CHUNK_SIZE - 1; }
+static unsigned int hash_chunk(int chunk_x, int chunk_y) {
+  return (unsigned int)chunk_x * 0x9E3779B1u ^ (unsigned int)chunk_y * 0x85EBCA77u;
+}
+/**
+    Return the table index holding this chunk, or the empty index where it would be inserted.
+ */
+static int table_find_index(const TCOD_ChunkedMap* map, int chunk_x, int chunk_y) {
+  const unsigned int mask = (unsigned int)map->table_capacity - 1;
+  unsigned int i = hash_chunk(chunk_x, chunk_y) & mask;
+  while (map->table[i] && (map->table[i]->chunk_x != chunk_x || map->table[i]->chunk_y != chunk_y)) {
+    i = (i + 1) & mask;
+  }
+  return (int)i;
+}
+static TCOD_Error table_grow(TCOD_ChunkedMap* map) {
+  const int old_capacity = map->table_capacity;
+  MapChunk** old_table = map->table;
+  const int new_capacity = old_capacity ? old_capacity * 2 : 64;
+  MapChunk** new_table = calloc(new_capacity, sizeof(*new_table));
+  if (!new_table) {
+    TCOD_set_errorv("Out of memory while growing the chunk table.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  map->table = new_table;
+  map->table_capacity = new_capacity;
+  for (int i = 0; i < old_capacity; ++i) {
+    if (old_table[i]) map->table[table_find_index(map, old_table[i]->chunk_x, old_table[i]->chunk_y)] = old_table[i];
+  }
+  free(old_table);
+  return TCOD_E_OK;
+}
+/**
+    Remove the chunk at `index` from the table, shifting back any displaced entries.
+ */
+static void table_remove_index(TCOD_ChunkedMap* map, int index) {
+  const unsigned int mask = (unsigned int)map->table_capacity - 1;
+  unsigned int hole = (unsigned int)index;
+  unsigned int i = hole;
+  map->table[hole] = NULL;
+  while (map->table[i = (i + 1) & mask]) {
+    const unsigned int home = hash_chunk(map->table[i]->chunk_x, map->table[i]->chunk_y) & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      map->table[hole] = map->table[i];
+      map->table[i] = NULL;
+      hole = i;
+    }
+  }
+}
+/**
+    Store and free the chunk at table `index`.
+ */
+static void evict_index(TCOD_ChunkedMap* map, int index) {
+  MapChunk* chunk = map->table[index];
+  if (chunk->missing) {
+    table_remove_index(map, index);
+    --map->nb_missing;
+    free(chunk);
+    return;
+  }
+  if (map->callbacks.evict) {
+    map->callbacks.evict(map->callbacks.userdata, chunk->chunk_x, chunk->chunk_y, chunk->cells);
+  }
+  if (map->last_chunk == chunk) map->last_chunk = NULL;
+  table_remove_index(map, index);
+  --map->nb_chunks;
+  free(chunk);
+}
+static void evict_least_recently_used(TCOD_ChunkedMap* map) {
+  int oldest = -1;
+  for (int i = 0; i < map->table_capacity; ++i) {
+    if (!map->table[i] || map->table[i]->missing) continue;
+    if (oldest < 0 || map->table[i]->last_used < map->table[oldest]->last_used) oldest = i;
+  }
+  if (oldest >= 0) evict_index(map, oldest);
+}
+/**
+    Forget every missing chunk, so that they are loaded again when next accessed.
+ */
+static void forget_missing_chunks(TCOD_ChunkedMap* map) {
+  for (int i = 0; i < map->table_capacity; ++i) {
+    // Removing an entry can shift a later entry into this index, so it is checked again.
+    while (map->table[i] && map->table[i]->missing) evict_index(map, i);
+  }
+}
+/**
+    Make room in the table for one more chunk.
+ */
+static TCOD_Error table_reserve(TCOD_ChunkedMap* map) {
+  if ((map->nb_chunks + map->nb_missing + 1) * 2 <= map->table_capacity) return TCOD_E_OK;
+  return table_grow(map);
+}
+/**
+    Put the chunk at this chunk position into `chunk_out`.
+
+    If the chunk is not resident then it is loaded.
+    If there is nothing to load then a default chunk is allocated when `allocate` is true, otherwise NULL is output.
+    Chunks with nothing to load are remembered so that `load` is only called for them once.
+
+    Returns an error if memory could not be allocated, `chunk_out` is NULL in that case.
+ */
+static TCOD_Error get_chunk(TCOD_ChunkedMap* map, int chunk_x, int chunk_y, bool allocate, MapChunk** chunk_out) {
+  *chunk_out = NULL;
+  MapChunk* chunk = map->last_chunk;
+  if (!chunk || chunk->chunk_x != chunk_x || chunk->chunk_y != chunk_y) {
+    chunk = map->table_capacity ? map->table[table_find_index(map, chunk_x, chunk_y)] : NULL;
+  }
+  if (!chunk || chunk->missing) {
+    const bool was_missing = chunk != NULL;
+    if (!allocate && (was_missing || !map->callbacks.load)) return TCOD_E_OK;
+    // Everything which can fail is done before `load`, so that a loaded chunk is never lost.
+    TCOD_Error err = table_reserve(map);
+    if (err < 0) return err;
+    chunk = malloc(sizeof(*chunk) + sizeof(*chunk->cells) * CHUNK_CELLS);
+    if (!chunk) {
+      TCOD_set_errorv("Out of memory while allocating a chunk.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    chunk->chunk_x = chunk_x;
+    chunk->chunk_y = chunk_y;
+    chunk->missing = false;
+    bool loaded = false;
+    if (!was_missing && map->callbacks.load) {
+      loaded = map->callbacks.load(map->callbacks.userdata, chunk_x, chunk_y, chunk->cells);
+    }
+    if (!loaded && !allocate) {
+      // Remember that there is nothing to load here, only the chunk header is kept.
+      MapChunk* missing = realloc(chunk, sizeof(*missing));
+      if (!missing) missing = chunk;
+      missing->missing = true;
+      if (map->nb_missing >= MAX_MISSING_CHUNKS) forget_missing_chunks(map);
+      map->table[table_find_index(map, chunk_x, chunk_y)] = missing;
+      ++map->nb_missing;
+      return TCOD_E_OK;
+    }
+    if (!loaded) {
+      for (int i = 0; i < CHUNK_CELLS; ++i) {
+        chunk->cells[i] = (struct TCOD_MapCell){map->default_transparent, map->default_walkable, false};
+      }
+    }
+    if (map->max_chunks > 0 && map->nb_chunks >= map->max_chunks) evict_least_recently_used(map);
+    // Evictions move table entries, so the index is found again.
+    const int index = table_find_index(map, chunk_x, chunk_y);
+    if (map->table[index]) evict_index(map, index);  // Replaces the missing chunk.
+    map->table[table_find_index(map, chunk_x, chunk_y)] = chunk;
+    ++map->nb_chunks;
+  }
+  chunk->last_used = ++map->tick;
+  map->last_chunk = chunk;
+  *chunk_out = chunk;
+  return TCOD_E_OK;
+}
+/**
+    Return the cell at a world position, or NULL if it has default properties or could not be loaded.
+ */
+static const struct TCOD_MapCell* get_cell(TCOD_ChunkedMap* map, int x, int y) {
+  const int chunk_x = to_chunk(x);
+  const int chunk_y = to_chunk(y);
+  MapChunk* chunk;
+  if (get_chunk(map, chunk_x, chunk_y, false, &chunk) < 0 || !chunk) return NULL;
+  return &chunk->cells[(x - chunk_x * TCOD_MAP_CHUNK_SIZE) + (y - chunk_y * TCOD_MAP_CHUNK_SIZE) * TCOD_MAP_CHUNK_SIZE];
+}
+TCOD_ChunkedMap* TCOD_chunked_map_new(
+    bool transparent, bool walkable, int max_chunks, const TCOD_ChunkedMapCallbacks* callbacks) {
+  if (max_chunks < 0) {
+    TCOD_set_errorvf("max_chunks must not be negative, got %i.", max_chunks);
+    return NULL;
+  }
+  TCOD_ChunkedMap* map = calloc(1, sizeof(*map));
+  if (!map) {
+    TCOD_set_errorv("Out of memory.");
+    return NULL;
+  }
+  map->default_transparent = transparent;
+  map->default_walkable = walkable;
+  map->max_chunks = max_chunks;
+  if (callbacks) map->callbacks = *callbacks;
+  return map;
+}
+void TCOD_chunked_map_delete(TCOD_ChunkedMap* map) {
+  if (!map) return;
+  for (int i = 0; i < map->table_capacity; ++i) {
+    MapChunk* chunk = map->table[i];
+    if (!chunk) continue;
+    if (map->callbacks.evict && !chunk->missing) {
+      map->callbacks.evict(map->callbacks.userdata, chunk->chunk_x, chunk->chunk_y, chunk->cells);
+    }
+    free(chunk);
+  }
+  free(map->table);
+  TCOD_map_delete(map->window);
+  free(map);
+}
+TCOD_Error TCOD_chunked_map_set_properties(
+    TCOD_ChunkedMap* map, int x, int y, bool is_transparent, bool is_walkable) {
+  if (!map) {
+    TCOD_set_errorv("Map must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  const int chunk_x = to_chunk(x);
+  const int chunk_y = to_chunk(y);
+  MapChunk* chunk;
+  const TCOD_Error err = get_chunk(map, chunk_x, chunk_y, true, &chunk);
+  if (err < 0) return err;
+  struct TCOD_MapCell* cell =
+      &chunk->cells[(x - chunk_x * TCOD_MAP_CHUNK_SIZE) + (y - chunk_y * TCOD_MAP_CHUNK_SIZE) * TCOD_MAP_CHUNK_SIZE];
+  cell->transparent = is_transparent;
+  cell->walkable = is_walkable;
+  return TCOD_E_OK;
+}
+bool TCOD_chunked_map_is_transparent(TCOD_ChunkedMap* map, int x, int y) {
+  if (!map) return false;
+  const struct TCOD_MapCell* cell = get_cell(map, x, y);
+  return cell ? cell->transparent : map->default_transparent;
+}
+bool TCOD_chunked_map_is_walkable(TCOD_ChunkedMap* map, int x, int y) {
+  if (!map) return false;
+  const struct TCOD_MapCell* cell = get_cell(map, x, y);
+  return cell ? cell->walkable : map->default_walkable;
+}
+int TCOD_chunked_map_get_nb_chunks(const TCOD_ChunkedMap* map) { return map ? map->nb_chunks : 0; }
+void TCOD_chunked_map_evict_chunk(TCOD_ChunkedMap* map, int chunk_x, int chunk_y) {
+  if (!map || !map->table_capacity) return;
+  const int index = table_find_index(map, chunk_x, chunk_y);
+  if (map->table[index]) evict_index(map, index);
+}
+TCOD_Error TCOD_chunked_map_extract(TCOD_ChunkedMap* map, int x, int y, TCOD_Map* dest) {
+  if (!map || !dest) {
+    TCOD_set_errorv("map and dest must be non-NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  const struct TCOD_MapCell default_cell = {map->default_transparent, map->default_walkable, false};
+  const int x_end = x + dest->width;
+  const int y_end = y + dest->height;
+  for (int chunk_y = to_chunk(y); chunk_y <= to_chunk(y_end - 1); ++chunk_y) {
+    const int y_begin = TCOD_MAX(y, chunk_y * TCOD_MAP_CHUNK_SIZE);
+    const int y_stop = TCOD_MIN(y_end, (chunk_y + 1) * TCOD_MAP_CHUNK_SIZE);
+    for (int chunk_x = to_chunk(x); chunk_x <= to_chunk(x_end - 1); ++chunk_x) {
+      const int x_begin = TCOD_MAX(x, chunk_x * TCOD_MAP_CHUNK_SIZE);
+      const int x_stop = TCOD_MIN(x_end, (chunk_x + 1) * TCOD_MAP_CHUNK_SIZE);
+      MapChunk* chunk;
+      const TCOD_Error err = get_chunk(map, chunk_x, chunk_y, false, &chunk);
+      if (err < 0) return err;  // A chunk which failed to load must not be mistaken for default cells.
+      for (int cy = y_begin; cy < y_stop; ++cy) {
+        struct TCOD_MapCell* dest_row = &dest->cells[(x_begin - x) + (cy - y) * dest->width];
+        if (!chunk) {
+          for (int i = 0; i < x_stop - x_begin; ++i) dest_row[i] = default_cell;
+          continue;
+        }
+        const struct TCOD_MapCell* src_row =
+            &chunk->cells
+                 [(x_begin - chunk_x * TCOD_MAP_CHUNK_SIZE) + (cy - chunk_y * TCOD_MAP_CHUNK_SIZE) * TCOD_MAP_CHUNK_SIZE];
+        for (int i = 0; i < x_stop - x_begin; ++i) {
+          dest_row[i] = (struct TCOD_MapCell){src_row[i].transparent, src_row[i].walkable, false};
+        }
+      }
+    }
+  }
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_chunked_map_compute_fov(
+    TCOD_ChunkedMap* map, int pov_x, int pov_y, int max_radius, bool light_walls, TCOD_fov_algorithm_t algo) {
+  if (!map) {
+    TCOD_set_errorv("Map must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (max_radius <= 0) {
+    TCOD_set_errorvf("max_radius must be positive for chunked maps, got %i.", max_radius);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  const int size = max_radius * 2 + 1;
+  if (!map->window || map->window->width != size) {
+    TCOD_map_delete(map->window);
+    map->window = TCOD_map_new(size, size);
+    if (!map->window) {
+      TCOD_set_errorv("Out of memory.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+  }
+  map->window_x = pov_x - max_radius;
+  map->window_y = pov_y - max_radius;
+  TCOD_Error err = TCOD_chunked_map_extract(map, map->window_x, map->window_y, map->window);
+  if (err < 0) return err;
+  return TCOD_map_compute_fov(map->window, max_radius, max_radius, max_radius, light_walls, algo);
+}
+bool TCOD_chunked_map_is_in_fov(const TCOD_ChunkedMap* map, int x, int y) {
+  if (!map || !map->window) return false;
+  return TCOD_map_is_in_fov(map->window, x - map->window_x, y - map->window_y);
+}
+float TCOD_chunked_map_path_func(int x_from, int y_from, int x_to, int y_to, void* user_data) {
+  (void)x_from;
+  (void)y_from;
+  const TCOD_ChunkedMapRegion* region = user_data;
+  if (!region) return 0.0f;
+  return TCOD_chunked_map_is_walkable(region->map, region->x + x_to, region->y + y_to) ? 1.0f : 0.0f;
+}
@@ -0,0 +1,214 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/// @file fov_chunked.h
+/// Chunked and sparsely allocated maps for unbounded worlds.
+#pragma once
+#ifndef TCOD_FOV_CHUNKED_H_
+#define TCOD_FOV_CHUNKED_H_
+
+#include <stdbool.h>
+
+#include "config.h"
+#include "error.h"
+#include "fov_types.h"
+
+/// @addtogroup FOV
+/// @{
+/**
+    The width and height of each chunk of a TCOD_ChunkedMap.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+#define TCOD_MAP_CHUNK_SIZE 64
+/**
+    Callbacks used to stream chunks of a TCOD_ChunkedMap in and out of memory.
+
+    \rst
+    `load` is called when a chunk which is not resident is accessed.
+    It must fill `cells` which is a `TCOD_MAP_CHUNK_SIZE` by `TCOD_MAP_CHUNK_SIZE` row-major array and return true,
+    or return false if the chunk has never been stored, in which case the map defaults are used.
+    A chunk which `load` returned false for is not loaded again until it is written to or evicted with
+    TCOD_chunked_map_evict_chunk.
+
+    `evict` is called with the contents of a chunk before it is freed, so that it can be stored.
+
+    Either callback may be NULL.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_ChunkedMapCallbacks {
+  bool (*load)(void* userdata, int chunk_x, int chunk_y, struct TCOD_MapCell* cells);
+  void (*evict)(void* userdata, int chunk_x, int chunk_y, const struct TCOD_MapCell* cells);
+  void* userdata;
+} TCOD_ChunkedMapCallbacks;
+/**
+    A map of unbounded size made of fixed-size chunks which are only allocated once written to or loaded.
+
+    All attributes are considered private.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_ChunkedMap TCOD_ChunkedMap;
+/**
+    A rectangular region of a TCOD_ChunkedMap, used as `user_data` for TCOD_chunked_map_path_func.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_ChunkedMapRegion {
+  TCOD_ChunkedMap* map;
+  int x;  // The world position of the regions top-left corner.
+  int y;
+} TCOD_ChunkedMapRegion;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+    Return a new chunked map.
+
+    \rst
+    Cells of chunks which were never written or loaded have the `transparent` and `walkable` defaults.
+
+    `max_chunks` is the number of chunks kept in memory before the least recently used chunk is evicted,
+    or zero to never evict chunks.
+
+    `callbacks` may be NULL.
+
+    Returns NULL on error.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_ChunkedMap* TCOD_chunked_map_new(
+    bool transparent, bool walkable, int max_chunks, const TCOD_ChunkedMapCallbacks* callbacks);
+/**
+    Evict all resident chunks and free the map.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_chunked_map_delete(TCOD_ChunkedMap* map);
+/**
+    Change the properties of a single cell, allocating its chunk if needed.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_chunked_map_set_properties(
+    TCOD_ChunkedMap* map, int x, int y, bool is_transparent, bool is_walkable);
+/**
+    Return true if this cell is transparent.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC bool TCOD_chunked_map_is_transparent(TCOD_ChunkedMap* map, int x, int y);
+/**
+    Return true if this cell is walkable.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC bool TCOD_chunked_map_is_walkable(TCOD_ChunkedMap* map, int x, int y);
+/**
+    Return the number of chunks currently held in memory.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC int TCOD_chunked_map_get_nb_chunks(const TCOD_ChunkedMap* map);
+/**
+    Evict a single chunk if it is resident.  The evict callback is called before it is freed.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_chunked_map_evict_chunk(TCOD_ChunkedMap* map, int chunk_x, int chunk_y);
+/**
+    Copy the properties of the area starting at `x`,`y` with the size of `dest` into `dest`.
+
+    \rst
+    The fov flags of `dest` are cleared.
+    Chunks are loaded as needed but are not allocated for areas which were never written.
+
+    Returns an error code on failure, such as when a chunk could not be loaded because memory ran out.
+    `dest` may be partially written in that case.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_chunked_map_extract(TCOD_ChunkedMap* map, int x, int y, TCOD_Map* dest);
+/**
+    Calculate the field-of-view on a chunked map.
+
+    \rst
+    This takes the same parameters as :any:`TCOD_map_compute_fov`, except that `max_radius` must be positive
+    and that `pov_x` and `pov_y` may be anywhere in the world.
+    The area within `max_radius` is gathered across chunk boundaries into a reused window.
+    Check the results with :any:`TCOD_chunked_map_is_in_fov`.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_chunked_map_compute_fov(
+    TCOD_ChunkedMap* map, int pov_x, int pov_y, int max_radius, bool light_walls, TCOD_fov_algorithm_t algo);
+/**
+    Return true if this cell was touched by the last field-of-view computed on `map`.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC bool TCOD_chunked_map_is_in_fov(const TCOD_ChunkedMap* map, int x, int y);
+/**
+    A TCOD_path_func_t which reads walkability from a TCOD_ChunkedMapRegion passed as `user_data`.
+
+    \rst
+    Coordinates are relative to the region, so a pathfinder made with :any:`TCOD_path_new_using_function` or
+    :any:`TCOD_dijkstra_new_using_function` can search an area of any size across chunk boundaries.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC float TCOD_chunked_map_path_func(int x_from, int y_from, int x_to, int y_to, void* user_data);
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+/// @}
+#endif  // TCOD_FOV_CHUNKED_H_
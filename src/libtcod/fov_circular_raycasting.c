@@ -31,6 +31,7 @@
  */
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -79,6 +80,125 @@ static void cast_ray(
     map->cells[map_index].fov = true;
   }
 }
+#ifdef TCOD_THREAD_LOCAL
+enum { RAY_TABLE_MAX_RADIUS = 255 };
+/**
+    A node of a ray prefix tree, stored in pre-order.
+ */
+typedef struct RayNode {
+  int16_t dx;  // Position relative to the point-of-view.
+  int16_t dy;
+  int32_t end;  // The index after the last descendant of this node, where to go if this node is blocked.
+} RayNode;
+/**
+    The rays cast by FOV_BASIC for one radius, with common prefixes merged.
+ */
+typedef struct RayTable {
+  int count;
+  RayNode nodes[];
+} RayTable;
+/**
+    A node of the ray tree during construction.
+ */
+typedef struct RayBuildNode {
+  int16_t dx;
+  int16_t dy;
+  int first_child;
+  int next_sibling;
+} RayBuildNode;
+/// Ray tables for each radius, built on first use by each thread.
+static TCOD_THREAD_LOCAL RayTable* ray_tables[RAY_TABLE_MAX_RADIUS + 1];
+/**
+    Write the siblings starting at `child` and all of their descendants to `out` in pre-order.
+
+    Returns the next free index of `out`.
+ */
+static int ray_table_flatten(const RayBuildNode* __restrict tree, int child, RayNode* __restrict out, int index) {
+  for (; child >= 0; child = tree[child].next_sibling) {
+    const int node_index = index++;
+    out[node_index].dx = tree[child].dx;
+    out[node_index].dy = tree[child].dy;
+    index = ray_table_flatten(tree, tree[child].first_child, out, index);
+    out[node_index].end = index;
+  }
+  return index;
+}
+/**
+    Trace the rays to every cell on the perimeter of a square with this radius, merging shared steps.
+
+    Returns NULL on failure.
+ */
+static RayTable* ray_table_new(int radius) {
+  const int radius_squared = radius * radius;
+  // Each ray has `radius` steps, so this is enough for the worst case where no steps are shared.
+  const int max_nodes = 1 + 8 * (radius + 1) * radius;
+  RayBuildNode* tree = malloc(sizeof(*tree) * max_nodes);
+  if (!tree) return NULL;
+  tree[0] = (RayBuildNode){0, 0, -1, -1};  // The point-of-view.
+  int tree_count = 1;
+  for (int i = -radius; i <= radius; ++i) {
+    const int destinations[4][2] = {{i, -radius}, {i, radius}, {-radius, i}, {radius, i}};
+    for (int d = 0; d < 4; ++d) {
+      TCOD_bresenham_data_t bresenham_data;
+      int x;
+      int y;
+      int parent = 0;
+      TCOD_line_init_mt(0, 0, destinations[d][0], destinations[d][1], &bresenham_data);
+      while (!TCOD_line_step_mt(&x, &y, &bresenham_data) && x * x + y * y <= radius_squared) {
+        int child = tree[parent].first_child;
+        while (child >= 0 && (tree[child].dx != x || tree[child].dy != y)) child = tree[child].next_sibling;
+        if (child < 0) {
+          child = tree_count++;
+          tree[child] = (RayBuildNode){(int16_t)x, (int16_t)y, -1, tree[parent].first_child};
+          tree[parent].first_child = child;
+        }
+        parent = child;
+      }
+    }
+  }
+  RayTable* table = malloc(sizeof(*table) + sizeof(*table->nodes) * (tree_count - 1));
+  if (table) table->count = ray_table_flatten(tree, tree[0].first_child, table->nodes, 0);
+  free(tree);
+  return table;
+}
+/**
+    Return the cached ray table for `radius`, or NULL if it could not be built.
+ */
+static const RayTable* ray_table_get(int radius) {
+  if (!ray_tables[radius]) ray_tables[radius] = ray_table_new(radius);
+  return ray_tables[radius];
+}
+/**
+    Mark cells along the cached rays.
+
+    The tree is walked in order and the descendants of a blocking cell are skipped, so each step shared by multiple
+    rays is only tested once.
+ */
+static void cast_ray_table(
+    struct TCOD_Map* __restrict map, int pov_x, int pov_y, const RayTable* __restrict table, bool light_walls) {
+  struct TCOD_MapCell* __restrict origin = &map->cells[pov_x + pov_y * map->width];
+  const int width = map->width;
+  const RayNode* nodes = table->nodes;
+  for (int i = 0; i < table->count;) {
+    struct TCOD_MapCell* cell = &origin[nodes[i].dx + nodes[i].dy * width];
+    if (cell->transparent) {
+      cell->fov = true;
+      ++i;
+    } else {
+      if (light_walls) cell->fov = true;
+      i = nodes[i].end;  // Blocked by wall.
+    }
+  }
+}
+#endif  // TCOD_THREAD_LOCAL
+void TCOD_fov_circular_raycasting_free_tables(void) {
+#ifdef TCOD_THREAD_LOCAL
+  for (int i = 0; i <= RAY_TABLE_MAX_RADIUS; ++i) {
+    free(ray_tables[i]);
+    ray_tables[i] = NULL;
+  }
+#endif  // TCOD_THREAD_LOCAL
+}
 TCOD_Error TCOD_map_compute_fov_circular_raycasting(
     TCOD_Map* __restrict map, int pov_x, int pov_y, int max_radius, bool light_walls) {
   int x_min = 0;  // Field-of-view bounds.
@@ -97,6 +217,17 @@ TCOD_Error TCOD_map_compute_fov_circular_raycasting(
   }
   map->cells[pov_x + pov_y * map->width].fov = true;  // Mark point-of-view as visible.
 
+#ifdef TCOD_THREAD_LOCAL
+  // When the view is not clipped by the map edges the rays only depend on the radius, so use the cached rays.
+  if (0 < max_radius && max_radius <= RAY_TABLE_MAX_RADIUS && x_max - x_min == max_radius * 2 + 1 &&
+      y_max - y_min == max_radius * 2 + 1) {
+    const RayTable* table = ray_table_get(max_radius);
+    if (table) {
+      cast_ray_table(map, pov_x, pov_y, table, light_walls);
+      return light_walls ? TCOD_map_postprocess(map, pov_x, pov_y, max_radius) : TCOD_E_OK;
+    }
+  }
+#endif  // TCOD_THREAD_LOCAL
   // Cast rays along the perimeter.
   const int radius_squared = max_radius * max_radius;
   for (int x = x_min; x < x_max; ++x) {
@@ -112,7 +243,7 @@ TCOD_Error TCOD_map_compute_fov_circular_raycasting(
     cast_ray(map, pov_x, pov_y, x_min, y, radius_squared, light_walls);
   }
   if (light_walls) {
-    TCOD_map_postprocess(map, pov_x, pov_y, max_radius);
+    return TCOD_map_postprocess(map, pov_x, pov_y, max_radius);
   }
   return TCOD_E_OK;
 }
@@ -207,13 +207,11 @@ TCOD_Error TCOD_map_compute_fov_diamond_raycasting(
       .map = map,
       .pov_x = pov_x,
       .pov_y = pov_y,
-      .raymap_grid = calloc(map->nbcells, sizeof(*fov.raymap_grid)),
+      .raymap_grid = TCOD_fov_scratch_acquire(sizeof(*fov.raymap_grid) * map->nbcells),
   };
 
-  if (!fov.raymap_grid) {
-    TCOD_set_errorv("Out of memory.");
-    return TCOD_E_OUT_OF_MEMORY;
-  }
+  if (!fov.raymap_grid) return TCOD_E_OUT_OF_MEMORY;
+  memset(fov.raymap_grid, 0, sizeof(*fov.raymap_grid) * map->nbcells);
 
   // Add the origin ray tile to start the process.
   RaycastTile* current_ray = fov.perimeter_last = get_ray(&fov, 0, 0);
@@ -244,9 +242,9 @@ TCOD_Error TCOD_map_compute_fov_diamond_raycasting(
     const int map_y = pov_y + current_ray->y_relative;
     map->cells[map_x + map_y * map->width].fov = true;
   }
-  free(fov.raymap_grid);
+  TCOD_fov_scratch_release(fov.raymap_grid);
   if (light_walls) {
-    TCOD_map_postprocess(map, pov_x, pov_y, max_radius);
+    return TCOD_map_postprocess(map, pov_x, pov_y, max_radius);
   }
   return TCOD_E_OK;
 }
@@ -0,0 +1,212 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/** \file
+    Field-of-view over a stack of map layers.
+
+    Each layer is packed into bitplanes covering the area within the radius.
+    Rays are then cast from the point-of-view to every cell on the surface of the view volume using a 3D Bresenham
+    walk, and the visible bits are copied back to the fov flags of each layer.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fov.h"
+#include "libtcod_int.h"
+#include "utility.h"
+
+/**
+    Bitplanes for the area being scanned, each plane has `stride * height` words per layer.
+ */
+typedef struct LayerPlanes {
+  int width;
+  int height;
+  int stride;  // Words per row.
+  const uint64_t* __restrict transparent;
+  const uint64_t* __restrict open_floor;  // The floor of this layer lets light through to the layer below.
+  uint64_t* __restrict visible;
+  int radius_squared;  // Zero if unlimited.
+  bool light_walls;
+} LayerPlanes;
+static size_t plane_index(const LayerPlanes* planes, int x, int y, int z) {
+  return ((size_t)z * planes->height + y) * planes->stride + x / 64;
+}
+static bool plane_get(const LayerPlanes* planes, const uint64_t* plane, int x, int y, int z) {
+  return (plane[plane_index(planes, x, y, z)] >> (x % 64)) & 1;
+}
+static void plane_set(LayerPlanes* planes, uint64_t* plane, int x, int y, int z) {
+  plane[plane_index(planes, x, y, z)] |= (uint64_t)1 << (x % 64);
+}
+/**
+    Cast a ray from `{x, y, z}` to `{x + dx, y + dy, z + dz}` marking cells as visible until it is blocked.
+
+    Moving between layers requires the floor between them to be open at the column the ray moves into.
+ */
+static void cast_ray_3d(LayerPlanes* planes, int x, int y, int z, int dx, int dy, int dz) {
+  const int ax = abs(dx);
+  const int ay = abs(dy);
+  const int az = abs(dz);
+  const int sx = dx < 0 ? -1 : 1;
+  const int sy = dy < 0 ? -1 : 1;
+  const int sz = dz < 0 ? -1 : 1;
+  const int origin_x = x;
+  const int origin_y = y;
+  const int origin_z = z;
+  const int steps = TCOD_MAX(ax, TCOD_MAX(ay, az));
+  int err_x = steps / 2;
+  int err_y = steps / 2;
+  int err_z = steps / 2;
+  for (int i = 1; i <= steps; ++i) {
+    int next_z = z;
+    if ((err_x -= ax) < 0) {
+      x += sx;
+      err_x += steps;
+    }
+    if ((err_y -= ay) < 0) {
+      y += sy;
+      err_y += steps;
+    }
+    if ((err_z -= az) < 0) {
+      next_z += sz;
+      err_z += steps;
+    }
+    const int dist_x = x - origin_x;
+    const int dist_y = y - origin_y;
+    const int dist_z = next_z - origin_z;
+    if (planes->radius_squared && dist_x * dist_x + dist_y * dist_y + dist_z * dist_z > planes->radius_squared) {
+      return;  // Outside of radius.
+    }
+    if (next_z != z) {
+      // The floor which separates the two layers is the floor of the upper one.
+      if (!plane_get(planes, planes->open_floor, x, y, TCOD_MAX(z, next_z))) return;  // Blocked by a floor.
+      z = next_z;
+    }
+    if (!plane_get(planes, planes->transparent, x, y, z)) {
+      if (planes->light_walls) plane_set(planes, planes->visible, x, y, z);
+      return;  // Blocked by a wall.
+    }
+    plane_set(planes, planes->visible, x, y, z);
+  }
+}
+TCOD_Error TCOD_map_compute_fov_layers(
+    TCOD_Map* const* __restrict layers,
+    const TCOD_Map* const* __restrict floors,
+    int layer_count,
+    int pov_x,
+    int pov_y,
+    int pov_z,
+    int max_radius,
+    bool light_walls) {
+  if (!layers || layer_count <= 0) return TCOD_set_errorv("At least one layer is required.");
+  for (int z = 0; z < layer_count; ++z) {
+    const TCOD_Map* map = layers[z];
+    const TCOD_Map* floor = floors ? floors[z] : NULL;
+    if (!map) return TCOD_set_errorvf("Layer %i must not be NULL.", z);
+    if (map->width != layers[0]->width || map->height != layers[0]->height) {
+      return TCOD_set_errorvf("Layer %i does not match the size of the first layer.", z);
+    }
+    if (floor && (floor->width != map->width || floor->height != map->height)) {
+      return TCOD_set_errorvf("Floor %i does not match the size of the layers.", z);
+    }
+  }
+  if (!TCOD_map_in_bounds(layers[0], pov_x, pov_y) || pov_z < 0 || pov_z >= layer_count) {
+    return TCOD_set_errorvf("Point of view {%i, %i, %i} is out of bounds.", pov_x, pov_y, pov_z);
+  }
+  int x_min = 0;  // Field-of-view bounds.
+  int y_min = 0;
+  int z_min = 0;
+  int x_max = layers[0]->width;
+  int y_max = layers[0]->height;
+  int z_max = layer_count;
+  if (max_radius > 0) {
+    x_min = TCOD_MAX(x_min, pov_x - max_radius);
+    y_min = TCOD_MAX(y_min, pov_y - max_radius);
+    z_min = TCOD_MAX(z_min, pov_z - max_radius);
+    x_max = TCOD_MIN(x_max, pov_x + max_radius + 1);
+    y_max = TCOD_MIN(y_max, pov_y + max_radius + 1);
+    z_max = TCOD_MIN(z_max, pov_z + max_radius + 1);
+  }
+  const int width = x_max - x_min;
+  const int height = y_max - y_min;
+  const int stride = (width + 63) / 64;
+  const size_t layer_size = (size_t)stride * height;
+  const size_t volume_size = layer_size * layer_count;
+  uint64_t* scratch = TCOD_fov_scratch_acquire(sizeof(*scratch) * volume_size * 3);
+  if (!scratch) return TCOD_E_OUT_OF_MEMORY;
+  uint64_t* transparent = scratch;
+  uint64_t* open_floor = scratch + volume_size;
+  LayerPlanes planes = {
+      .width = width,
+      .height = height,
+      .stride = stride,
+      .transparent = transparent,
+      .open_floor = open_floor,
+      .visible = scratch + volume_size * 2,
+      .radius_squared = TCOD_MAX(max_radius, 0) * TCOD_MAX(max_radius, 0),
+      .light_walls = light_walls,
+  };
+  memset(planes.visible, 0, sizeof(*planes.visible) * volume_size);
+  for (int z = z_min; z < z_max; ++z) {
+    TCOD_map_pack_bits(
+        layers[z], x_min, y_min, width, height, TCOD_MAP_CELL_TRANSPARENT, &transparent[layer_size * z], NULL);
+    if (floors && floors[z] && z > 0) {
+      TCOD_map_pack_bits(
+          floors[z], x_min, y_min, width, height, TCOD_MAP_CELL_TRANSPARENT, &open_floor[layer_size * z], NULL);
+    } else {
+      memset(&open_floor[layer_size * z], 0, sizeof(*open_floor) * layer_size);  // Solid ground.
+    }
+  }
+  // Cast rays relative to the point-of-view, towards every cell on the surface of the bounding box.
+  const int px = pov_x - x_min;
+  const int py = pov_y - y_min;
+  plane_set(&planes, planes.visible, px, py, pov_z);
+  for (int z = z_min; z < z_max; ++z) {
+    const bool cap = z == z_min || z == z_max - 1;  // The top and bottom layers are fully on the surface.
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        if (!cap && y != 0 && y != height - 1 && x != 0 && x != width - 1) {
+          x = width - 2;  // Skip to the far side of this row.
+          continue;
+        }
+        cast_ray_3d(&planes, px, py, pov_z, x - px, y - py, z - pov_z);
+      }
+    }
+  }
+  for (int z = 0; z < layer_count; ++z) {
+    TCOD_map_clear_fov(layers[z]);
+    if (z >= z_min && z < z_max) {
+      TCOD_map_unpack_fov_bits(layers[z], x_min, y_min, width, height, &planes.visible[layer_size * z]);
+    }
+  }
+  TCOD_fov_scratch_release(scratch);
+  return TCOD_E_OK;
+}
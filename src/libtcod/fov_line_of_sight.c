@@ -0,0 +1,243 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bresenham.h"
+#include "fov.h"
+#include "libtcod_int.h"
+#include "utility.h"
+
+enum {
+  LOS_THREADED_MINIMUM = 4096,  // Batches smaller than this are evaluated on the calling thread.
+  LOS_RAY_NONE = -1,  // An endpoint is out of bounds, the result is false.
+  LOS_RAY_EMPTY = -2,  // No cells between the endpoints, the result is true.
+};
+/**
+    A cached ray, a slice of offsets relative to the origin of the line.
+ */
+typedef struct LOSRay {
+  int dx;
+  int dy;
+  int begin;  // Index of the first offset of this ray.
+  int length;  // Number of cells between the endpoints.
+} LOSRay;
+/**
+    The shared state of a batched line-of-sight computation.
+ */
+typedef struct LOSBatch {
+  const TCOD_Map* map;
+  const int (*endpoints)[4];
+  uint8_t* out;
+  int* pair_rays;  // The index into `rays` for each pair, or one of the LOS_RAY_ values.
+  LOSRay* rays;
+  int rays_count;
+  int rays_capacity;
+  int* table;  // Open addressing hash table of indexes into `rays`, -1 for empty slots.
+  int table_mask;
+  int32_t* offsets;  // Linear cell offsets for all rays.
+  int offsets_count;
+  int offsets_capacity;
+} LOSBatch;
+static unsigned los_hash(int dx, int dy) { return (unsigned)dx * 0x9E3779B1u ^ (unsigned)dy * 0x85EBCA77u; }
+/**
+    Grow `*buffer` to hold at least `required` items of `item_size`.
+ */
+static TCOD_Error los_reserve(void** buffer, int* capacity, int required, size_t item_size) {
+  if (required <= *capacity) return TCOD_E_OK;
+  int new_capacity = TCOD_MAX(16, *capacity);
+  while (new_capacity < required) new_capacity *= 2;
+  void* new_buffer = realloc(*buffer, (size_t)new_capacity * item_size);
+  if (!new_buffer) return TCOD_set_errorv("Out of memory.");
+  *buffer = new_buffer;
+  *capacity = new_capacity;
+  return TCOD_E_OK;
+}
+/**
+    Return the index of the ray for this displacement, tracing a new ray if it was not seen before.
+
+    Returns a negative error code on failure.
+ */
+static int los_get_ray(LOSBatch* batch, int dx, int dy) {
+  unsigned slot = los_hash(dx, dy) & (unsigned)batch->table_mask;
+  while (batch->table[slot] >= 0) {
+    const LOSRay* ray = &batch->rays[batch->table[slot]];
+    if (ray->dx == dx && ray->dy == dy) return batch->table[slot];
+    slot = (slot + 1) & (unsigned)batch->table_mask;
+  }
+  // Bresenham lines only depend on the displacement and never leave the bounding box of their endpoints,
+  // so a ray traced from the origin is valid for every pair with the same displacement.
+  const int max_length = TCOD_MAX(abs(dx), abs(dy));
+  TCOD_Error err = los_reserve(
+      (void**)&batch->offsets, &batch->offsets_capacity, batch->offsets_count + max_length, sizeof(*batch->offsets));
+  if (err < 0) return err;
+  err = los_reserve((void**)&batch->rays, &batch->rays_capacity, batch->rays_count + 1, sizeof(*batch->rays));
+  if (err < 0) return err;
+  LOSRay* ray = &batch->rays[batch->rays_count];
+  *ray = (LOSRay){dx, dy, batch->offsets_count, 0};
+  TCOD_bresenham_data_t bresenham;
+  int x = 0;
+  int y = 0;
+  TCOD_line_init_mt(0, 0, dx, dy, &bresenham);
+  while (!TCOD_line_step_mt(&x, &y, &bresenham) && (x != dx || y != dy)) {
+    batch->offsets[batch->offsets_count++] = x + y * batch->map->width;
+    ++ray->length;
+  }
+  batch->table[slot] = batch->rays_count;
+  return batch->rays_count++;
+}
+/**
+    Evaluate the pairs from `begin` to `end`.  `begin` must be a multiple of 8 so that slices write separate bytes.
+ */
+static void los_evaluate(void* userdata, int begin, int end) {
+  const LOSBatch* batch = userdata;
+  const struct TCOD_MapCell* cells = batch->map->cells;
+  memset(batch->out + begin / 8, 0, (size_t)((end + 7) / 8 - begin / 8));
+  for (int i = begin; i < end; ++i) {
+    const int ray_index = batch->pair_rays[i];
+    bool visible = ray_index == LOS_RAY_EMPTY;
+    if (ray_index >= 0) {
+      const LOSRay* ray = &batch->rays[ray_index];
+      const struct TCOD_MapCell* origin = &cells[batch->endpoints[i][0] + batch->endpoints[i][1] * batch->map->width];
+      const int32_t* offsets = &batch->offsets[ray->begin];
+      visible = true;
+      for (int j = 0; j < ray->length; ++j) {
+        if (!origin[offsets[j]].transparent) {
+          visible = false;
+          break;
+        }
+      }
+    }
+    if (visible) batch->out[i / 8] |= (uint8_t)(1u << (i % 8));
+  }
+}
+TCOD_Error TCOD_map_compute_line_of_sight(
+    const TCOD_Map* __restrict map, int count, const int (*__restrict endpoints)[4], uint8_t* __restrict out) {
+  if (!map) return TCOD_set_errorv("Map must not be NULL.");
+  if (count < 0) return TCOD_set_errorvf("Count must not be negative, got %i.", count);
+  if (count == 0) return TCOD_E_OK;
+  if (!endpoints || !out) return TCOD_set_errorv("Endpoints and output must not be NULL.");
+  LOSBatch batch = {.map = map, .endpoints = endpoints, .out = out};
+  TCOD_Error err = TCOD_E_OK;
+  int table_size = 16;
+  while (table_size < count * 2) table_size *= 2;
+  batch.table_mask = table_size - 1;
+  batch.table = malloc(sizeof(*batch.table) * (size_t)table_size);
+  batch.pair_rays = malloc(sizeof(*batch.pair_rays) * (size_t)count);
+  if (!batch.table || !batch.pair_rays) {
+    err = TCOD_set_errorv("Out of memory.");
+    goto cleanup;
+  }
+  memset(batch.table, -1, sizeof(*batch.table) * (size_t)table_size);
+  // Rays are traced serially, the pairs are then evaluated in parallel.
+  for (int i = 0; i < count; ++i) {
+    const int* pair = endpoints[i];
+    if (!TCOD_map_in_bounds(map, pair[0], pair[1]) || !TCOD_map_in_bounds(map, pair[2], pair[3])) {
+      batch.pair_rays[i] = LOS_RAY_NONE;
+      continue;
+    }
+    const int dx = pair[2] - pair[0];
+    const int dy = pair[3] - pair[1];
+    if (abs(dx) <= 1 && abs(dy) <= 1) {
+      batch.pair_rays[i] = LOS_RAY_EMPTY;
+      continue;
+    }
+    const int ray_index = los_get_ray(&batch, dx, dy);
+    if (ray_index < 0) {
+      err = (TCOD_Error)ray_index;
+      goto cleanup;
+    }
+    batch.pair_rays[i] = ray_index;
+  }
+  if (count >= LOS_THREADED_MINIMUM) {
+    TCOD_parallel_for(count, 8, los_evaluate, &batch);
+  } else {
+    los_evaluate(&batch, 0, count);
+  }
+cleanup:
+  free(batch.offsets);
+  free(batch.rays);
+  free(batch.pair_rays);
+  free(batch.table);
+  return err;
+}
+TCOD_Error TCOD_map_compute_observers(
+    const TCOD_Map* __restrict map,
+    int target_x,
+    int target_y,
+    int max_radius,
+    int count,
+    const int (*__restrict observers)[2],
+    int* __restrict out,
+    int* __restrict out_count) {
+  if (!map) return TCOD_set_errorv("Map must not be NULL.");
+  if (!TCOD_map_in_bounds(map, target_x, target_y)) {
+    return TCOD_set_errorvf("Target {%i, %i} is out of bounds.", target_x, target_y);
+  }
+  if (count < 0) return TCOD_set_errorvf("Count must not be negative, got %i.", count);
+  if (!out_count || (count && (!observers || !out))) return TCOD_set_errorv("Observers and outputs must not be NULL.");
+  *out_count = 0;
+  if (count == 0) return TCOD_E_OK;
+  // Symmetric shadowcasting gives the same result in both directions, so one view from the target is enough.
+  // It is computed on a copy of the area within the radius so that the fov flags of `map` are left alone.
+  int x_min = 0;
+  int y_min = 0;
+  int x_max = map->width;
+  int y_max = map->height;
+  if (max_radius > 0) {
+    x_min = TCOD_MAX(x_min, target_x - max_radius);
+    y_min = TCOD_MAX(y_min, target_y - max_radius);
+    x_max = TCOD_MIN(x_max, target_x + max_radius + 1);
+    y_max = TCOD_MIN(y_max, target_y + max_radius + 1);
+  }
+  TCOD_Map window = {.width = x_max - x_min, .height = y_max - y_min};
+  window.nbcells = window.width * window.height;
+  window.cells = TCOD_fov_scratch_acquire(sizeof(*window.cells) * window.nbcells);
+  if (!window.cells) return TCOD_E_OUT_OF_MEMORY;
+  for (int y = 0; y < window.height; ++y) {
+    const struct TCOD_MapCell* src = &map->cells[x_min + (y_min + y) * map->width];
+    struct TCOD_MapCell* dest = &window.cells[y * window.width];
+    for (int x = 0; x < window.width; ++x) dest[x] = (struct TCOD_MapCell){src[x].transparent, src[x].walkable, false};
+  }
+  const TCOD_Error err =
+      TCOD_map_compute_fov_symmetric_shadowcast(&window, target_x - x_min, target_y - y_min, max_radius, true);
+  if (err >= 0) {
+    for (int i = 0; i < count; ++i) {
+      const int x = observers[i][0] - x_min;
+      const int y = observers[i][1] - y_min;
+      if (TCOD_map_in_bounds(&window, x, y) && window.cells[x + y * window.width].fov) out[(*out_count)++] = i;
+    }
+  }
+  TCOD_fov_scratch_release(window.cells);
+  return err;
+}
@@ -297,17 +297,16 @@ TCOD_Error TCOD_map_compute_fov_permissive2(
   map->cells[pov_x + pov_y * map->width].fov = 1;
 
   // Preallocate views and bumps, assuming there will be no more bumps or active views than the number of map tiles.
-  View* views = malloc(map->width * map->height * sizeof(*views));
+  // These are carved from a single scratch buffer which is reused between calls.
   const int bump_cap = TCOD_MAX(map->nbcells, 16);  // maps <= 6 cells can overflow, minimum of 16 for memory safety
-  ViewBumpContainer bumps = {.data = malloc(bump_cap * sizeof(*bumps.data))};
-  ActiveViewArray active_views = {.view_ptrs = malloc(map->width * map->height * sizeof(*active_views.view_ptrs))};
-  if (!views || !bumps.data || !active_views.view_ptrs) {
-    free(bumps.data);
-    free(views);
-    free(active_views.view_ptrs);
-    TCOD_set_errorv("Out of memory.");
-    return TCOD_E_OUT_OF_MEMORY;
-  }
+  const size_t views_size = TCOD_fov_scratch_align(sizeof(View) * map->nbcells);
+  const size_t bumps_size = TCOD_fov_scratch_align(sizeof(ViewBump) * bump_cap);
+  const size_t view_ptrs_size = sizeof(View*) * map->nbcells;
+  unsigned char* scratch = TCOD_fov_scratch_acquire(views_size + bumps_size + view_ptrs_size);
+  if (!scratch) return TCOD_E_OUT_OF_MEMORY;
+  View* views = (View*)scratch;
+  ViewBumpContainer bumps = {.data = (ViewBump*)(scratch + views_size)};
+  ActiveViewArray active_views = {.view_ptrs = (View**)(scratch + views_size + bumps_size)};
   /* set the fov range */
   int min_x = pov_x;
   int max_x = map->width - pov_x - 1;
@@ -324,8 +323,6 @@ TCOD_Error TCOD_map_compute_fov_permissive2(
   check_quadrant(map, pov_x, pov_y, 1, -1, max_x, min_y, light_walls, offset, limit, views, &bumps, &active_views);
   check_quadrant(map, pov_x, pov_y, -1, -1, min_x, min_y, light_walls, offset, limit, views, &bumps, &active_views);
   check_quadrant(map, pov_x, pov_y, -1, 1, min_x, max_y, light_walls, offset, limit, views, &bumps, &active_views);
-  free(bumps.data);
-  free(views);
-  free(active_views.view_ptrs);
+  TCOD_fov_scratch_release(scratch);
   return TCOD_E_OK;
 }
@@ -34,12 +34,12 @@
 
     Based on: https://www.albertford.com/shadowcasting/
  */
-#include <float.h>
-#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "fov.h"
 #include "libtcod_int.h"
+#include "utility.h"
 /**
     Quadrant transformation matrixes.
 
@@ -51,6 +51,15 @@ static const int quadrant_table[4][4] = {
     {0, -1, -1, 0},
     {-1, 0, 0, -1},
 };
+/**
+    A slope as an exact fraction, `denominator` is always positive.
+
+    Integer fractions are used instead of floats so that results are exact and identical on every platform.
+ */
+typedef struct Slope {
+  int numerator;
+  int denominator;
+} Slope;
 /**
     Information for the current active row.
  */
@@ -58,9 +67,10 @@ typedef struct Row {
   const int pov_x;  // The origin point-of-view.
   const int pov_y;
   const int quadrant;  // The quadrant index.
+  const int max_depth;  // Rows at this depth or further are outside of the radius, or zero for no limit.
   int depth;  // The depth of this row.
-  float slope_low;
-  const float slope_high;
+  Slope slope_low;
+  const Slope slope_high;
 } Row;
 /**
     Returns true if a given floor tile can be seen symmetrically from the origin.
@@ -69,7 +79,8 @@ typedef struct Row {
     by the row’s start and end slopes. Otherwise, it returns false.
  */
 static bool is_symmetric(const Row* __restrict row, int column) {
-  return column >= row->depth * row->slope_low && column <= row->depth * row->slope_high;
+  return (int64_t)column * row->slope_low.denominator >= (int64_t)row->depth * row->slope_low.numerator &&
+         (int64_t)column * row->slope_high.denominator <= (int64_t)row->depth * row->slope_high.numerator;
 }
 /**
     Calculates new start and end slopes.
@@ -77,15 +88,23 @@ static bool is_symmetric(const Row* __restrict row, int column) {
     The line is tangent to the left edge of the current tile, so we can use a
     single slope function for both start and end slopes.
  */
-static float slope(int row_depth, int column) { return (2.0f * column - 1.0f) / (2.0f * row_depth); }
+static Slope slope(int row_depth, int column) { return (Slope){2 * column - 1, 2 * row_depth}; }
 /**
-    Round half numbers towards infinity.
+    Return `depth * slope` rounded to the nearest integer, with halves rounded away from zero.
  */
-static int round_half_up(float n) { return (int)roundf(n * (1 + FLT_EPSILON)); }
+static int round_half_up(int depth, Slope slope) {
+  const int64_t n = (int64_t)depth * slope.numerator;
+  const int64_t d = slope.denominator;
+  return n >= 0 ? (int)((2 * n + d) / (2 * d)) : -(int)((-2 * n + d) / (2 * d));
+}
 /**
-    Round half numbers towards negative infinity.
+    Return `depth * slope` rounded to the nearest integer, with halves rounded towards zero.
  */
-static int round_half_down(float n) { return (int)roundf(n * (1 - FLT_EPSILON)); }
+static int round_half_down(int depth, Slope slope) {
+  const int64_t n = (int64_t)depth * slope.numerator;
+  const int64_t d = slope.denominator;
+  return n >= 0 ? (int)((2 * n + d - 1) / (2 * d)) : -(int)((-2 * n + d - 1) / (2 * d));
+}
 /**
     Scan a row and recursively scan all of its children.
 
@@ -96,11 +115,14 @@ static void scan(TCOD_Map* __restrict map, Row* __restrict row) {
   const int xy = quadrant_table[row->quadrant][1];
   const int yx = quadrant_table[row->quadrant][2];
   const int yy = quadrant_table[row->quadrant][3];
+  if (row->max_depth > 0 && row->depth >= row->max_depth) {
+    return;  // Row->depth is out-of-range.
+  }
   if (!TCOD_map_in_bounds(map, row->pov_x + row->depth * xx, row->pov_y + row->depth * yx)) {
     return;  // Row->depth is out-of-bounds.
   }
-  const int column_min = round_half_up(row->depth * row->slope_low);
-  const int column_max = round_half_down(row->depth * row->slope_high);
+  const int column_min = round_half_up(row->depth, row->slope_low);
+  const int column_max = round_half_down(row->depth, row->slope_high);
   bool prev_tile_is_wall = false;
   for (int column = column_min; column <= column_max; ++column) {
     const int map_x = row->pov_x + row->depth * xx + column * xy;
@@ -122,6 +144,7 @@ static void scan(TCOD_Map* __restrict map, Row* __restrict row) {
           .pov_x = row->pov_x,
           .pov_y = row->pov_y,
           .quadrant = row->quadrant,
+          .max_depth = row->max_depth,
           .depth = row->depth + 1,
           .slope_low = row->slope_low,
           .slope_high = slope(row->depth, column),
@@ -153,15 +176,27 @@ TCOD_Error TCOD_map_compute_fov_symmetric_shadowcast(
         .pov_x = pov_x,
         .pov_y = pov_y,
         .quadrant = quadrant,
+        .max_depth = TCOD_MAX(max_radius, 0),
         .depth = 1,
-        .slope_low = -1.0f,
-        .slope_high = 1.0f,
+        .slope_low = {-1, 1},
+        .slope_high = {1, 1},
     };
     scan(map, &row);
   }
+  // Tiles further than max_radius on either axis were never scanned.
+  int x_min = 0;
+  int y_min = 0;
+  int x_max = map->width;
+  int y_max = map->height;
+  if (max_radius > 0) {
+    x_min = TCOD_MAX(x_min, pov_x - max_radius);
+    y_min = TCOD_MAX(y_min, pov_y - max_radius);
+    x_max = TCOD_MIN(x_max, pov_x + max_radius + 1);
+    y_max = TCOD_MIN(y_max, pov_y + max_radius + 1);
+  }
   const int radius_squared = max_radius * max_radius;
-  for (int y = 0; y < map->height; ++y) {
-    for (int x = 0; x < map->width; ++x) {
+  for (int y = y_min; y < y_max; ++y) {
+    for (int x = x_min; x < x_max; ++x) {
       int i = x + y * map->width;
       if (!light_walls && !map->cells[i].transparent) {
         map->cells[i].fov = false;
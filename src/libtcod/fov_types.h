@@ -111,5 +111,33 @@ typedef enum {
   NB_FOV_ALGORITHMS
 } TCOD_fov_algorithm_t;
 #define FOV_PERMISSIVE(x) ((TCOD_fov_algorithm_t)(FOV_PERMISSIVE_0 + (x)))
+/**
+    A horizontal run of visible cells on row `y`, covering `x_begin` up to but not including `x_end`.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_FOVSpan {
+  int y;
+  int x_begin;
+  int x_end;
+} TCOD_FOVSpan;
+/**
+    A growable list of the cells visible from a field-of-view computation.
+
+    Zero-initialize this struct before its first use and free it with TCOD_fov_visible_uninit.
+    The buffers are kept between computations and only grow to the largest view seen so far.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_FOVVisible {
+  int count;  // The number of visible cells in `cells`.
+  int capacity;  // The allocated length of `cells`.
+  int (*cells)[2];  // An array of `{x, y}` coordinates of visible cells, sorted by row.
+  int spans_count;  // The number of row spans in `spans`.
+  int spans_capacity;  // The allocated length of `spans`.
+  TCOD_FOVSpan* spans;  // Run-length encoded visible cells, sorted by row.
+} TCOD_FOVVisible;
 /// @}
 #endif /* TCOD_FOV_TYPES_H_ */
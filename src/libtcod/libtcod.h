@@ -46,10 +46,12 @@
 #include "context_init.h"
 #include "error.h"
 #include "fov.h"
+#include "fov_chunked.h"
 #include "globals.h"
 #include "heightmap.h"
 #include "image.h"
 #include "lex.h"
+#include "lighting.h"
 #include "list.h"
 #include "logging.h"
 #include "mersenne.h"
@@ -62,11 +64,13 @@
 #include "pathfinder_frontier.h"
 #include "portability.h"
 #include "random.h"
+#include "renderer_headless.h"
 #include "renderer_sdl2.h"
 #include "sdl2/event.h"
 #include "sys.h"
 #include "tileset.h"
 #include "tileset_bdf.h"
+#include "tileset_cache.h"
 #include "tileset_fallback.h"
 #include "tileset_render.h"
 #include "tileset_truetype.h"
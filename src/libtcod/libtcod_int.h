@@ -34,6 +34,9 @@
 #define TCODLIB_INT_H_
 #include <assert.h>
 #include <stdarg.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif  // _MSC_VER
 #ifdef __cplusplus
 #include <stdexcept>
 #include <string>
@@ -47,6 +50,7 @@
 #include "fov_types.h"
 #include "mersenne_types.h"
 #include "portability.h"
+#include "renderer_xterm.h"
 #include "sys.h"
 #include "tileset.h"
 
@@ -132,8 +136,22 @@ extern TCOD_internal_context_t TCOD_ctx;
 #endif
 
 /* fov internal stuff */
+/// Storage class for variables with one instance per thread, left undefined when unsupported.
+#if defined(__cplusplus)
+#define TCOD_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define TCOD_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define TCOD_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define TCOD_THREAD_LOCAL __thread
+#endif
 TCOD_Error TCOD_map_compute_fov_circular_raycasting(
     TCOD_Map* __restrict map, int pov_x, int pov_y, int max_radius, bool light_walls);
+/**
+    Free the FOV_BASIC ray tables cached by the calling thread.
+ */
+void TCOD_fov_circular_raycasting_free_tables(void);
 TCOD_Error TCOD_map_compute_fov_diamond_raycasting(
     TCOD_Map* __restrict map, int pov_x, int pov_y, int max_radius, bool light_walls);
 TCOD_Error TCOD_map_compute_fov_recursive_shadowcasting(
@@ -144,7 +162,54 @@ TCOD_Error TCOD_map_compute_fov_restrictive_shadowcasting(
     TCOD_Map* __restrict map, int pov_x, int pov_y, int max_radius, bool light_walls);
 TCOD_Error TCOD_map_compute_fov_symmetric_shadowcast(
     TCOD_Map* __restrict map, int pov_x, int pov_y, int max_radius, bool light_walls);
-TCOD_Error TCOD_map_postprocess(TCOD_Map* __restrict map, int pov_x, int pov_y, int radius);
+TCOD_NODISCARD TCOD_Error TCOD_map_postprocess(TCOD_Map* __restrict map, int pov_x, int pov_y, int radius);
+/// Flags for the fields of TCOD_MapCell, in the order they are stored.
+enum {
+  TCOD_MAP_CELL_TRANSPARENT = 1,
+  TCOD_MAP_CELL_WALKABLE = 2,
+  TCOD_MAP_CELL_FOV = 4,
+};
+/**
+    Pack the cells within a rectangle of `map` into bit rows, a bit is set if all of `fields` are set for that cell.
+
+    Row `y` of the rectangle is written to `out + y * stride`, where `stride` is `(width + 63) / 64` and column `x`
+    is bit `x % 64` of word `x / 64`.  Unused high bits of the last word of each row are zero.
+    If `opaque` is not NULL then the cells which are not transparent are written to it with the same layout.
+ */
+void TCOD_map_pack_bits(
+    const TCOD_Map* __restrict map,
+    int x0,
+    int y0,
+    int width,
+    int height,
+    int fields,
+    uint64_t* __restrict out,
+    uint64_t* __restrict opaque);
+/**
+    Reset the map FOV flag to zeros.
+ */
+void TCOD_map_clear_fov(TCOD_Map* __restrict map);
+/**
+    Set the fov flags of the cells within a rectangle of `map` from bit rows in the layout of TCOD_map_pack_bits.
+ */
+void TCOD_map_unpack_fov_bits(
+    TCOD_Map* __restrict map, int x0, int y0, int width, int height, const uint64_t* __restrict bits);
+/**
+    Return a scratch buffer of at least `size` bytes for use by a field-of-view algorithm.
+
+    The buffer belongs to the calling thread and is reused by later calls, so it only grows to the largest request.
+    It is uninitialized and must be returned with TCOD_fov_scratch_release.
+    Returns NULL and sets an error on failure.
+ */
+void* TCOD_fov_scratch_acquire(size_t size);
+/**
+    Return a buffer from TCOD_fov_scratch_acquire.
+ */
+void TCOD_fov_scratch_release(void* scratch);
+/**
+    Round `size` up so that the next sub-allocation of a scratch buffer is suitably aligned.
+ */
+static inline size_t TCOD_fov_scratch_align(size_t size) { return (size + 15) & ~(size_t)15; }
 /**
     Return true if `x` and `y` are in the boundaries of `map`.
 
@@ -154,6 +219,23 @@ static inline bool TCOD_map_in_bounds(const struct TCOD_Map* map, int x, int y)
   return map && 0 <= x && x < map->width && 0 <= y && y < map->height;
 }
 
+/**
+    A function processing the items from `begin` up to but not including `end`.
+ */
+typedef void (*TCOD_ParallelFunc)(void* userdata, int begin, int end);
+/**
+    Split `count` items into slices which are a multiple of `grain` and run `func` on them using multiple threads.
+
+    Returns once all slices are done.  Runs everything on the calling thread when threads are unavailable.
+ */
+void TCOD_parallel_for(int count, int grain, TCOD_ParallelFunc func, void* userdata);
+/**
+    Set the most threads TCOD_parallel_for may use, or 0 to use one thread per core.
+
+    For internal use.  Lets tests reach the multi-threaded path on any machine.
+ */
+TCOD_PUBLIC void TCOD_parallel_set_max_threads_(int max_threads);
+
 /* switch fullscreen mode */
 TCOD_key_t TCOD_sys_check_for_keypress(int flags);
 TCOD_key_t TCOD_sys_wait_for_keypress(bool flush);
@@ -463,6 +545,140 @@ static inline TCOD_Console* TCOD_console_validate_(const TCOD_Console* console)
 static inline bool TCOD_console_is_index_valid_(const TCOD_Console* console, int x, int y) {
   return console && 0 <= x && x < console->w && 0 <= y && y < console->h;
 }
+/**
+ *  Return the index of the lowest set bit of `bits`, which must not be zero.
+ */
+static inline int TCOD_lowest_bit_(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bits);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanForward64(&index, bits);
+  return (int)index;
+#else
+  int index = 0;
+  while (!(bits & 1)) {
+    bits >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+/**
+ *  Row change tracking for a console, see TCOD_console_set_dirty_tracking.
+ *
+ *  Versions are taken from a counter shared by every tracked console, so that a renderer can tell consoles apart
+ *  by their versions alone.
+ */
+struct TCOD_ConsoleDirty {
+  uint64_t version;  // The version given to changed rows, replaced once a renderer has seen it.
+  uint64_t* rows;  // The version of each row, from when it was last changed.
+  int rows_length;  // The length of `rows`, same as the console height.
+};
+/**
+ *  Return a new version number, this is never zero and is unique even when called from multiple threads.
+ */
+uint64_t TCOD_console_next_version_(void);
+/**
+ *  Return the row tracking of `console`, or NULL if it does not have dirty tracking.
+ */
+struct TCOD_ConsoleDirty* TCOD_console_get_dirty_(const TCOD_Console* console);
+/**
+ *  Return the row tracking of a console which is about to be drawn, or NULL if it does not have dirty tracking.
+ *
+ *  Later changes to `console` are given a new version, so that they are not mistaken for the rows drawn now.
+ */
+const struct TCOD_ConsoleDirty* TCOD_console_observe_dirty_(const TCOD_Console* console);
+/**
+ *  Record a change to row `y` of `console`.  `y` must be in bounds.
+ */
+static inline void TCOD_console_mark_row_dirty_(TCOD_Console* console, int y) {
+  struct TCOD_ConsoleDirty* dirty = TCOD_console_get_dirty_(console);
+  if (dirty) dirty->rows[y] = dirty->version;
+}
+/**
+ *  Return true if row `y` of a console is unchanged since it was drawn onto a renderer cache.
+ *
+ *  `console` is from TCOD_console_observe_dirty_ and `cache` is the tracking of the cache console, either may be NULL.
+ *  A renderer cache with dirty tracking holds the row versions of the console it last drew instead of its own.
+ */
+static inline bool TCOD_console_row_is_drawn_(
+    const struct TCOD_ConsoleDirty* console, const struct TCOD_ConsoleDirty* cache, int y) {
+  return console && cache && console->rows[y] == cache->rows[y];
+}
+/**
+ *  Record that row `y` of a console has been drawn onto a renderer cache.
+ */
+static inline void TCOD_console_row_set_drawn_(
+    const struct TCOD_ConsoleDirty* console, struct TCOD_ConsoleDirty* cache, int y) {
+  if (cache) cache->rows[y] = console ? console->rows[y] : 0;
+}
+/**
+ *  Record that row `y` of a renderer cache was not fully drawn, so that it is checked again next frame.
+ */
+static inline void TCOD_console_row_set_undrawn_(struct TCOD_ConsoleDirty* cache, int y) {
+  if (cache) cache->rows[y] = 0;  // Console row versions are never zero.
+}
+/**
+ *  A reusable byte buffer which encodes console changes as xterm escape sequences.
+ *
+ *  Tracks the terminal cursor and colors so that only the escape sequences which change them are written.
+ *  Zero-initialize this struct and call TCOD_xterm_encoder_forget_cursor_ before its first use.
+ *  Free it with TCOD_xterm_encoder_uninit_.
+ */
+struct TCOD_XtermEncoder {
+  char* buffer;  // The encoded bytes of the current frame.
+  size_t length;  // The number of bytes in `buffer`.
+  size_t capacity;  // The allocated length of `buffer`.
+  int cursor_x;  // The terminal cursor column, or -1 if unknown.
+  int cursor_y;  // The terminal cursor row, or -1 if unknown.
+  bool fg_known;  // True if the terminal foreground color is `fg`.
+  bool bg_known;  // True if the terminal background color is `bg`.
+  TCOD_ColorRGBA fg;  // In indexed color modes the palette index is stored in `r`.
+  TCOD_ColorRGBA bg;
+  TCOD_XtermColorMode color_mode;
+  bool dither;  // True if colors are dithered before being converted to palette indexes.
+  uint8_t* palette_lut;  // The palette index of each 15-bit color in indexed color modes.
+  TCOD_ConsoleTile* quantized_row;  // A row of tiles with palette indexes in place of colors.
+  int quantized_row_capacity;  // The allocated length of `quantized_row`.
+};
+/**
+ *  Free the buffers of `encoder`.
+ */
+TCOD_PUBLIC void TCOD_xterm_encoder_uninit_(struct TCOD_XtermEncoder* encoder);
+/**
+ *  Clear the buffer of `encoder` for a new frame.
+ */
+TCOD_PUBLIC void TCOD_xterm_encoder_begin_(struct TCOD_XtermEncoder* encoder);
+/**
+ *  Forget the cursor position, after it was moved by anything other than `encoder`.
+ */
+TCOD_PUBLIC void TCOD_xterm_encoder_forget_cursor_(struct TCOD_XtermEncoder* encoder);
+/**
+ *  Append `length` raw bytes from `data` to `encoder`.
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_Error TCOD_xterm_encoder_append_(
+    struct TCOD_XtermEncoder* encoder, const char* data, size_t length);
+/**
+ *  Set the color mode of `encoder`, the terminal colors are forgotten.
+ *
+ *  The cache passed to TCOD_xterm_encode_frame_ must be reset after the color mode changes.
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_Error TCOD_xterm_encoder_set_color_mode_(
+    struct TCOD_XtermEncoder* encoder, TCOD_XtermColorMode mode, bool dither);
+/**
+ *  Append the tiles of `console` which differ from `cache` to `encoder`, and then copy them into `cache`.
+ *
+ *  Only the top-left `columns` by `rows` tiles are encoded.  Both consoles must be the same size.
+ *  In indexed color modes `cache` holds palette indexes instead of colors, so that colors which convert to the same
+ *  index are not drawn again.
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_Error TCOD_xterm_encode_frame_(
+    struct TCOD_XtermEncoder* __restrict encoder,
+    const TCOD_Console* __restrict console,
+    TCOD_Console* __restrict cache,
+    int columns,
+    int rows);
 TCOD_event_t TCOD_sys_handle_mouse_event(const union SDL_Event* ev, TCOD_mouse_t* mouse);
 TCOD_event_t TCOD_sys_handle_key_event(const union SDL_Event* ev, TCOD_key_t* key);
 #ifdef __cplusplus
@@ -0,0 +1,343 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "lighting.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fov.h"
+#include "libtcod_int.h"
+#include "utility.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TCOD_LIGHTING_SSE2
+#include <emmintrin.h>
+#endif
+/**
+    The fixed-point scale of light coefficients.  Coefficients range from 0 to LIGHT_ONE.
+ */
+#define LIGHT_ONE 256
+/**
+    A light and the cached contribution it has currently added to the lightmap.
+ */
+typedef struct Light {
+  bool active;  // False for removed lights.
+  bool dirty;  // True if this light needs to be recomputed.
+  int x, y, radius;  // The requested light parameters.
+  TCOD_ColorRGB color;
+  bool applied;  // True if the cached contribution is currently added to the lightmap.
+  int box_x, box_y, box_w, box_h;  // The area of the cached contribution, clipped to the map.
+  TCOD_ColorRGB applied_color;  // The color of the cached contribution.
+  uint16_t* coef;  // Per-cell light coefficients of the cached contribution, box_w * box_h.
+  int coef_capacity;
+} Light;
+struct TCOD_Lighting {
+  const TCOD_Map* map;
+  int width, height;  // The map size when this object was created.
+  TCOD_fov_algorithm_t algo;
+  int lights_count;
+  int lights_capacity;
+  Light* lights;
+  uint32_t* accumulated;  // Three planes of red, green, and blue light, scaled by LIGHT_ONE.
+  TCOD_Map window;  // Scratch map used for each lights field-of-view.
+  int window_capacity;
+};
+TCOD_Lighting* TCOD_lighting_new(const TCOD_Map* map, TCOD_fov_algorithm_t algo) {
+  if (!map) {
+    TCOD_set_errorv("Map must not be NULL.");
+    return NULL;
+  }
+  TCOD_Lighting* lighting = calloc(1, sizeof(*lighting));
+  uint32_t* accumulated = calloc((size_t)map->nbcells * 3, sizeof(*accumulated));
+  if (!lighting || !accumulated) {
+    free(accumulated);
+    free(lighting);
+    TCOD_set_errorv("Out of memory.");
+    return NULL;
+  }
+  lighting->map = map;
+  lighting->width = map->width;
+  lighting->height = map->height;
+  lighting->algo = algo;
+  lighting->accumulated = accumulated;
+  return lighting;
+}
+void TCOD_lighting_delete(TCOD_Lighting* lighting) {
+  if (!lighting) return;
+  for (int i = 0; i < lighting->lights_count; ++i) free(lighting->lights[i].coef);
+  free(lighting->lights);
+  free(lighting->accumulated);
+  free(lighting->window.cells);
+  free(lighting);
+}
+/**
+    Return the light with this id, or NULL if it does not exist.
+ */
+static Light* get_light(TCOD_Lighting* lighting, int id) {
+  if (!lighting || id < 0 || id >= lighting->lights_count || !lighting->lights[id].active) {
+    TCOD_set_errorvf("Light id %i does not exist.", id);
+    return NULL;
+  }
+  return &lighting->lights[id];
+}
+int TCOD_lighting_add_light(TCOD_Lighting* lighting, int x, int y, int radius, TCOD_ColorRGB color) {
+  if (!lighting) {
+    TCOD_set_errorv("Lighting must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (radius <= 0) {
+    TCOD_set_errorvf("Light radius must be positive, got %i.", radius);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  int id = 0;
+  while (id < lighting->lights_count && (lighting->lights[id].active || lighting->lights[id].applied)) ++id;
+  if (id == lighting->lights_count) {
+    if (lighting->lights_count == lighting->lights_capacity) {
+      const int new_capacity = lighting->lights_capacity ? lighting->lights_capacity * 2 : 16;
+      Light* new_lights = realloc(lighting->lights, sizeof(*new_lights) * new_capacity);
+      if (!new_lights) {
+        TCOD_set_errorv("Out of memory while reallocating lights.");
+        return TCOD_E_OUT_OF_MEMORY;
+      }
+      lighting->lights = new_lights;
+      lighting->lights_capacity = new_capacity;
+    }
+    lighting->lights[lighting->lights_count++] = (Light){0};
+  }
+  Light* light = &lighting->lights[id];
+  light->active = true;
+  light->dirty = true;
+  light->x = x;
+  light->y = y;
+  light->radius = radius;
+  light->color = color;
+  return id;
+}
+TCOD_Error TCOD_lighting_update_light(TCOD_Lighting* lighting, int id, int x, int y, int radius, TCOD_ColorRGB color) {
+  Light* light = get_light(lighting, id);
+  if (!light) return TCOD_E_INVALID_ARGUMENT;
+  if (radius <= 0) {
+    TCOD_set_errorvf("Light radius must be positive, got %i.", radius);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (light->x == x && light->y == y && light->radius == radius && light->color.r == color.r &&
+      light->color.g == color.g && light->color.b == color.b) {
+    return TCOD_E_OK;  // Nothing changed.
+  }
+  light->dirty = true;
+  light->x = x;
+  light->y = y;
+  light->radius = radius;
+  light->color = color;
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_lighting_remove_light(TCOD_Lighting* lighting, int id) {
+  Light* light = get_light(lighting, id);
+  if (!light) return TCOD_E_INVALID_ARGUMENT;
+  light->active = false;
+  light->dirty = true;
+  return TCOD_E_OK;
+}
+static bool box_contains(int box_x, int box_y, int box_w, int box_h, int x, int y) {
+  return box_x <= x && x < box_x + box_w && box_y <= y && y < box_y + box_h;
+}
+void TCOD_lighting_mark_changed(TCOD_Lighting* lighting, int x, int y) {
+  if (!lighting) return;
+  for (int i = 0; i < lighting->lights_count; ++i) {
+    Light* light = &lighting->lights[i];
+    if (light->dirty || !light->active) continue;
+    const int r = light->radius;
+    if (box_contains(light->x - r, light->y - r, r * 2 + 1, r * 2 + 1, x, y) ||
+        (light->applied && box_contains(light->box_x, light->box_y, light->box_w, light->box_h, x, y))) {
+      light->dirty = true;
+    }
+  }
+}
+/**
+    Add or subtract `coef * channel` to a row of one lightmap plane.
+ */
+static void accumulate_row(
+    uint32_t* __restrict accumulated, const uint16_t* __restrict coef, int length, uint8_t channel, bool subtract) {
+  int i = 0;
+#ifdef TCOD_LIGHTING_SSE2
+  // coef is at most LIGHT_ONE, so the product of coef and channel always fits in 16 bits.
+  const __m128i channel_x8 = _mm_set1_epi16((short)channel);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= length; i += 8) {
+    const __m128i product = _mm_mullo_epi16(_mm_loadu_si128((const __m128i*)(coef + i)), channel_x8);
+    const __m128i product_lo = _mm_unpacklo_epi16(product, zero);
+    const __m128i product_hi = _mm_unpackhi_epi16(product, zero);
+    __m128i* dest = (__m128i*)(accumulated + i);
+    const __m128i lo = _mm_loadu_si128(dest);
+    const __m128i hi = _mm_loadu_si128(dest + 1);
+    if (subtract) {
+      _mm_storeu_si128(dest, _mm_sub_epi32(lo, product_lo));
+      _mm_storeu_si128(dest + 1, _mm_sub_epi32(hi, product_hi));
+    } else {
+      _mm_storeu_si128(dest, _mm_add_epi32(lo, product_lo));
+      _mm_storeu_si128(dest + 1, _mm_add_epi32(hi, product_hi));
+    }
+  }
+#endif  // TCOD_LIGHTING_SSE2
+  for (; i < length; ++i) {
+    const uint32_t product = (uint32_t)coef[i] * channel;
+    accumulated[i] = subtract ? accumulated[i] - product : accumulated[i] + product;
+  }
+}
+/**
+    Add or subtract the cached contribution of `light` to the lightmap.
+ */
+static void apply_light(TCOD_Lighting* lighting, const Light* light, bool subtract) {
+  const size_t plane_size = (size_t)lighting->width * lighting->height;
+  const uint8_t channels[3] = {light->applied_color.r, light->applied_color.g, light->applied_color.b};
+  for (int plane = 0; plane < 3; ++plane) {
+    if (!channels[plane]) continue;
+    for (int y = 0; y < light->box_h; ++y) {
+      uint32_t* row = &lighting->accumulated[plane * plane_size + light->box_x + (light->box_y + y) * lighting->width];
+      accumulate_row(row, &light->coef[y * light->box_w], light->box_w, channels[plane], subtract);
+    }
+  }
+}
+/**
+    Compute the field-of-view and light coefficients of `light`.
+ */
+static TCOD_Error compute_light(TCOD_Lighting* lighting, Light* light) {
+  const TCOD_Map* map = lighting->map;
+  const int r = light->radius;
+  const int x_min = TCOD_MAX(0, light->x - r);
+  const int y_min = TCOD_MAX(0, light->y - r);
+  const int x_max = TCOD_MIN(map->width, light->x + r + 1);
+  const int y_max = TCOD_MIN(map->height, light->y + r + 1);
+  light->box_x = x_min;
+  light->box_y = y_min;
+  light->box_w = TCOD_MAX(0, x_max - x_min);
+  light->box_h = TCOD_MAX(0, y_max - y_min);
+  light->applied_color = light->color;
+  const int box_size = light->box_w * light->box_h;
+  if (box_size == 0 || !TCOD_map_in_bounds(map, light->x, light->y)) {
+    light->box_w = light->box_h = 0;  // Lights outside of the map are not drawn.
+    return TCOD_E_OK;
+  }
+  if (box_size > light->coef_capacity) {
+    uint16_t* new_coef = realloc(light->coef, sizeof(*new_coef) * box_size);
+    if (!new_coef) {
+      TCOD_set_errorv("Out of memory while reallocating light coefficients.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    light->coef = new_coef;
+    light->coef_capacity = box_size;
+  }
+  if (box_size > lighting->window_capacity) {
+    struct TCOD_MapCell* new_cells = realloc(lighting->window.cells, sizeof(*new_cells) * box_size);
+    if (!new_cells) {
+      TCOD_set_errorv("Out of memory while reallocating the light window.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    lighting->window.cells = new_cells;
+    lighting->window_capacity = box_size;
+  }
+  TCOD_Map* window = &lighting->window;
+  window->width = light->box_w;
+  window->height = light->box_h;
+  window->nbcells = box_size;
+  for (int y = 0; y < light->box_h; ++y) {
+    const struct TCOD_MapCell* src_row = &map->cells[x_min + (y_min + y) * map->width];
+    struct TCOD_MapCell* dest_row = &window->cells[y * light->box_w];
+    for (int x = 0; x < light->box_w; ++x) dest_row[x] = (struct TCOD_MapCell){src_row[x].transparent, true, false};
+  }
+  TCOD_Error err = TCOD_map_compute_fov(window, light->x - x_min, light->y - y_min, r, true, lighting->algo);
+  if (err < 0) return err;
+  // Inverse square falloff, offset so that it reaches zero at the radius.
+  const float offset = 1.0f / (1.0f + (float)(r * r) / 20.0f);
+  const float factor = 1.0f / (1.0f - offset);
+  for (int y = 0; y < light->box_h; ++y) {
+    const int dy = y + y_min - light->y;
+    for (int x = 0; x < light->box_w; ++x) {
+      const int i = x + y * light->box_w;
+      const int dx = x + x_min - light->x;
+      const float coef = (1.0f / (1.0f + (float)(dx * dx + dy * dy) / 20.0f) - offset) * factor;
+      light->coef[i] = (window->cells[i].fov && coef > 0) ? (uint16_t)(coef * LIGHT_ONE + 0.5f) : 0;
+    }
+  }
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_lighting_compute(TCOD_Lighting* lighting) {
+  if (!lighting) {
+    TCOD_set_errorv("Lighting must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (lighting->map->width != lighting->width || lighting->map->height != lighting->height) {
+    TCOD_set_errorv("The map was resized after the lighting was created.");
+    return TCOD_E_ERROR;
+  }
+  for (int i = 0; i < lighting->lights_count; ++i) {
+    Light* light = &lighting->lights[i];
+    if (!light->dirty) continue;
+    if (light->applied) {
+      apply_light(lighting, light, true);
+      light->applied = false;
+    }
+    if (light->active) {
+      TCOD_Error err = compute_light(lighting, light);
+      if (err < 0) return err;
+      apply_light(lighting, light, false);
+      light->applied = true;
+    }
+    light->dirty = false;
+  }
+  return TCOD_E_OK;
+}
+TCOD_ColorRGB TCOD_lighting_get_color(const TCOD_Lighting* lighting, int x, int y) {
+  if (!lighting || x < 0 || y < 0 || x >= lighting->width || y >= lighting->height) return (TCOD_ColorRGB){0, 0, 0};
+  const size_t plane_size = (size_t)lighting->width * lighting->height;
+  const size_t i = x + (size_t)y * lighting->width;
+  return (TCOD_ColorRGB){
+      (uint8_t)TCOD_MIN(255, lighting->accumulated[i] / LIGHT_ONE),
+      (uint8_t)TCOD_MIN(255, lighting->accumulated[plane_size + i] / LIGHT_ONE),
+      (uint8_t)TCOD_MIN(255, lighting->accumulated[plane_size * 2 + i] / LIGHT_ONE),
+  };
+}
+void TCOD_lighting_get_lightmap(const TCOD_Lighting* lighting, TCOD_ColorRGB* out) {
+  if (!lighting || !out) return;
+  const size_t plane_size = (size_t)lighting->width * lighting->height;
+  const uint32_t* __restrict red = lighting->accumulated;
+  const uint32_t* __restrict green = red + plane_size;
+  const uint32_t* __restrict blue = green + plane_size;
+  for (size_t i = 0; i < plane_size; ++i) {
+    out[i] = (TCOD_ColorRGB){
+        (uint8_t)TCOD_MIN(255, red[i] / LIGHT_ONE),
+        (uint8_t)TCOD_MIN(255, green[i] / LIGHT_ONE),
+        (uint8_t)TCOD_MIN(255, blue[i] / LIGHT_ONE),
+    };
+  }
+}
@@ -0,0 +1,154 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/// @file lighting.h
+/// Colored lighting computed from field-of-view.
+#pragma once
+#ifndef TCOD_LIGHTING_H_
+#define TCOD_LIGHTING_H_
+
+#include <stdbool.h>
+
+#include "color.h"
+#include "config.h"
+#include "error.h"
+#include "fov_types.h"
+
+/// @addtogroup FOV
+/// @{
+/**
+    A set of colored point lights over a TCOD_Map.
+
+    \rst
+    Each light is lit by a field-of-view limited to its radius.
+    The contribution of every light is cached, so that :any:`TCOD_lighting_compute` only recomputes lights which were
+    added, changed, or removed, or whose area includes a cell passed to :any:`TCOD_lighting_mark_changed`.
+
+    All attributes are considered private.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_Lighting TCOD_Lighting;
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+    Return a new lighting state for `map`.
+
+    \rst
+    `map` is not copied and must outlive the returned object.
+    `algo` is the field-of-view algorithm used for every light.
+
+    Returns NULL on error.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_Lighting* TCOD_lighting_new(const TCOD_Map* map, TCOD_fov_algorithm_t algo);
+/**
+    Free a lighting object.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_lighting_delete(TCOD_Lighting* lighting);
+/**
+    Add a light and return its id.
+
+    \rst
+    `radius` must be positive.
+    The light intensity falls off with the distance from `x`,`y` and reaches zero at `radius`.
+
+    Returns a negative error code on failure.  See TCOD_get_error for details.
+
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC int TCOD_lighting_add_light(TCOD_Lighting* lighting, int x, int y, int radius, TCOD_ColorRGB color);
+/**
+    Change the position, radius, and color of light `id`.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error
+TCOD_lighting_update_light(TCOD_Lighting* lighting, int id, int x, int y, int radius, TCOD_ColorRGB color);
+/**
+    Remove light `id`.  Its id may be reused by a later light.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_lighting_remove_light(TCOD_Lighting* lighting, int id);
+/**
+    Notify that the transparency of the map cell at `x`,`y` has changed.
+
+    Lights which can reach this cell will be recomputed by the next call to TCOD_lighting_compute.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_lighting_mark_changed(TCOD_Lighting* lighting, int x, int y);
+/**
+    Recompute all outdated lights and update the lightmap.
+
+    Returns an error code on failure.  See TCOD_get_error for details.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_lighting_compute(TCOD_Lighting* lighting);
+/**
+    Return the accumulated light color at `x`,`y`, clamped to 255 per channel.
+
+    Returns black for out-of-bounds positions.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_ColorRGB TCOD_lighting_get_color(const TCOD_Lighting* lighting, int x, int y);
+/**
+    Write the whole lightmap to `out`, an array with one color per map cell in row-major order.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_lighting_get_lightmap(const TCOD_Lighting* lighting, TCOD_ColorRGB* out);
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+/// @}
+#endif  // TCOD_LIGHTING_H_
@@ -0,0 +1,210 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "renderer_headless.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "console_types.h"
+#include "error.h"
+#include "tileset_render.h"
+
+struct TCOD_RendererHeadless {
+  TCOD_Tileset* tileset;
+  struct TCOD_TilesetObserver* observer;
+  TCOD_Console* cache;  // The tiles drawn onto `pixels`.
+  TCOD_ColorRGBA* pixels;
+  int width;  // Pixel width of `pixels`.
+  int height;  // Pixel height of `pixels`.
+  int columns;  // Recommended console size.
+  int rows;
+};
+/**
+    Force the next frame to be drawn in full.
+ */
+static void headless_clear_cache(struct TCOD_RendererHeadless* data) {
+  if (!data->cache) return;
+  TCOD_console_delete(data->cache);
+  data->cache = NULL;
+}
+static int headless_on_tile_changed(struct TCOD_TilesetObserver* observer, int tile_id) {
+  (void)tile_id;  // Unused.
+  headless_clear_cache(observer->userdata);
+  return 0;
+}
+static int headless_on_tiles_changed(struct TCOD_TilesetObserver* observer, const uint64_t* changed, int length) {
+  (void)changed;  // Unused.
+  (void)length;  // Unused.
+  headless_clear_cache(observer->userdata);
+  return 0;
+}
+/**
+    Stop observing and release the current tileset.
+ */
+static void headless_release_tileset(struct TCOD_RendererHeadless* data) {
+  if (data->observer) {
+    TCOD_tileset_observer_delete(data->observer);
+    data->observer = NULL;
+  }
+  if (data->tileset) {
+    TCOD_tileset_delete(data->tileset);
+    data->tileset = NULL;
+  }
+}
+static TCOD_Error headless_set_tileset(struct TCOD_Context* __restrict self, TCOD_Tileset* __restrict tileset) {
+  struct TCOD_RendererHeadless* data = self->contextdata_;
+  if (!tileset) {
+    TCOD_set_errorv("Tileset must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  struct TCOD_TilesetObserver* observer = TCOD_tileset_observer_new(tileset);
+  if (!observer) {
+    TCOD_set_errorv("Could not allocate memory.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  observer->userdata = data;
+  observer->on_tile_changed = headless_on_tile_changed;
+  observer->on_tiles_changed = headless_on_tiles_changed;
+  ++tileset->ref_count;
+  headless_release_tileset(data);
+  data->tileset = tileset;
+  data->observer = observer;
+  headless_clear_cache(data);
+  return TCOD_E_OK;
+}
+static TCOD_Error headless_present(
+    struct TCOD_Context* __restrict self,
+    const struct TCOD_Console* __restrict console,
+    const struct TCOD_ViewportOptions* __restrict viewport) {
+  (void)viewport;  // Unused.
+  struct TCOD_RendererHeadless* data = self->contextdata_;
+  const int width = console->w * data->tileset->tile_width;
+  const int height = console->h * data->tileset->tile_height;
+  if (width != data->width || height != data->height) {
+    TCOD_ColorRGBA* pixels = malloc(sizeof(*pixels) * (size_t)width * (size_t)height);
+    if (!pixels && width && height) {
+      TCOD_set_errorv("Could not allocate memory.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    free(data->pixels);
+    data->pixels = pixels;
+    data->width = width;
+    data->height = height;
+    headless_clear_cache(data);
+  }
+  return TCOD_tileset_render_to_rgba(
+      data->tileset, console, &data->cache, data->pixels, width, height, width * (int)sizeof(*data->pixels));
+}
+static void headless_pixel_to_tile(struct TCOD_Context* __restrict self, double* __restrict x, double* __restrict y) {
+  const struct TCOD_RendererHeadless* data = self->contextdata_;
+  *x /= data->tileset->tile_width;
+  *y /= data->tileset->tile_height;
+}
+static TCOD_Error headless_recommended_console_size(
+    struct TCOD_Context* __restrict self, float magnification, int* __restrict columns, int* __restrict rows) {
+  (void)magnification;  // Unused.
+  const struct TCOD_RendererHeadless* data = self->contextdata_;
+  if (columns) *columns = data->columns;
+  if (rows) *rows = data->rows;
+  return TCOD_E_OK;
+}
+static TCOD_Error headless_screen_capture(
+    struct TCOD_Context* __restrict self,
+    TCOD_ColorRGBA* __restrict out_pixels,
+    int* __restrict width,
+    int* __restrict height) {
+  const struct TCOD_RendererHeadless* data = self->contextdata_;
+  if (!data->pixels) {
+    TCOD_set_errorv("Nothing to save before the first frame.");
+    *width = 0;
+    *height = 0;
+    return TCOD_E_WARN;
+  }
+  if (!out_pixels) {
+    *width = data->width;
+    *height = data->height;
+    return TCOD_E_OK;
+  }
+  if (*width != data->width || *height != data->height) {
+    TCOD_set_errorv("Width and height do not match the size of the last frame.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  memcpy(out_pixels, data->pixels, sizeof(*out_pixels) * (size_t)data->width * (size_t)data->height);
+  return TCOD_E_OK;
+}
+static void headless_destructor(struct TCOD_Context* __restrict self) {
+  struct TCOD_RendererHeadless* data = self->contextdata_;
+  if (!data) return;
+  headless_clear_cache(data);
+  headless_release_tileset(data);
+  free(data->pixels);
+  free(data);
+  self->contextdata_ = NULL;
+}
+TCOD_Context* TCOD_renderer_init_headless(int columns, int rows, TCOD_Tileset* tileset) {
+  if (!tileset) {
+    TCOD_set_errorv("Tileset must not be NULL.");
+    return NULL;
+  }
+  TCOD_Context* context = TCOD_context_new_();
+  if (!context) return NULL;
+  context->type = TCOD_RENDERER_HEADLESS;
+  struct TCOD_RendererHeadless* data = context->contextdata_ = calloc(1, sizeof(*data));
+  if (!data) {
+    TCOD_context_delete(context);
+    TCOD_set_errorv("Could not allocate memory.");
+    return NULL;
+  }
+  data->columns = columns > 0 ? columns : 80;
+  data->rows = rows > 0 ? rows : 24;
+  context->c_destructor_ = headless_destructor;
+  context->c_present_ = headless_present;
+  context->c_pixel_to_tile_ = headless_pixel_to_tile;
+  context->c_set_tileset_ = headless_set_tileset;
+  context->c_recommended_console_size_ = headless_recommended_console_size;
+  context->c_screen_capture_ = headless_screen_capture;
+  if (headless_set_tileset(context, tileset) < 0) {
+    TCOD_context_delete(context);
+    return NULL;
+  }
+  return context;
+}
+const TCOD_ColorRGBA* TCOD_context_headless_get_pixels(struct TCOD_Context* context, int* width, int* height) {
+  if (!context || context->type != TCOD_RENDERER_HEADLESS) {
+    TCOD_set_errorv("Context must be a headless context.");
+    return NULL;
+  }
+  const struct TCOD_RendererHeadless* data = context->contextdata_;
+  if (width) *width = data->width;
+  if (height) *height = data->height;
+  return data->pixels;
+}
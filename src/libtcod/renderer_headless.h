@@ -0,0 +1,77 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/// @file renderer_headless.h
+/// A software renderer which draws into memory without a window.
+#pragma once
+#ifndef LIBTCOD_RENDERER_HEADLESS_H_
+#define LIBTCOD_RENDERER_HEADLESS_H_
+#include "config.h"
+#include "context.h"
+#include "tileset.h"
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+/**
+    Return a new context which renders consoles into an RGBA image in memory.
+
+    This renderer does not need SDL or a display and is meant for servers which generate thumbnails or stream frames.
+    Each TCOD_context_present renders the console with `tileset` using TCOD_tileset_render_to_rgba.  Only tiles which
+    changed since the previous frame are drawn again.  The viewport options are ignored, the image is always the
+    console size times the tile size.
+
+    `columns` and `rows` are the console size returned by TCOD_context_recommended_console_size.
+
+    Read the frame with TCOD_context_headless_get_pixels or TCOD_context_screen_capture.  This context has no events.
+
+    Returns NULL on an error, check `TCOD_get_error`.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_Context* TCOD_renderer_init_headless(int columns, int rows, TCOD_Tileset* tileset);
+/**
+    Return the last frame of a headless context without copying it.
+
+    `width` and `height` are set to the image size, which is zero before the first frame.
+    The rows of the image are tightly packed.  The image is valid until the next call to TCOD_context_present.
+
+    Returns NULL before the first frame, or if `context` is not a headless context.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC const TCOD_ColorRGBA* TCOD_context_headless_get_pixels(
+    struct TCOD_Context* context, int* width, int* height);
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+#endif  // LIBTCOD_RENDERER_HEADLESS_H_
@@ -37,32 +37,49 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "libtcod_int.h"
 #include "logging.h"
+#include "utility.h"
 
-#define BUFFER_TILES_MAX 10922  // Max number of tiles to buffer. (65536 / 6) to fit indices in a uint16_t type.
-/// Vertex element with position and color data.  Position uses pixel coordinates.
-typedef struct VertexElement {
+/// Vertex position in pixel coordinates.
+typedef struct VertexXY {
   float x;
   float y;
-  SDL_FColor rgba;
-} VertexElement;
+} VertexXY;
 /// Vertex normalize UV coords.
 typedef struct VertexUV {
   float u;
   float v;
 } VertexUV;
-/// A fixed-size dynamic buffer for vertex data.
-/// Vertices are ordered: upper-left, lower-left, upper-right, lower-right.
-typedef struct VertexBuffer {
-  int16_t index;  // Next tile to assign to.  Groups indicies in sets of 6 and vertices in sets of 4.
-  int16_t indices_initialized;  // Sets of indicies initialized.
-  uint16_t indices[BUFFER_TILES_MAX * 6];  // Vertex indices.  Vertex quads are assigned as: 0 1 2, 2 1 3.
-  VertexElement vertex[BUFFER_TILES_MAX * 4];
-  VertexUV vertex_uv[BUFFER_TILES_MAX * 4];
-} VertexBuffer;
-
+/// Vertex data for every tile of a console which is kept between frames.
+/// Tile `i` owns vertices `i * 4` to `i * 4 + 3` ordered: upper-left, lower-left, upper-right, lower-right.
+/// Only the colors and UVs of changed tiles are updated, and only changed tiles are indexed when drawing.
+struct TCOD_SDL2TileMesh {
+  int columns;  // Console size this mesh was built for.
+  int rows;
+  int tile_width;  // Tile size this mesh was built for.
+  int tile_height;
+  VertexXY* xy;  // Tile positions, only written when the mesh is resized.
+  SDL_FColor* bg_rgba;  // Background colors.
+  SDL_FColor* fg_rgba;  // Foreground colors.
+  VertexUV* uv;  // Foreground glyph texture coordinates.
+  int* glyph;  // Tile id and then atlas slot of the glyph of each tile drawn this frame.
+  uint32_t* bg_indices;  // Background quads to draw this frame.  Quads are assigned as: 0 1 2, 2 1 3.
+  uint32_t* fg_indices;  // Foreground quads to draw this frame.
+};
+/// Free the arrays of a tile mesh, but not the mesh itself.
+static void tile_mesh_clear(struct TCOD_SDL2TileMesh* __restrict mesh) {
+  free(mesh->xy);
+  free(mesh->bg_rgba);
+  free(mesh->fg_rgba);
+  free(mesh->uv);
+  free(mesh->glyph);
+  free(mesh->bg_indices);
+  free(mesh->fg_indices);
+  *mesh = (struct TCOD_SDL2TileMesh){0};
+}
 static float minf(float a, float b) { return a < b ? a : b; }
 static float maxf(float a, float b) { return a > b ? a : b; }
 static float clampf(float v, float low, float high) { return maxf(low, minf(v, high)); }
@@ -75,77 +92,241 @@ static SDL_Rect get_aligned_tile(const struct TCOD_Tileset* __restrict tileset,
   SDL_Rect tile_rect = {x * tileset->tile_width, y * tileset->tile_height, tileset->tile_width, tileset->tile_height};
   return tile_rect;
 }
-/// Return the rectangle for the tile at `tile_id`.
-static SDL_Rect get_sdl2_atlas_tile(const struct TCOD_TilesetAtlasSDL2* __restrict atlas, int tile_id) {
-  return get_aligned_tile(atlas->tileset, tile_id % atlas->texture_columns, tile_id / atlas->texture_columns);
+/// A glyph slot of an atlas texture.
+struct GlyphSlot {
+  int tile_id;  // The tile in this slot, or -1 if this slot is free.
+  int prev;  // The next more recently used slot, or -1.
+  int next;  // The next less recently used slot, or -1.
+  uint32_t used_frame;  // The last frame which drew this glyph.
+  bool pending;  // True if this slot is waiting to be uploaded.
+};
+/// Glyphs are packed into an atlas texture on first use and the least recently used glyphs are evicted when full.
+/// Every slot is in one recency list with free slots at the tail, so free slots are used before evicting glyphs.
+struct TCOD_SDL2GlyphCache {
+  int slots_count;  // Number of slots which fit in the atlas texture.
+  struct GlyphSlot* slots;
+  int head;  // The most recently used slot.
+  int tail;  // The least recently used slot.
+  int tiles_length;  // Length of `slot_of`.
+  int* slot_of;  // The slot of each tile, or -1 if the tile is not in the atlas.
+  int pending_count;  // Number of slots in `pending`.
+  int* pending;  // Slots which need to be uploaded before drawing.
+  TCOD_ColorRGBA* staging;  // Pixels of a row of slots being uploaded.
+  int texture_size;  // Pixel width and height of the atlas texture.
+  int max_texture_size;  // The largest texture the renderer supports.
+  uint32_t frame;  // Incremented for every rendered frame, glyphs used in the current frame are never evicted.
+};
+/// Free a glyph cache and its arrays.
+static void glyph_cache_delete(struct TCOD_SDL2GlyphCache* __restrict cache) {
+  if (!cache) return;
+  free(cache->slots);
+  free(cache->slot_of);
+  free(cache->pending);
+  free(cache->staging);
+  free(cache);
+}
+/// Return the rectangle for the glyph in `slot`.
+static SDL_Rect get_sdl2_atlas_tile(const struct TCOD_TilesetAtlasSDL2* __restrict atlas, int slot) {
+  return get_aligned_tile(atlas->tileset, slot % atlas->texture_columns, slot / atlas->texture_columns);
+}
+/// Unlink `slot` from the recency list.
+static void glyph_slot_unlink(struct TCOD_SDL2GlyphCache* __restrict cache, int slot) {
+  struct GlyphSlot* it = &cache->slots[slot];
+  if (it->prev >= 0) {
+    cache->slots[it->prev].next = it->next;
+  } else {
+    cache->head = it->next;
+  }
+  if (it->next >= 0) {
+    cache->slots[it->next].prev = it->prev;
+  } else {
+    cache->tail = it->prev;
+  }
+  it->prev = it->next = -1;
+}
+/// Link `slot` to the head of the recency list as the most recently used slot.
+static void glyph_slot_push_head(struct TCOD_SDL2GlyphCache* __restrict cache, int slot) {
+  cache->slots[slot].next = cache->head;
+  if (cache->head >= 0) {
+    cache->slots[cache->head].prev = slot;
+  } else {
+    cache->tail = slot;
+  }
+  cache->head = slot;
+}
+/// Link `slot` to the tail of the recency list so that it is reused first.
+static void glyph_slot_push_tail(struct TCOD_SDL2GlyphCache* __restrict cache, int slot) {
+  cache->slots[slot].prev = cache->tail;
+  if (cache->tail >= 0) {
+    cache->slots[cache->tail].next = slot;
+  } else {
+    cache->head = slot;
+  }
+  cache->tail = slot;
+}
+/// Queue `slot` to be uploaded before the next draw.
+static void glyph_slot_mark_pending(struct TCOD_SDL2GlyphCache* __restrict cache, int slot) {
+  if (cache->slots[slot].pending) return;
+  cache->slots[slot].pending = true;
+  cache->pending[cache->pending_count++] = slot;
 }
 /**
- *  Upload a single tile to the atlas texture.
+ *  Replace the atlas texture with one `size` pixels wide and tall.
+ *
+ *  Existing glyphs keep their slots but move to new positions, so they are all queued to be uploaded again.
  */
-static int update_sdl2_tile(struct TCOD_TilesetAtlasSDL2* __restrict atlas, int tile_id) {
-  const SDL_Rect dest = get_sdl2_atlas_tile(atlas, tile_id);
-  return SDL_UpdateTexture(
-      atlas->texture,
-      &dest,
-      atlas->tileset->pixels + (tile_id * atlas->tileset->tile_length),
-      atlas->tileset->tile_width * sizeof(*atlas->tileset->pixels));
+TCOD_NODISCARD
+static TCOD_Error resize_sdl2_atlas(struct TCOD_TilesetAtlasSDL2* __restrict atlas, int size) {
+  struct TCOD_SDL2GlyphCache* cache = atlas->glyphs;
+  const int columns = TCOD_MAX(1, size / TCOD_MAX(1, atlas->tileset->tile_width));
+  const int rows = TCOD_MAX(1, size / TCOD_MAX(1, atlas->tileset->tile_height));
+  const int new_count = columns * rows;
+  if (new_count > cache->slots_count) {
+    struct GlyphSlot* slots = realloc(cache->slots, sizeof(*slots) * new_count);
+    if (!slots) return TCOD_set_errorv("Could not allocate memory.");
+    cache->slots = slots;
+    int* pending = realloc(cache->pending, sizeof(*pending) * new_count);
+    if (!pending) return TCOD_set_errorv("Could not allocate memory.");
+    cache->pending = pending;
+  }
+  TCOD_ColorRGBA* staging =
+      realloc(cache->staging, sizeof(*staging) * size * TCOD_MAX(1, atlas->tileset->tile_height));
+  if (!staging) return TCOD_set_errorv("Could not allocate memory.");
+  cache->staging = staging;
+  SDL_Texture* texture =
+      SDL_CreateTexture(atlas->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, size, size);
+  if (!texture) return TCOD_set_errorvf("Could not create the atlas texture: %s", SDL_GetError());
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  TCOD_log_debug_f("Creating tileset atlas of pixel size %dx%d.", size, size);
+  if (atlas->texture) SDL_DestroyTexture(atlas->texture);
+  atlas->texture = texture;
+  atlas->texture_columns = columns;
+  cache->texture_size = size;
+  for (int slot = cache->slots_count; slot < new_count; ++slot) {
+    cache->slots[slot] = (struct GlyphSlot){.tile_id = -1, .prev = -1, .next = -1};
+    glyph_slot_push_tail(cache, slot);
+  }
+  cache->slots_count = new_count;
+  for (int slot = 0; slot < cache->slots_count; ++slot) {
+    if (cache->slots[slot].tile_id >= 0) glyph_slot_mark_pending(cache, slot);
+  }
+  return TCOD_E_OK;
 }
 /**
- *  Setup a atlas texture and upload the tileset graphics.
+ *  Return the atlas slot holding `tile_id`, packing the tile into the atlas if needed.
+ *
+ *  The least recently used glyph is evicted when the atlas is full, glyphs used in the current frame are kept and
+ *  the atlas grows instead.  Returns -1 if the glyph does not fit.
  */
-static int prepare_sdl2_atlas(struct TCOD_TilesetAtlasSDL2* atlas) {
-  if (!atlas) {
-    return -1;
-  }
-  int current_size = 0;
-  if (atlas->texture) {
-    float current_size_f = 0;
-    SDL_GetTextureSize(atlas->texture, &current_size_f, NULL);
-    current_size = (int)current_size_f;
-  }
-  int new_size = current_size ? current_size : 256;
-  int columns = 1;  // Must be more than zero.
-  int rows = 1;
-  while (1) {
-    if (atlas->tileset->tile_width == 0 || atlas->tileset->tile_height == 0) {
-      break;  // Avoid division by zero.
-    }
-    columns = new_size / atlas->tileset->tile_width;
-    rows = new_size / atlas->tileset->tile_height;
-    if (rows * columns >= atlas->tileset->tiles_capacity) {
-      break;
+static int acquire_sdl2_atlas_tile(struct TCOD_TilesetAtlasSDL2* __restrict atlas, int tile_id) {
+  struct TCOD_SDL2GlyphCache* cache = atlas->glyphs;
+  if (tile_id < 0 || tile_id >= atlas->tileset->tiles_count) return -1;
+  if (tile_id >= cache->tiles_length) {
+    const int new_length = TCOD_MAX(atlas->tileset->tiles_count, cache->tiles_length * 2);
+    int* slot_of = realloc(cache->slot_of, sizeof(*slot_of) * new_length);
+    if (!slot_of) return -1;
+    for (int i = cache->tiles_length; i < new_length; ++i) slot_of[i] = -1;
+    cache->slot_of = slot_of;
+    cache->tiles_length = new_length;
+  }
+  int slot = cache->slot_of[tile_id];
+  if (slot < 0) {
+    slot = cache->tail;
+    if (slot < 0 || (cache->slots[slot].tile_id >= 0 && cache->slots[slot].used_frame == cache->frame)) {
+      // Every glyph is in use by this frame.
+      if (cache->texture_size * 2 > cache->max_texture_size) return -1;
+      if (resize_sdl2_atlas(atlas, cache->texture_size * 2) < 0) return -1;
+      slot = cache->tail;
     }
-    new_size *= 2;
+    if (cache->slots[slot].tile_id >= 0) cache->slot_of[cache->slots[slot].tile_id] = -1;  // Evict this glyph.
+    cache->slots[slot].tile_id = tile_id;
+    cache->slot_of[tile_id] = slot;
+    glyph_slot_mark_pending(cache, slot);
   }
-  if (new_size != current_size) {
-    if (atlas->texture) {
-      SDL_DestroyTexture(atlas->texture);
-    }
-    TCOD_log_debug_f("Creating tileset atlas of pixel size %dx%d.", new_size, new_size);
-    atlas->texture =
-        SDL_CreateTexture(atlas->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, new_size, new_size);
-    if (!atlas->texture) {
-      return -1;
+  cache->slots[slot].used_frame = cache->frame;
+  if (cache->head != slot) {
+    glyph_slot_unlink(cache, slot);
+    glyph_slot_push_head(cache, slot);
+  }
+  return slot;
+}
+static int compare_ints(const void* a, const void* b) { return *(const int*)a - *(const int*)b; }
+/**
+ *  Upload all pending glyphs.  Glyphs in the same atlas row are uploaded together as one region.
+ *
+ *  Slots between pending glyphs of a row are staged again with their current glyph so that a batch of changes
+ *  takes one upload per row instead of one per glyph.
+ */
+static void flush_sdl2_atlas_uploads(struct TCOD_TilesetAtlasSDL2* __restrict atlas) {
+  struct TCOD_SDL2GlyphCache* cache = atlas->glyphs;
+  if (!cache->pending_count) return;
+  const TCOD_Tileset* tileset = atlas->tileset;
+  qsort(cache->pending, cache->pending_count, sizeof(*cache->pending), compare_ints);
+  for (int begin = 0; begin < cache->pending_count;) {
+    const int first_slot = cache->pending[begin];
+    const int row = first_slot / atlas->texture_columns;
+    int end = begin + 1;
+    while (end < cache->pending_count && cache->pending[end] / atlas->texture_columns == row) {
+      ++end;
     }
-    atlas->texture_columns = columns;
-    for (int i = 0; i < atlas->tileset->tiles_count; ++i) {
-      if (update_sdl2_tile(atlas, i) < 0) {
-        return -1;  // Issue with SDL_UpdateTexture.
+    const int run = cache->pending[end - 1] - first_slot + 1;
+    const int run_width = run * tileset->tile_width;
+    for (int i = 0; i < run; ++i) {
+      const int tile_id = cache->slots[first_slot + i].tile_id;
+      cache->slots[first_slot + i].pending = false;
+      if (tile_id < 0) {
+        for (int y = 0; y < tileset->tile_height; ++y) {
+          TCOD_ColorRGBA* dest = cache->staging + y * run_width + i * tileset->tile_width;
+          memset(dest, 0, sizeof(*dest) * tileset->tile_width);
+        }
+        continue;  // Free slots between glyphs are cleared.
+      }
+      // Alpha-only tiles are expanded to white pixels as they are staged.
+      const unsigned char* alpha = TCOD_tileset_get_tile_alpha_(tileset, tile_id);
+      const TCOD_ColorRGBA* src = alpha ? NULL : TCOD_tileset_get_tile_pixels_(tileset, tile_id);
+      for (int y = 0; y < tileset->tile_height; ++y) {
+        TCOD_ColorRGBA* dest = cache->staging + y * run_width + i * tileset->tile_width;
+        if (alpha) {
+          for (int x = 0; x < tileset->tile_width; ++x) {
+            dest[x] = (TCOD_ColorRGBA){255, 255, 255, alpha[y * tileset->tile_width + x]};
+          }
+        } else if (src) {
+          memcpy(dest, src + y * tileset->tile_width, sizeof(*src) * tileset->tile_width);
+        }
       }
     }
-    return 1;  // Atlas texture has been resized and refreshed.
+    SDL_Rect dest = get_sdl2_atlas_tile(atlas, first_slot);
+    dest.w = run_width;
+    SDL_UpdateTexture(atlas->texture, &dest, cache->staging, run_width * (int)sizeof(*cache->staging));
+    begin = end;
   }
-  return 0;  // No action.
+  cache->pending_count = 0;
 }
 /**
- *  Respond to changes in a tileset.
+ *  Respond to changes in a tileset.  Changed glyphs are uploaded again if they are in the atlas.
  */
 static int sdl2_atlas_on_tile_changed(struct TCOD_TilesetObserver* observer, int tile_id) {
   struct TCOD_TilesetAtlasSDL2* atlas = observer->userdata;
-  if (prepare_sdl2_atlas(atlas) == 1) {
-    return 0;  // Tile updated as a side-effect of prepare_sdl2_atlas.
+  struct TCOD_SDL2GlyphCache* cache = atlas->glyphs;
+  if (tile_id < 0 || tile_id >= cache->tiles_length || cache->slot_of[tile_id] < 0) return 0;
+  glyph_slot_mark_pending(cache, cache->slot_of[tile_id]);
+  return 0;
+}
+/**
+ *  Respond to a batch of changes in a tileset.  Changed glyphs in the atlas are all uploaded by the next flush.
+ */
+static int sdl2_atlas_on_tiles_changed(struct TCOD_TilesetObserver* observer, const uint64_t* changed, int length) {
+  struct TCOD_TilesetAtlasSDL2* atlas = observer->userdata;
+  struct TCOD_SDL2GlyphCache* cache = atlas->glyphs;
+  length = TCOD_MIN(length, (cache->tiles_length + 63) / 64);
+  for (int word = 0; word < length; ++word) {
+    for (uint64_t bits = changed[word]; bits; bits &= bits - 1) {
+      const int tile_id = word * 64 + TCOD_lowest_bit_(bits);
+      if (tile_id >= cache->tiles_length || cache->slot_of[tile_id] < 0) continue;
+      glyph_slot_mark_pending(cache, cache->slot_of[tile_id]);
+    }
   }
-  return update_sdl2_tile(atlas, tile_id);
+  return 0;
 }
 struct TCOD_TilesetAtlasSDL2* TCOD_sdl2_atlas_new(struct SDL_Renderer* renderer, struct TCOD_Tileset* tileset) {
   if (!renderer || !tileset) {
@@ -155,8 +336,10 @@ struct TCOD_TilesetAtlasSDL2* TCOD_sdl2_atlas_new(struct SDL_Renderer* renderer,
   if (!atlas) {
     return NULL;
   }
+  atlas->mesh = calloc(1, sizeof(*atlas->mesh));
+  atlas->glyphs = calloc(1, sizeof(*atlas->glyphs));
   atlas->observer = TCOD_tileset_observer_new(tileset);
-  if (!atlas->observer) {
+  if (!atlas->mesh || !atlas->glyphs || !atlas->observer) {
     TCOD_sdl2_atlas_delete(atlas);
     return NULL;
   }
@@ -165,7 +348,18 @@ struct TCOD_TilesetAtlasSDL2* TCOD_sdl2_atlas_new(struct SDL_Renderer* renderer,
   atlas->tileset->ref_count += 1;
   atlas->observer->userdata = atlas;
   atlas->observer->on_tile_changed = sdl2_atlas_on_tile_changed;
-  prepare_sdl2_atlas(atlas);
+  atlas->observer->on_tiles_changed = sdl2_atlas_on_tiles_changed;
+  // Start small, the atlas grows only when a frame uses more glyphs than fit.
+  atlas->glyphs->head = atlas->glyphs->tail = -1;
+  atlas->glyphs->max_texture_size = (int)SDL_GetNumberProperty(
+      SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 4096);
+  int size = 256;
+  while (size < tileset->tile_width || size < tileset->tile_height) size *= 2;
+  atlas->glyphs->max_texture_size = TCOD_MAX(atlas->glyphs->max_texture_size, size);
+  if (resize_sdl2_atlas(atlas, size) < 0) {
+    TCOD_sdl2_atlas_delete(atlas);
+    return NULL;
+  }
   return atlas;
 }
 void TCOD_sdl2_atlas_delete(struct TCOD_TilesetAtlasSDL2* atlas) {
@@ -181,6 +375,11 @@ void TCOD_sdl2_atlas_delete(struct TCOD_TilesetAtlasSDL2* atlas) {
   if (atlas->texture) {
     SDL_DestroyTexture(atlas->texture);
   }
+  if (atlas->mesh) {
+    tile_mesh_clear(atlas->mesh);
+    free(atlas->mesh);
+  }
+  glyph_cache_delete(atlas->glyphs);
   free(atlas);
 }
 /**
@@ -188,18 +387,28 @@ void TCOD_sdl2_atlas_delete(struct TCOD_TilesetAtlasSDL2* atlas) {
  */
 static int cache_console_update(struct TCOD_TilesetObserver* observer, int tile_id) {
   struct TCOD_Console* console = observer->userdata;
-  for (int c = 0; c < observer->tileset->character_map_length; ++c) {
-    // Find codepoints that point to the tile_id.
-    if (observer->tileset->character_map[c] != tile_id) {
+  for (int i = 0; i < console->elements; ++i) {
+    // Reset cached characters which point to the tile_id.
+    if (TCOD_tileset_get_tile_id(observer->tileset, console->tiles[i].ch) != tile_id) {
       continue;
     }
-    for (int i = 0; i < console->elements; ++i) {
-      // Compare matched codepoints to the cache console characters.
-      if (console->tiles[i].ch != c) {
-        continue;
-      }
-      console->tiles[i].ch = -1;
+    console->tiles[i].ch = -1;
+    TCOD_console_mark_row_dirty_(console, i / console->w);
+  }
+  return 0;
+}
+/**
+ *  Update a cache console by resetting tiles which point to any of the changed tiles of a batch.
+ */
+static int cache_console_update_batch(struct TCOD_TilesetObserver* observer, const uint64_t* changed, int length) {
+  struct TCOD_Console* console = observer->userdata;
+  for (int i = 0; i < console->elements; ++i) {
+    const int tile_id = TCOD_tileset_get_tile_id(observer->tileset, console->tiles[i].ch);
+    if (tile_id < 0 || tile_id / 64 >= length || !((changed[tile_id / 64] >> (tile_id % 64)) & 1)) {
+      continue;
     }
+    console->tiles[i].ch = -1;
+    TCOD_console_mark_row_dirty_(console, i / console->w);
   }
   return 0;
 }
@@ -256,143 +465,112 @@ static TCOD_Error setup_cache_console(
     observer->userdata = *cache;
     (*cache)->userdata = observer;
     observer->on_tile_changed = cache_console_update;
+    observer->on_tiles_changed = cache_console_update_batch;
     (*cache)->on_delete = cache_console_on_delete;
     observer->on_observer_delete = cache_console_observer_delete;
     for (int i = 0; i < (*cache)->elements; ++i) {
       (*cache)->tiles[i].ch = -1;
     }
+    // Tracks which rows of the rendered console are already drawn, skipping is disabled if this fails.
+    (void)TCOD_console_set_dirty_tracking(*cache, true);
   }
   return TCOD_E_OK;
 }
 /// Normalize a console tile so that it collides with a cached value more easily.
 /// Removes invisible or nonexistant foreground glyphs.
 TCOD_ConsoleTile normalize_tile_for_drawing(TCOD_ConsoleTile tile, const TCOD_Tileset* __restrict tileset) {
-  if (tile.ch == 0x20) tile.ch = 0;  // Tile is the space character.
-  if (tile.ch < 0 || tile.ch >= tileset->character_map_length) {
-    tile.ch = 0;  // Tile character is out-of-bounds.
-  } else if (tileset->character_map[tile.ch] == 0) {
-    tile.ch = 0;  // Ignore characters not defined in the tileset.
-  }
-  if (tile.fg.a == 0) tile.ch = 0;  // No foreground alpha.
-  if (tile.bg.r == tile.fg.r && tile.bg.g == tile.fg.g && tile.bg.b == tile.fg.b && tile.bg.a == 255 &&
-      tile.fg.a == 255) {
-    tile.ch = 0;  // Foreground and background color match, so the foreground glyph would be invisible.
-  }
-  if (tile.ch == 0) {
+  const bool is_space = tile.ch == 0x20;
+  const bool is_undefined = TCOD_tileset_get_tile_id(tileset, tile.ch) == 0;  // Out-of-bounds or not in the tileset.
+  const bool is_transparent = tile.fg.a == 0;
+  // Foreground and background color match, so the foreground glyph would be invisible.
+  const bool is_hidden = (tile.bg.r == tile.fg.r) & (tile.bg.g == tile.fg.g) & (tile.bg.b == tile.fg.b) &
+                         (tile.bg.a == 255) & (tile.fg.a == 255);
+  // Conditions are combined without short-circuiting so that this compiles to a single branch.
+  if (is_space | is_undefined | is_transparent | is_hidden) {
+    tile.ch = 0;
     tile.fg.r = tile.fg.g = tile.fg.b = tile.fg.a = 0;  // Clear foreground color if the foreground glyph is skipped.
   }
   return tile;
 }
 #if SDL_VERSION_ATLEAST(2, 0, 18)
-/// Initialize indices up to the current buffer index.
-static void vertex_buffer_sync_indices(VertexBuffer* __restrict buffer) {
-  for (; buffer->indices_initialized < buffer->index; ++buffer->indices_initialized) {
-    buffer->indices[buffer->indices_initialized * 6 + 0] = buffer->indices_initialized * 4;
-    buffer->indices[buffer->indices_initialized * 6 + 1] = buffer->indices_initialized * 4 + 1;
-    buffer->indices[buffer->indices_initialized * 6 + 2] = buffer->indices_initialized * 4 + 2;
-    buffer->indices[buffer->indices_initialized * 6 + 3] = buffer->indices_initialized * 4 + 2;
-    buffer->indices[buffer->indices_initialized * 6 + 4] = buffer->indices_initialized * 4 + 1;
-    buffer->indices[buffer->indices_initialized * 6 + 5] = buffer->indices_initialized * 4 + 3;
-  }
-}
-/// Draw all background elements and clear the buffer.
-static void vertex_buffer_flush_bg(VertexBuffer* __restrict buffer, const TCOD_TilesetAtlasSDL2* __restrict atlas) {
-  vertex_buffer_sync_indices(buffer);
-  SDL_SetRenderDrawBlendMode(atlas->renderer, SDL_BLENDMODE_NONE);
-  SDL_RenderGeometryRaw(
-      atlas->renderer,
-      NULL,  // No texture, this renders solid colors.
-      &buffer->vertex->x,
-      sizeof(*buffer->vertex),
-      &buffer->vertex->rgba,
-      sizeof(*buffer->vertex),
-      NULL,
-      0,
-      buffer->index * 4,
-      buffer->indices,
-      buffer->index * 6,
-      2);
-  buffer->index = 0;
-}
-/// Draw all foreground elements and clear the buffer.
-static void vertex_buffer_flush_fg(VertexBuffer* __restrict buffer, const TCOD_TilesetAtlasSDL2* __restrict atlas) {
-  vertex_buffer_sync_indices(buffer);
-  SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
-  SDL_RenderGeometryRaw(
-      atlas->renderer,
-      atlas->texture,
-      &buffer->vertex->x,
-      sizeof(*buffer->vertex),
-      &buffer->vertex->rgba,
-      sizeof(*buffer->vertex),
-      (float*)buffer->vertex_uv,
-      sizeof(*buffer->vertex_uv),
-      buffer->index * 4,
-      buffer->indices,
-      buffer->index * 6,
-      2);
-  buffer->index = 0;
-}
-/// Set the vertices of a tile position.
-static void vertex_buffer_set_tile_pos(
-    VertexBuffer* __restrict buffer, int index, int x, int y, const TCOD_Tileset* __restrict tileset) {
-  buffer->vertex[index * 4 + 0].x = (float)(x * tileset->tile_width);
-  buffer->vertex[index * 4 + 0].y = (float)(y * tileset->tile_height);
-  buffer->vertex[index * 4 + 1].x = (float)(x * tileset->tile_width);
-  buffer->vertex[index * 4 + 1].y = (float)((y + 1) * tileset->tile_height);
-  buffer->vertex[index * 4 + 2].x = (float)((x + 1) * tileset->tile_width);
-  buffer->vertex[index * 4 + 2].y = (float)(y * tileset->tile_height);
-  buffer->vertex[index * 4 + 3].x = (float)((x + 1) * tileset->tile_width);
-  buffer->vertex[index * 4 + 3].y = (float)((y + 1) * tileset->tile_height);
-}
-/// Set the colors of a tile.
-static void vertex_buffer_set_color(VertexBuffer* __restrict buffer, int index, TCOD_ColorRGBA rgba) {
-  SDL_FColor new_color = {
+/// Rebuild `mesh` if it does not match the size of `console` and `tileset`.
+TCOD_NODISCARD
+static TCOD_Error tile_mesh_prepare(
+    struct TCOD_SDL2TileMesh* __restrict mesh,
+    const TCOD_Console* __restrict console,
+    const TCOD_Tileset* __restrict tileset) {
+  if (mesh->columns == console->w && mesh->rows == console->h && mesh->tile_width == tileset->tile_width &&
+      mesh->tile_height == tileset->tile_height && mesh->xy) {
+    return TCOD_E_OK;
+  }
+  tile_mesh_clear(mesh);
+  const size_t tiles = (size_t)console->elements;
+  // Vertices of tiles which were never drawn are still passed to SDL, so they must be initialized.
+  mesh->xy = malloc(sizeof(*mesh->xy) * tiles * 4);
+  mesh->bg_rgba = calloc(tiles * 4, sizeof(*mesh->bg_rgba));
+  mesh->fg_rgba = calloc(tiles * 4, sizeof(*mesh->fg_rgba));
+  mesh->uv = calloc(tiles * 4, sizeof(*mesh->uv));
+  mesh->glyph = calloc(tiles, sizeof(*mesh->glyph));
+  mesh->bg_indices = malloc(sizeof(*mesh->bg_indices) * tiles * 6);
+  mesh->fg_indices = malloc(sizeof(*mesh->fg_indices) * tiles * 6);
+  if (!mesh->xy || !mesh->bg_rgba || !mesh->fg_rgba || !mesh->uv || !mesh->glyph || !mesh->bg_indices ||
+      !mesh->fg_indices) {
+    tile_mesh_clear(mesh);
+    TCOD_set_errorv("Could not allocate the tile mesh.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  mesh->columns = console->w;
+  mesh->rows = console->h;
+  mesh->tile_width = tileset->tile_width;
+  mesh->tile_height = tileset->tile_height;
+  VertexXY* xy = mesh->xy;
+  for (int y = 0; y < console->h; ++y) {
+    const float top = (float)(y * tileset->tile_height);
+    const float bottom = (float)((y + 1) * tileset->tile_height);
+    for (int x = 0; x < console->w; ++x, xy += 4) {
+      const float left = (float)(x * tileset->tile_width);
+      const float right = (float)((x + 1) * tileset->tile_width);
+      xy[0] = (VertexXY){left, top};
+      xy[1] = (VertexXY){left, bottom};
+      xy[2] = (VertexXY){right, top};
+      xy[3] = (VertexXY){right, bottom};
+    }
+  }
+  return TCOD_E_OK;
+}
+/// Set the four vertex colors of a tile.
+static void tile_mesh_set_color(SDL_FColor* __restrict colors, int tile_i, TCOD_ColorRGBA rgba) {
+  const SDL_FColor new_color = {
       (float)rgba.r * (1.0f / 255.0f),
       (float)rgba.g * (1.0f / 255.0f),
       (float)rgba.b * (1.0f / 255.0f),
       (float)rgba.a * (1.0f / 255.0f)};
-  buffer->vertex[index * 4 + 0].rgba = new_color;
-  buffer->vertex[index * 4 + 1].rgba = new_color;
-  buffer->vertex[index * 4 + 2].rgba = new_color;
-  buffer->vertex[index * 4 + 3].rgba = new_color;
-}
-/// Push a background element onto the buffer, flushing it if needed.
-static void vertex_buffer_push_bg(
-    VertexBuffer* __restrict buffer,
-    int x,
-    int y,
-    TCOD_ConsoleTile tile,
-    const TCOD_TilesetAtlasSDL2* __restrict atlas) {
-  if (buffer->index == BUFFER_TILES_MAX) vertex_buffer_flush_bg(buffer, atlas);
-  vertex_buffer_set_tile_pos(buffer, buffer->index, x, y, atlas->tileset);
-  vertex_buffer_set_color(buffer, buffer->index, tile.bg);
-  ++buffer->index;
-}
-/// Push a foreground element onto the buffer, flushing it if needed.
-static void vertex_buffer_push_fg(
-    VertexBuffer* __restrict buffer,
-    int x,
-    int y,
-    TCOD_ConsoleTile tile,
-    const TCOD_TilesetAtlasSDL2* __restrict atlas,
-    float u_multiply,
-    float v_multiply) {
-  if (buffer->index == BUFFER_TILES_MAX) vertex_buffer_flush_fg(buffer, atlas);
-  vertex_buffer_set_tile_pos(buffer, buffer->index, x, y, atlas->tileset);
-  vertex_buffer_set_color(buffer, buffer->index, tile.fg);
-  // Used a lazy method of UV assignment.  This could be improved to use fewer math operations.
-  const int tile_id = atlas->tileset->character_map[tile.ch];
-  const SDL_Rect src = get_sdl2_atlas_tile(atlas, tile_id);
-  buffer->vertex_uv[buffer->index * 4 + 0].u = (float)(src.x) * u_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 0].v = (float)(src.y) * v_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 1].u = (float)(src.x) * u_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 1].v = (float)(src.y + src.h) * v_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 2].u = (float)(src.x + src.w) * u_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 2].v = (float)(src.y) * v_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 3].u = (float)(src.x + src.w) * u_multiply;
-  buffer->vertex_uv[buffer->index * 4 + 3].v = (float)(src.y + src.h) * v_multiply;
-  ++buffer->index;
+  colors[tile_i * 4 + 0] = new_color;
+  colors[tile_i * 4 + 1] = new_color;
+  colors[tile_i * 4 + 2] = new_color;
+  colors[tile_i * 4 + 3] = new_color;
+}
+/// Set the glyph texture coordinates of a tile.
+static void tile_mesh_set_uv(VertexUV* __restrict uv, int tile_i, SDL_Rect src, float u_multiply, float v_multiply) {
+  const float left = (float)(src.x) * u_multiply;
+  const float right = (float)(src.x + src.w) * u_multiply;
+  const float top = (float)(src.y) * v_multiply;
+  const float bottom = (float)(src.y + src.h) * v_multiply;
+  uv[tile_i * 4 + 0] = (VertexUV){left, top};
+  uv[tile_i * 4 + 1] = (VertexUV){left, bottom};
+  uv[tile_i * 4 + 2] = (VertexUV){right, top};
+  uv[tile_i * 4 + 3] = (VertexUV){right, bottom};
+}
+/// Append the two triangles of a tile to `indices`, returns the new end of `indices`.
+static uint32_t* tile_mesh_push_quad(uint32_t* __restrict indices, int tile_i) {
+  const uint32_t vertex = (uint32_t)tile_i * 4;
+  indices[0] = vertex;
+  indices[1] = vertex + 1;
+  indices[2] = vertex + 2;
+  indices[3] = vertex + 2;
+  indices[4] = vertex + 1;
+  indices[5] = vertex + 3;
+  return indices + 6;
 }
 #endif  // SDL_VERSION_ATLEAST(2, 0, 18)
 /**
@@ -408,7 +586,7 @@ static void vertex_buffer_push_fg(
     Returns a negative value on an error, check `TCOD_get_error`.
  */
 static TCOD_Error TCOD_sdl2_render(
-    const TCOD_TilesetAtlasSDL2* __restrict atlas,
+    TCOD_TilesetAtlasSDL2* __restrict atlas,
     const TCOD_Console* __restrict console,
     TCOD_Console* __restrict cache) {
   if (!atlas) {
@@ -423,94 +601,153 @@ static TCOD_Error TCOD_sdl2_render(
     TCOD_set_errorv("Cache console must match the size of the input console.");
     return TCOD_E_INVALID_ARGUMENT;
   }
+  const struct TCOD_ConsoleDirty* console_rows = cache ? TCOD_console_observe_dirty_(console) : NULL;
+  struct TCOD_ConsoleDirty* cache_rows = cache ? TCOD_console_get_dirty_(cache) : NULL;
 #if SDL_VERSION_ATLEAST(2, 0, 18)
-  // Allocate a buffer on the stack and initialize only a few variables.
-  // Reused for the background and foreground passes.
-  VertexBuffer* buffer = malloc(sizeof(*buffer));
-  if (!buffer) return TCOD_E_OUT_OF_MEMORY;
-  buffer->index = 0;
-  buffer->indices_initialized = 0;
+  struct TCOD_SDL2TileMesh* mesh = atlas->mesh;
+  TCOD_Error err = tile_mesh_prepare(mesh, console, atlas->tileset);
+  if (err < 0) return err;
+  ++atlas->glyphs->frame;
+  // Patch the colors of changed tiles and index only those tiles.
+  uint32_t* bg_end = mesh->bg_indices;
+  uint32_t* fg_end = mesh->fg_indices;
   for (int y = 0; y < console->h; ++y) {
-    for (int x = 0; x < console->w; ++x) {
-      const TCOD_ConsoleTile tile = normalize_tile_for_drawing(console->tiles[console->w * y + x], atlas->tileset);
+    if (TCOD_console_row_is_drawn_(console_rows, cache_rows, y)) continue;  // Skip rows without changes.
+    for (int x_begin = 0; x_begin < console->w; x_begin += 64) {
+      const int x_count = TCOD_MIN(64, console->w - x_begin);
+      const int row_i = console->w * y + x_begin;
+      const TCOD_ConsoleTile* tiles = &console->tiles[row_i];
+      uint64_t bg_changed = x_count == 64 ? ~(uint64_t)0 : ((uint64_t)1 << x_count) - 1;
+      uint64_t fg_changed = bg_changed;
       if (cache) {
-        TCOD_ConsoleTile* cached = &cache->tiles[cache->w * y + x];
-        // True if there are changes to the BG color.
-        const bool bg_changed = tile.bg.r != cached->bg.r || tile.bg.g != cached->bg.g || tile.bg.b != cached->bg.b ||
-                                tile.bg.a != cached->bg.a;
-        // True if there are changes to the FG glyph.
-        const bool fg_changed =
-            cached->ch && (tile.ch != cached->ch || tile.fg.r != cached->fg.r || tile.fg.g != cached->fg.g ||
-                           tile.fg.b != cached->fg.b || tile.fg.a != cached->fg.a);
-        if (!(bg_changed || fg_changed)) {
-          continue;  // If no changes exist then this tile can be skipped entirely.
+        TCOD_console_diff_tiles(tiles, &cache->tiles[row_i], x_count, &bg_changed, &fg_changed);
+      }
+      for (uint64_t changed = bg_changed | fg_changed; changed; changed &= changed - 1) {
+        const int i = TCOD_lowest_bit_(changed);
+        const TCOD_ConsoleTile tile = normalize_tile_for_drawing(tiles[i], atlas->tileset);
+        bool keep_bg = false;
+        if (cache) {
+          TCOD_ConsoleTile* cached = &cache->tiles[row_i + i];
+          // If only the glyph changed and no old glyph was visible then the new glyph can be drawn over the old BG.
+          keep_bg = !((bg_changed >> i) & 1) && cached->ch >= 0 &&
+                    normalize_tile_for_drawing(*cached, atlas->tileset).ch == 0;
+          *cached = tiles[i];
         }
-        // Cache the BG and unset the FG data, this will tell the FG pass if it needs to draw the glyph.
-        *cached = (TCOD_ConsoleTile){0, {0, 0, 0, 0}, tile.bg};
+        if (!keep_bg) {
+          tile_mesh_set_color(mesh->bg_rgba, row_i + i, tile.bg);
+          bg_end = tile_mesh_push_quad(bg_end, row_i + i);
+        }
+        if (tile.ch == 0) continue;  // No FG glyph to draw.
+        tile_mesh_set_color(mesh->fg_rgba, row_i + i, tile.fg);
+        mesh->glyph[row_i + i] = TCOD_tileset_get_tile_id(atlas->tileset, tile.ch);
+        fg_end = tile_mesh_push_quad(fg_end, row_i + i);
+      }
+    }
+    TCOD_console_row_set_drawn_(console_rows, cache_rows, y);
+  }
+  // Pack the glyphs of this frame into the atlas.  This can grow the atlas, so UVs are assigned afterwards.
+  uint32_t* fg_kept = mesh->fg_indices;
+  for (const uint32_t* it = mesh->fg_indices; it != fg_end; it += 6) {
+    const int tile_i = (int)(it[0] / 4);
+    mesh->glyph[tile_i] = acquire_sdl2_atlas_tile(atlas, mesh->glyph[tile_i]);
+    if (mesh->glyph[tile_i] < 0) {  // Glyph does not fit in the atlas.
+      if (cache) {
+        // Leave the tile undrawn so that its glyph is drawn by a later frame with room for it.
+        cache->tiles[tile_i].ch = -1;
+        TCOD_console_row_set_undrawn_(cache_rows, tile_i / console->w);
       }
-      // Data is pushed onto the buffer, this is flushed automatically if it would otherwise overflow.
-      vertex_buffer_push_bg(buffer, x, y, tile, atlas);
+      continue;
     }
+    fg_kept = tile_mesh_push_quad(fg_kept, tile_i);
   }
-  // Flush any remaining data.  The buffer can now be reused for foreground data.
-  vertex_buffer_flush_bg(buffer, atlas);
-
-  // The foreground rendering pass.  Draw FG glyphs on top of the background tiles.
+  fg_end = fg_kept;
   float tex_width;
   float tex_height;
   SDL_GetTextureSize(atlas->texture, &tex_width, &tex_height);
   const float u_multiply = 1.0f / (float)(tex_width);  // Used to transform texture pixel coordinates to UV coords.
   const float v_multiply = 1.0f / (float)(tex_height);
-  for (int y = 0; y < console->h; ++y) {
-    for (int x = 0; x < console->w; ++x) {
-      const TCOD_ConsoleTile tile = normalize_tile_for_drawing(console->tiles[console->w * y + x], atlas->tileset);
-      if (tile.ch == 0) continue;  // No FG glyph to draw.
-      if (cache) {
-        TCOD_ConsoleTile* cached = &cache->tiles[cache->w * y + x];
-        // cached->ch will be set to zero by the background pass on changes to the foreground color or glyph.
-        // Because of this the FG color does not need to be checked here.
-        if (tile.ch == cached->ch) {
-          continue;  // The glyph has not changed since the last render.
-        }
-        // Cache the foreground glyph.
-        cached->ch = tile.ch;
-        cached->fg = tile.fg;
-      }
-      vertex_buffer_push_fg(buffer, x, y, tile, atlas, u_multiply, v_multiply);
-    }
+  for (const uint32_t* it = mesh->fg_indices; it != fg_end; it += 6) {
+    const int tile_i = (int)(it[0] / 4);
+    tile_mesh_set_uv(mesh->uv, tile_i, get_sdl2_atlas_tile(atlas, mesh->glyph[tile_i]), u_multiply, v_multiply);
+  }
+  flush_sdl2_atlas_uploads(atlas);
+  // Draw all backgrounds, then blend all glyphs on top of them.  Each pass is a single draw call.
+  // Quads are indexed in ascending order, so each pass only passes the vertices up to its last quad.
+  if (bg_end != mesh->bg_indices) {
+    SDL_SetRenderDrawBlendMode(atlas->renderer, SDL_BLENDMODE_NONE);
+    SDL_RenderGeometryRaw(
+        atlas->renderer,
+        NULL,  // No texture, this renders solid colors.
+        &mesh->xy->x,
+        sizeof(*mesh->xy),
+        mesh->bg_rgba,
+        sizeof(*mesh->bg_rgba),
+        NULL,
+        0,
+        (int)bg_end[-1] + 1,
+        mesh->bg_indices,
+        (int)(bg_end - mesh->bg_indices),
+        sizeof(*mesh->bg_indices));
+  }
+  if (fg_end != mesh->fg_indices) {
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometryRaw(
+        atlas->renderer,
+        atlas->texture,
+        &mesh->xy->x,
+        sizeof(*mesh->xy),
+        mesh->fg_rgba,
+        sizeof(*mesh->fg_rgba),
+        &mesh->uv->u,
+        sizeof(*mesh->uv),
+        (int)fg_end[-1] + 1,
+        mesh->fg_indices,
+        (int)(fg_end - mesh->fg_indices),
+        sizeof(*mesh->fg_indices));
   }
-  vertex_buffer_flush_fg(buffer, atlas);
-  free(buffer);
 #else  // SDL VERSION < 2.0.18
+  ++atlas->glyphs->frame;
   SDL_SetRenderDrawBlendMode(atlas->renderer, SDL_BLENDMODE_NONE);
-  SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
-  SDL_SetTextureAlphaMod(atlas->texture, 0xff);
   for (int y = 0; y < console->h; ++y) {
-    for (int x = 0; x < console->w; ++x) {
-      const SDL_Rect dest = get_aligned_tile(atlas->tileset, x, y);
-      const TCOD_ConsoleTile tile = normalize_tile_for_drawing(console->tiles[console->w * y + x], atlas->tileset);
+    if (TCOD_console_row_is_drawn_(console_rows, cache_rows, y)) continue;  // Skip rows without changes.
+    bool row_complete = true;  // False if any glyph of this row did not fit in the atlas.
+    for (int x_begin = 0; x_begin < console->w; x_begin += 64) {
+      const int x_count = TCOD_MIN(64, console->w - x_begin);
+      const TCOD_ConsoleTile* tiles = &console->tiles[console->w * y + x_begin];
+      uint64_t bg_changed = x_count == 64 ? ~(uint64_t)0 : ((uint64_t)1 << x_count) - 1;
+      uint64_t fg_changed = bg_changed;
       if (cache) {
-        const struct TCOD_ConsoleTile cached = cache->tiles[cache->w * y + x];
-        if (tile.ch == cached.ch && tile.fg.r == cached.fg.r && tile.fg.g == cached.fg.g && tile.fg.b == cached.fg.b &&
-            tile.fg.a == cached.fg.a && tile.bg.r == cached.bg.r && tile.bg.g == cached.bg.g &&
-            tile.bg.b == cached.bg.b && tile.bg.a == cached.bg.a) {
+        TCOD_console_diff_tiles(tiles, &cache->tiles[cache->w * y + x_begin], x_count, &bg_changed, &fg_changed);
+      }
+      for (uint64_t changed = bg_changed | fg_changed; changed; changed &= changed - 1) {
+        const int x = x_begin + TCOD_lowest_bit_(changed);
+        const SDL_Rect dest = get_aligned_tile(atlas->tileset, x, y);
+        const TCOD_ConsoleTile tile = normalize_tile_for_drawing(console->tiles[console->w * y + x], atlas->tileset);
+        if (cache) cache->tiles[cache->w * y + x] = console->tiles[console->w * y + x];
+        // Fill the background of the tile with a solid color.
+        SDL_SetRenderDrawColor(atlas->renderer, tile.bg.r, tile.bg.g, tile.bg.b, tile.bg.a);
+        SDL_RenderFillRect(atlas->renderer, &dest);
+        if (tile.ch == 0) {
+          continue;  // Skip foreground glyph.
+        }
+        // Blend the foreground glyph on top of the background.
+        const int slot = acquire_sdl2_atlas_tile(atlas, TCOD_tileset_get_tile_id(atlas->tileset, tile.ch));
+        if (slot < 0) {  // Glyph does not fit in the atlas.
+          if (cache) {
+            // Leave the tile undrawn so that its glyph is drawn by a later frame with room for it.
+            cache->tiles[cache->w * y + x].ch = -1;
+            row_complete = false;
+          }
           continue;
         }
-        cache->tiles[cache->w * y + x] = tile;
-      }
-      // Fill the background of the tile with a solid color.
-      SDL_SetRenderDrawColor(atlas->renderer, tile.bg.r, tile.bg.g, tile.bg.b, tile.bg.a);
-      SDL_RenderFillRect(atlas->renderer, &dest);
-      if (tile.ch == 0) {
-        continue;  // Skip foreground glyph.
+        flush_sdl2_atlas_uploads(atlas);
+        SDL_SetTextureColorMod(atlas->texture, tile.fg.r, tile.fg.g, tile.fg.b);
+        SDL_SetTextureAlphaMod(atlas->texture, tile.fg.a);
+        const SDL_Rect src = get_sdl2_atlas_tile(atlas, slot);
+        SDL_RenderCopy(atlas->renderer, atlas->texture, &src, &dest);
       }
-      // Blend the foreground glyph on top of the background.
-      SDL_SetTextureColorMod(atlas->texture, tile.fg.r, tile.fg.g, tile.fg.b);
-      SDL_SetTextureAlphaMod(atlas->texture, tile.fg.a);
-      const int tile_id = atlas->tileset->character_map[tile.ch];
-      const SDL_Rect src = get_sdl2_atlas_tile(atlas, tile_id);
-      SDL_RenderCopy(atlas->renderer, atlas->texture, &src, &dest);
     }
+    if (row_complete) TCOD_console_row_set_drawn_(console_rows, cache_rows, y);
   }
 #endif  // SDL_VERSION_ATLEAST
   return TCOD_E_OK;
@@ -582,11 +819,20 @@ TCOD_Error TCOD_sdl2_render_texture_setup(
   }
   return err;
 }
-TCOD_Error TCOD_sdl2_render_texture(
-    const struct TCOD_TilesetAtlasSDL2* __restrict atlas,
+/**
+ *  Render a console onto `target`, or onto the current render target if `target` is NULL.
+ *
+ *  This is TCOD_sdl2_render_texture with a mutable atlas, glyphs are packed into the atlas as they are drawn.
+ */
+static TCOD_Error sdl2_render_texture(
+    struct TCOD_TilesetAtlasSDL2* __restrict atlas,
     const struct TCOD_Console* __restrict console,
     struct TCOD_Console* __restrict cache,
     struct SDL_Texture* __restrict target) {
+  if (!atlas) {
+    TCOD_set_errorv("Atlas must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
   if (!target) {  // Render without a managed target.
     return TCOD_sdl2_render(atlas, console, cache);
   }
@@ -596,6 +842,14 @@ TCOD_Error TCOD_sdl2_render_texture(
   SDL_SetRenderTarget(atlas->renderer, old_target);
   return err;
 }
+TCOD_Error TCOD_sdl2_render_texture(
+    const struct TCOD_TilesetAtlasSDL2* __restrict atlas,
+    const struct TCOD_Console* __restrict console,
+    struct TCOD_Console* __restrict cache,
+    struct SDL_Texture* __restrict target) {
+  // The parameter stays const for existing callers.  Atlases are only made by TCOD_sdl2_atlas_new, never as const.
+  return sdl2_render_texture((struct TCOD_TilesetAtlasSDL2*)atlas, console, cache, target);
+}
 // ----------------------------------------------------------------------------
 // SDL Rendering
 /**
@@ -614,6 +868,7 @@ static bool sdl2_handle_event(void* userdata, SDL_Event* event) {
         for (int i = 0; i < context->cache_console->elements; ++i) {
           context->cache_console->tiles[i] = (struct TCOD_ConsoleTile){-1, {0}, {0}};
         }
+        TCOD_console_mark_dirty(context->cache_console, 0, 0, context->cache_console->w, context->cache_console->h);
       }
       break;
   }
@@ -731,7 +986,7 @@ static TCOD_Error sdl2_accumulate(
   if (err < 0) {
     return err;
   }
-  err = TCOD_sdl2_render_texture(context->atlas, console, context->cache_console, context->cache_texture);
+  err = sdl2_render_texture(context->atlas, console, context->cache_console, context->cache_texture);
   if (err < 0) {
     return err;
   }
@@ -66,6 +66,10 @@ typedef struct TCOD_TilesetAtlasSDL2 {
   struct TCOD_TilesetObserver* observer;
   /** Internal use only. */
   int texture_columns;
+  /** Internal use only. */
+  struct TCOD_SDL2TileMesh* mesh;
+  /** Internal use only. */
+  struct TCOD_SDL2GlyphCache* glyphs;
 } TCOD_TilesetAtlasSDL2;
 /**
     The renderer data for an SDL rendering context.
@@ -165,6 +169,8 @@ TCOD_PUBLIC TCOD_Error TCOD_sdl2_render_texture_setup(
     `atlas` is an SDL atlas created with `TCOD_sdl2_atlas_new`.
     The renderer used to make this `atlas` must support
     `SDL_RENDERER_TARGETTEXTURE`, unless `target` is NULL.
+    Glyphs are packed into the texture of `atlas` as they are drawn.  Even though `atlas` is const, this can
+    replace its texture and changes which glyphs it holds, so it must not be used by another thread at the same time.
 
     `console` is a non-NULL pointer to the libtcod console you want to render.
 
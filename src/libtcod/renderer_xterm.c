@@ -33,15 +33,18 @@
 #ifndef NO_SDL
 #include <SDL3/SDL.h>
 #include <ctype.h>
+#include <errno.h>
 #include <limits.h>
 #include <locale.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(_WIN32)
 #include <windows.h>
 #elif !defined(__MINGW32__)
+#include <fcntl.h>
 #include <signal.h>
 #include <termios.h>
 #include <unistd.h>
@@ -49,9 +52,13 @@
 
 #include "console_types.h"
 #include "error.h"
+#include "libtcod_int.h"
 #include "logging.h"
+#include "utility.h"
 
 #define DOUBLE_CLICK_TIME 500
+/// The most events which can be sent from one input sequence, a key press is sent as both down and up events.
+#define XTERM_MAX_EVENTS_PER_INPUT 2
 
 #if defined(_WIN32)
 static DWORD g_old_mode_stdin = 0;  // Windows console stdin mode before initialization.
@@ -73,64 +80,49 @@ static struct {
     .lock = NULL,
     .out = NULL,
 };
-static struct {
+/// Mouse state and unparsed bytes of a terminal input stream.
+struct XtermInput {
   uint8_t button_down;
   uint64_t last_mouse_down_timestamp;
   uint8_t num_clicks;
   int last_mouse_motion_x;
   int last_mouse_motion_y;
-} g_mouse_state = {
-    .button_down = 0,
-    .last_mouse_down_timestamp = 0,
-    .num_clicks = 1,
-    .last_mouse_motion_x = -1,
-    .last_mouse_motion_y = -1,
+  size_t length;  // The number of bytes in `buffer`.
+  char buffer[256];  // Input which has not been parsed yet, such as the start of an escape sequence.
 };
+#define XTERM_INPUT_INIT {.num_clicks = 1, .last_mouse_motion_x = -1, .last_mouse_motion_y = -1}
+static struct XtermInput g_stdin_input = XTERM_INPUT_INIT;
 
 struct TCOD_RendererXterm {
   TCOD_Console* cache;
   SDL_Thread* input_thread;
+  struct TCOD_XtermEncoder encoder;
+  bool uses_stdio;  // True if this context uses stdin and stdout, otherwise it uses `input_fd` and `output_fd`.
+  bool clear_screen;  // True if the screen must be cleared before the next frame.
+  bool input_closed;  // True once the end of `input_fd` has been reached.
+  int input_errno;  // The error of a failed read which is reported by the next poll, or zero.
+  int input_fd;
+  int output_fd;
+  size_t output_sent;  // The number of bytes of `encoder` already written to `output_fd`.
+  int columns;  // The terminal size of a file descriptor context, or zero if it is not known.
+  int rows;
+  struct XtermInput input;
+};
+/// Where parsed input events are sent.
+struct XtermEventSink {
+  SDL_Event* events;  // The events returned to the caller, or NULL to push events to the SDL event queue.
+  int count;  // The number of events in `events`.
+  int capacity;  // The length of `events`.
+  struct TCOD_RendererXterm* context;  // The file descriptor context being read, or NULL for stdin.
 };
+/// Escape sequences which undo the terminal setup.
+static const char XTERM_CLEANUP[] =
+    "\x1b[2J"  // Clear the screen.
+    "\x1b[?1049l"  // Disable alternative screen buffer.
+    "\x1b[?25h"  // Show cursor.
+    "\x1b[?1003l"  // Disable all motion mouse tracking.
+    "\x1b[?1004l";  // Don't send focus in/out events.
 
-static char* ucs4_to_utf8(int ucs4, char out[5]) {
-  static const unsigned char BYTE_10000000 = 128;
-  static const unsigned char BYTE_11000000 = 192;
-  static const unsigned char BYTE_11100000 = 224;
-  static const unsigned char BYTE_11110000 = 240;
-  static const int B000_000000_000000_111111 = 63;
-  static const int B000_000000_011111_000000 = 1984;
-  static const int B000_000000_111111_000000 = 4032;
-  static const int B000_001111_000000_000000 = 61440;
-  static const int B000_111111_000000_000000 = 258048;
-  static const int B111_000000_000000_000000 = 1835008;
-  if (ucs4 < 0) {
-  } else if (ucs4 <= 0x7F) {
-    out[0] = (char)ucs4;
-    out[1] = '\0';
-    return out;
-  } else if (ucs4 <= 0x07FF) {
-    out[0] = BYTE_11000000 | (unsigned char)((ucs4 & B000_000000_011111_000000) >> 6);
-    out[1] = BYTE_10000000 | (unsigned char)((ucs4 & B000_000000_000000_111111) >> 0);
-    out[2] = '\0';
-    return out;
-  } else if (ucs4 <= 0xFFFF) {
-    out[0] = BYTE_11100000 | (unsigned char)((ucs4 & B000_001111_000000_000000) >> 12);
-    out[1] = BYTE_10000000 | (unsigned char)((ucs4 & B000_000000_111111_000000) >> 6);
-    out[2] = BYTE_10000000 | (unsigned char)((ucs4 & B000_000000_000000_111111) >> 0);
-    out[3] = '\0';
-    return out;
-  } else if (ucs4 <= 0x10FFFF) {
-    out[0] = BYTE_11110000 | (unsigned char)((ucs4 & B111_000000_000000_000000) >> 18);
-    out[1] = BYTE_10000000 | (unsigned char)((ucs4 & B000_111111_000000_000000) >> 12);
-    out[2] = BYTE_10000000 | (unsigned char)((ucs4 & B000_000000_111111_000000) >> 6);
-    out[3] = BYTE_10000000 | (unsigned char)((ucs4 & B000_000000_000000_111111) >> 0);
-    out[4] = '\0';
-    return out;
-  }
-  out[0] = '?';
-  out[1] = '\0';
-  return out;
-}
 /// Poll and return the terminal size.  Returns TCOD_E_ERROR if this times out.
 static TCOD_Error xterm_get_terminal_size(struct TerminalSizeOut* out) {
   out->timestamp = 0;
@@ -160,67 +152,117 @@ static TCOD_Error xterm_get_terminal_size(struct TerminalSizeOut* out) {
   return TCOD_E_ERROR;
 }
 
+/// Write all of `data` to stdout with as few system calls as possible.
+static TCOD_Error xterm_write(const char* data, size_t length) {
+  fflush(stdout);  // Keep any buffered output in order.
+#if defined(_WIN32)
+  HANDLE handle_stdout = GetStdHandle(STD_OUTPUT_HANDLE);
+  while (length) {
+    DWORD written = 0;
+    if (!WriteFile(handle_stdout, data, (DWORD)TCOD_MIN(length, 0x40000000), &written, NULL)) {
+      return TCOD_set_errorv("Could not write to the terminal.");
+    }
+    data += written;
+    length -= written;
+  }
+#elif !defined(__MINGW32__)
+  while (length) {
+    const ssize_t written = write(STDOUT_FILENO, data, length);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return TCOD_set_errorvf("Could not write to the terminal: %s", strerror(errno));
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+#else
+  (void)data;
+  (void)length;
+#endif
+  return TCOD_E_OK;
+}
+/// Write as much of the pending output of a file descriptor context as `output_fd` accepts without blocking.
+static TCOD_Error xterm_flush_fd(struct TCOD_RendererXterm* context) {
+#if !defined(_WIN32)
+  while (context->output_sent < context->encoder.length) {
+    const ssize_t written = write(
+        context->output_fd,
+        context->encoder.buffer + context->output_sent,
+        context->encoder.length - context->output_sent);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return TCOD_E_OK;
+      return TCOD_set_errorvf("Could not write to the terminal: %s", strerror(errno));
+    }
+    context->output_sent += (size_t)written;
+  }
+#else
+  (void)context;
+#endif
+  return TCOD_E_OK;
+}
+/// Clear the pending output of a file descriptor context after it has been sent.
+static void xterm_begin_fd_output(struct TCOD_RendererXterm* context) {
+  TCOD_xterm_encoder_begin_(&context->encoder);
+  context->output_sent = 0;
+}
+
 static TCOD_Error xterm_present(
     struct TCOD_Context* __restrict self,
     const struct TCOD_Console* __restrict console,
     const struct TCOD_ViewportOptions* __restrict viewport) {
   (void)viewport;
   struct TCOD_RendererXterm* context = self->contextdata_;
+  struct TCOD_XtermEncoder* encoder = &context->encoder;
+  int columns = context->columns > 0 ? context->columns : console->w;
+  int rows = context->rows > 0 ? context->rows : console->h;
+  if (context->uses_stdio) {
+    struct TerminalSizeOut term_size;
+    xterm_get_terminal_size(&term_size);  // This polls the terminal and might be too slow.
+    TCOD_xterm_encoder_forget_cursor_(encoder);  // The terminal size poll has moved the cursor.
+    TCOD_xterm_encoder_begin_(encoder);
+    columns = term_size.columns;
+    rows = term_size.rows;
+  } else {
+    TCOD_Error err = xterm_flush_fd(context);
+    if (err < 0) return err;
+    // While the previous output is still being sent this frame is skipped, its changes stay different from the
+    // cache and are sent with the next frame instead.
+    if (context->output_sent < encoder->length) return TCOD_E_OK;
+    xterm_begin_fd_output(context);
+  }
   if (context->cache && (context->cache->w != console->w || context->cache->h != console->h)) {
     TCOD_console_delete(context->cache);
     context->cache = NULL;
+    context->clear_screen = true;  // Remove tiles outside of the new console size.
   }
   if (!context->cache) {
     context->cache = TCOD_console_new(console->w, console->h);
+    if (!context->cache) return TCOD_E_ERROR;
     for (int i = 0; i < context->cache->elements; ++i) context->cache->tiles[i].ch = -1;
+    (void)TCOD_console_set_dirty_tracking(context->cache, true);
   }
-  struct TerminalSizeOut term_size;
-  xterm_get_terminal_size(&term_size);  // This polls the terminal and might be too slow.
-
-  fprintf(stdout, "\x1b[?25l");  // Cursor un-hiding on Windows after window is resized.
-  for (int y = 0; y < console->h && y < term_size.rows; ++y) {
-    fprintf(stdout, "\x1b[%d;0H", y);  // Move cursor to start of next line.
-    int skip_tiles = 0;  // Skip unchanged tiles.
-    for (int x = 0; x < console->w && x < term_size.columns; ++x) {
-      TCOD_ConsoleTile* prev_tile = &context->cache->tiles[console->w * y + x];
-      const TCOD_ConsoleTile* tile = &console->tiles[console->w * y + x];
-      if (tile->ch == prev_tile->ch && tile->fg.r == prev_tile->fg.r && tile->fg.g == prev_tile->fg.g &&
-          tile->fg.b == prev_tile->fg.b && tile->bg.r == prev_tile->bg.r && tile->bg.g == prev_tile->bg.g &&
-          tile->bg.b == prev_tile->bg.b) {
-        ++skip_tiles;
-        continue;
-      }
-      if (skip_tiles) {
-        fprintf(stdout, "\x1b[%dC", skip_tiles);  // Move cursor forward.
-        skip_tiles = 0;
-      }
-      char utf8[5];
-      fprintf(  // Print a character with colors.
-          stdout,
-          "\x1b[38;2;%u;%u;%u;48;2;%u;%u;%um%s",
-          tile->fg.r,
-          tile->fg.g,
-          tile->fg.b,
-          tile->bg.r,
-          tile->bg.g,
-          tile->bg.b,
-          ucs4_to_utf8(tile->ch & 0x10FFFF, utf8));
-      *prev_tile = *tile;
-    }
+  static const char HIDE_CURSOR[] = "\x1b[?25l";  // Cursor un-hiding on Windows after window is resized.
+  static const char CLEAR_SCREEN[] = "\x1b[2J";
+  TCOD_Error err = TCOD_E_OK;
+  if (context->uses_stdio) err = TCOD_xterm_encoder_append_(encoder, HIDE_CURSOR, sizeof(HIDE_CURSOR) - 1);
+  if (err < 0) return err;
+  const bool clear_screen = context->clear_screen;
+  if (clear_screen) {
+    err = TCOD_xterm_encoder_append_(encoder, CLEAR_SCREEN, sizeof(CLEAR_SCREEN) - 1);
+    if (err < 0) return err;
+    context->clear_screen = false;
   }
-  return TCOD_E_OK;
+  const size_t header_length = encoder->length;
+  err = TCOD_xterm_encode_frame_(encoder, console, context->cache, columns, rows);
+  if (err < 0) return err;
+  if (!context->uses_stdio) return xterm_flush_fd(context);
+  if (encoder->length == header_length && !clear_screen) return TCOD_E_OK;  // Nothing changed.
+  return xterm_write(encoder->buffer, encoder->length);
 }
 /// Undo the terminal setup performed on initialization.
 static void xterm_cleanup(void) {
-  fprintf(
-      stdout,
-      "\x1b[2J"  // Clear the screen.
-      "\x1b[?1049l"  // Disable alternative screen buffer.
-      "\x1b[?25h"  // Show cursor.
-      "\x1b[?1003l"  // Disable all motion mouse tracking.
-      "\x1b[?1004h"  // Don't send focus in/out events.
-      "\033c"  // Reset to initial state.
-  );
+  fprintf(stdout, "%s\033c", XTERM_CLEANUP);  // Also reset to initial state.
 #if defined(_WIN32)
   SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), g_old_mode_stdin);
   SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), g_old_mode_stdout);
@@ -231,11 +273,35 @@ static void xterm_cleanup(void) {
 
 static void xterm_destructor(struct TCOD_Context* __restrict self) {
   struct TCOD_RendererXterm* context = self->contextdata_;
-  if (context) free(context);
-  xterm_cleanup();
+  if (!context) {
+    xterm_cleanup();
+    return;
+  }
+  if (context->uses_stdio) {
+    xterm_cleanup();
+  } else {
+    // Restore the terminal if the output can take it without blocking, the file descriptors belong to the caller.
+    if (xterm_flush_fd(context) >= 0 && context->output_sent == context->encoder.length) {
+      xterm_begin_fd_output(context);
+      if (TCOD_xterm_encoder_append_(&context->encoder, XTERM_CLEANUP, sizeof(XTERM_CLEANUP) - 1) >= 0) {
+        (void)xterm_flush_fd(context);
+      }
+    }
+  }
+  TCOD_xterm_encoder_uninit_(&context->encoder);
+  if (context->cache) TCOD_console_delete(context->cache);
+  free(context);
+}
+/// Send an input event to `sink`, the caller has checked that `sink` has room for it.
+static void xterm_emit(struct XtermEventSink* sink, SDL_Event* event) {
+  if (!sink->events) {
+    SDL_PushEvent(event);
+    return;
+  }
+  sink->events[sink->count++] = *event;
 }
 /// Send keyboard and text input events to SDL.
-static void send_sdl_key_press(SDL_Keycode ch, bool shift) {
+static void send_sdl_key_press(struct XtermEventSink* sink, SDL_Keycode ch, bool shift) {
   SDL_Keycode sym = ch;
   SDL_Keymod mod = SDL_KMOD_NONE;
   if (shift) {
@@ -253,29 +319,15 @@ static void send_sdl_key_press(SDL_Keycode ch, bool shift) {
           .mod = mod,
           .down = true,
           .repeat = false}};
-  SDL_PushEvent(&down_event);
+  xterm_emit(sink, &down_event);
   SDL_Event up_event = down_event;
   up_event.type = SDL_EVENT_KEY_UP;
   up_event.key.down = false;
-  SDL_PushEvent(&up_event);
+  xterm_emit(sink, &up_event);
 }
 
-static int read_terminated_int(char* after) {
-  *after = '\0';
-  char buf[16] = "";
-  for (size_t i = 0; i < sizeof(buf) - 1; i++) {
-    const char ch = (char)getchar();
-    if (!isdigit(ch)) {
-      *after = ch;
-      buf[i] = '\0';
-      return atoi(buf);
-    }
-    buf[i] = ch;
-  }
-  return atoi(buf);
-}
 /// Send mouse inputs to SDL.
-static void xterm_handle_mouse_click(int cb, int x, int y) {
+static void xterm_handle_mouse_click(struct XtermInput* input, struct XtermEventSink* sink, int cb, int x, int y) {
   const int cb_button = cb & 3;
   const uint64_t timestamp = SDL_GetTicks();
   uint32_t type = SDL_EVENT_MOUSE_BUTTON_DOWN;
@@ -294,20 +346,20 @@ static void xterm_handle_mouse_click(int cb, int x, int y) {
     case 3:
       type = SDL_EVENT_MOUSE_BUTTON_UP;
       down = false;
-      button = g_mouse_state.button_down;
+      button = input->button_down;
       break;
     default:
       TCOD_log_debug_f("unknown mouse button %i\n", cb_button);
   }
   if (type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
     // We don't get button info on mouse up, so only do one click at once.
-    if (g_mouse_state.button_down > 0) return;
-    g_mouse_state.button_down = button;
-    if (timestamp < g_mouse_state.last_mouse_down_timestamp + DOUBLE_CLICK_TIME) g_mouse_state.num_clicks += 1;
-    g_mouse_state.last_mouse_down_timestamp = timestamp;
+    if (input->button_down > 0) return;
+    input->button_down = button;
+    if (timestamp < input->last_mouse_down_timestamp + DOUBLE_CLICK_TIME) input->num_clicks += 1;
+    input->last_mouse_down_timestamp = timestamp;
   } else {
-    if (g_mouse_state.button_down <= 0) return;
-    g_mouse_state.button_down = 0;
+    if (input->button_down <= 0) return;
+    input->button_down = 0;
   }
   SDL_Event button_event = {
       .button = {
@@ -317,15 +369,15 @@ static void xterm_handle_mouse_click(int cb, int x, int y) {
           .which = 0,
           .button = button,
           .down = down,
-          .clicks = g_mouse_state.num_clicks,
+          .clicks = input->num_clicks,
           .x = (float)x,
           .y = (float)y,
       }};
-  SDL_PushEvent(&button_event);
-  if (type != SDL_EVENT_MOUSE_BUTTON_DOWN) g_mouse_state.num_clicks = 1;
+  xterm_emit(sink, &button_event);
+  if (type != SDL_EVENT_MOUSE_BUTTON_DOWN) input->num_clicks = 1;
 }
 /// Send mouse wheel events to SDL.
-static void xterm_handle_mouse_wheel(int cb) {
+static void xterm_handle_mouse_wheel(struct XtermEventSink* sink, int cb) {
   const int cb_button = cb & 3;
   float dy = 0;
   switch (cb_button) {
@@ -348,17 +400,17 @@ static void xterm_handle_mouse_wheel(int cb) {
           .y = dy,
           .direction = SDL_MOUSEWHEEL_NORMAL,
       }};
-  SDL_PushEvent(&wheel_event);
+  xterm_emit(sink, &wheel_event);
 }
 /// Send mouse motion info to SDL.
-static void xterm_handle_mouse_motion(int x, int y) {
+static void xterm_handle_mouse_motion(struct XtermInput* input, struct XtermEventSink* sink, int x, int y) {
   int xrel = 0, yrel = 0;
-  if (g_mouse_state.last_mouse_motion_x >= 0 && g_mouse_state.last_mouse_motion_y >= 0) {
-    xrel = x - g_mouse_state.last_mouse_motion_x;
-    yrel = y - g_mouse_state.last_mouse_motion_y;
+  if (input->last_mouse_motion_x >= 0 && input->last_mouse_motion_y >= 0) {
+    xrel = x - input->last_mouse_motion_x;
+    yrel = y - input->last_mouse_motion_y;
   }
-  g_mouse_state.last_mouse_motion_x = x;
-  g_mouse_state.last_mouse_motion_y = y;
+  input->last_mouse_motion_x = x;
+  input->last_mouse_motion_y = y;
   SDL_Event motion_event = {
       .motion = {
           .type = SDL_EVENT_MOUSE_MOTION,
@@ -370,160 +422,183 @@ static void xterm_handle_mouse_motion(int x, int y) {
           .xrel = (float)xrel,
           .yrel = (float)yrel,
       }};
-  SDL_PushEvent(&motion_event);
+  xterm_emit(sink, &motion_event);
 }
 /// Parse X10 compatibility mode mouse escape sequences.
-static void xterm_handle_mouse_escape() {
-  const char cb = (char)getchar();
-  const int x = getchar() - 33;
-  const int y = getchar() - 33;
+static void xterm_handle_mouse_escape(struct XtermInput* input, struct XtermEventSink* sink, const char* data) {
+  const int cb = (unsigned char)data[0];
+  const int x = (unsigned char)data[1] - 33;
+  const int y = (unsigned char)data[2] - 33;
   if (cb & 32) {
     if (cb & 64)
-      xterm_handle_mouse_wheel(cb);
+      xterm_handle_mouse_wheel(sink, cb);
     else
-      xterm_handle_mouse_click(cb, x, y);
+      xterm_handle_mouse_click(input, sink, cb, x, y);
   } else {
-    xterm_handle_mouse_motion(x, y);
+    xterm_handle_mouse_motion(input, sink, x, y);
   }
 }
 
-static bool xterm_handle_input_escape_code(char* start, char* end, int* arg0, int* arg1) {
-  *start = '\0';
-  *arg0 = -1;
-  *arg1 = -1;
-  *start = (char)getchar();
-  if (*start != '[' && *start != 'O') return false;
-  *arg0 = read_terminated_int(end);
-  if (*end == ';') *arg1 = read_terminated_int(end);
-  return true;
-}
 /// Send a window event to SDL.
-static void xterm_handle_focus_change(SDL_EventType event) {
+static void xterm_handle_focus_change(struct XtermEventSink* sink, SDL_EventType event) {
   SDL_Event focus_event = {
       .window = {
           .type = event,
           .timestamp = SDL_GetTicks(),
           .windowID = 0,
       }};
-  SDL_PushEvent(&focus_event);
+  xterm_emit(sink, &focus_event);
+}
+/// Change the known terminal size of a file descriptor context, the screen is redrawn if the size changes.
+static void xterm_resize(struct TCOD_RendererXterm* context, int columns, int rows) {
+  if (context->columns == columns && context->rows == rows) return;
+  context->columns = columns;
+  context->rows = rows;
+  context->clear_screen = true;
+  TCOD_xterm_encoder_forget_cursor_(&context->encoder);  // Some terminals move the cursor when resized.
+  if (context->cache) {
+    TCOD_console_delete(context->cache);
+    context->cache = NULL;
+  }
+}
+/// Handle a reply to the text area size query of a file descriptor context.
+static void xterm_handle_size_report(struct XtermEventSink* sink, int columns, int rows) {
+  if (columns <= 0 || rows <= 0) return;
+  if (sink->context->columns == columns && sink->context->rows == rows) return;
+  xterm_resize(sink->context, columns, rows);
+  SDL_Event resize_event = {
+      .window = {
+          .type = SDL_EVENT_WINDOW_RESIZED,
+          .timestamp = SDL_GetTicks(),
+          .windowID = 0,
+          .data1 = columns,
+          .data2 = rows,
+      }};
+  xterm_emit(sink, &resize_event);
 }
 /// Dispatch an ANSI escape sequence, excluding the first escape byte.
-static void xterm_handle_input_escape() {
-  char start, end;
-  int arg0, arg1;
-  if (!xterm_handle_input_escape_code(&start, &end, &arg0, &arg1)) return;
+static void xterm_handle_input_escape(
+    struct XtermEventSink* sink, char start, char end, const int args[3], int args_count) {
   bool unknown = false;
   switch (start) {
     case '[':  // CSI
       switch (end) {
-        case 'M':
-          xterm_handle_mouse_escape();
-          break;
         case 'I':
-          xterm_handle_focus_change(SDL_EVENT_WINDOW_FOCUS_GAINED);
+          xterm_handle_focus_change(sink, SDL_EVENT_WINDOW_FOCUS_GAINED);
           break;
         case 'O':
-          xterm_handle_focus_change(SDL_EVENT_WINDOW_FOCUS_LOST);
+          xterm_handle_focus_change(sink, SDL_EVENT_WINDOW_FOCUS_LOST);
           break;
         case 'A':
-          send_sdl_key_press(SDLK_UP, false);
+          send_sdl_key_press(sink, SDLK_UP, false);
           break;
         case 'B':
-          send_sdl_key_press(SDLK_DOWN, false);
+          send_sdl_key_press(sink, SDLK_DOWN, false);
           break;
         case 'C':
-          send_sdl_key_press(SDLK_RIGHT, false);
+          send_sdl_key_press(sink, SDLK_RIGHT, false);
           break;
         case 'D':
-          send_sdl_key_press(SDLK_LEFT, false);
+          send_sdl_key_press(sink, SDLK_LEFT, false);
           break;
         case 'H':
-          send_sdl_key_press(SDLK_HOME, false);
+          send_sdl_key_press(sink, SDLK_HOME, false);
           break;
         case 'F':
-          send_sdl_key_press(SDLK_END, false);
+          send_sdl_key_press(sink, SDLK_END, false);
           break;
         case 'P':
-          send_sdl_key_press(SDLK_F1, false);
+          send_sdl_key_press(sink, SDLK_F1, false);
           break;
         case 'Q':
-          send_sdl_key_press(SDLK_F2, false);
+          send_sdl_key_press(sink, SDLK_F2, false);
           break;
         case 'R':
+          if (sink->context) {
+            send_sdl_key_press(sink, SDLK_F3, false);
+            break;
+          }
           SDL_LockMutex(g_terminal_size_state.lock);
           if (g_terminal_size_state.out != NULL) {
-            g_terminal_size_state.out->rows = arg0;
-            g_terminal_size_state.out->columns = arg1;
+            g_terminal_size_state.out->rows = args[0];
+            g_terminal_size_state.out->columns = args[1];
             g_terminal_size_state.out->timestamp = SDL_GetTicks();
           } else {
-            send_sdl_key_press(SDLK_F3, false);
+            send_sdl_key_press(sink, SDLK_F3, false);
           }
           SDL_UnlockMutex(g_terminal_size_state.lock);
           break;
+        case 't':
+          if (sink->context && args_count == 3 && args[0] == 8) {  // Text area size report.
+            xterm_handle_size_report(sink, args[2], args[1]);
+          } else {
+            unknown = true;
+          }
+          break;
         case 'S':
-          send_sdl_key_press(SDLK_F4, false);
+          send_sdl_key_press(sink, SDLK_F4, false);
           break;
         case '~':
-          switch (arg0) {
+          switch (args[0]) {
             case 1:
-              send_sdl_key_press(SDLK_HOME, false);
+              send_sdl_key_press(sink, SDLK_HOME, false);
               break;
             case 4:
-              send_sdl_key_press(SDLK_END, false);
+              send_sdl_key_press(sink, SDLK_END, false);
               break;
             case 2:
-              send_sdl_key_press(SDLK_INSERT, false);
+              send_sdl_key_press(sink, SDLK_INSERT, false);
               break;
             case 3:
-              send_sdl_key_press(SDLK_DELETE, false);
+              send_sdl_key_press(sink, SDLK_DELETE, false);
               break;
             case 5:
-              send_sdl_key_press(SDLK_PAGEUP, false);
+              send_sdl_key_press(sink, SDLK_PAGEUP, false);
               break;
             case 6:
-              send_sdl_key_press(SDLK_PAGEDOWN, false);
+              send_sdl_key_press(sink, SDLK_PAGEDOWN, false);
               break;
             case 7:  // For urxvt
-              send_sdl_key_press(SDLK_HOME, false);
+              send_sdl_key_press(sink, SDLK_HOME, false);
               break;
             case 8:  // For urxvt
-              send_sdl_key_press(SDLK_END, false);
+              send_sdl_key_press(sink, SDLK_END, false);
               break;
             case 11:
-              send_sdl_key_press(SDLK_F1, false);
+              send_sdl_key_press(sink, SDLK_F1, false);
               break;
             case 12:
-              send_sdl_key_press(SDLK_F2, false);
+              send_sdl_key_press(sink, SDLK_F2, false);
               break;
             case 13:
-              send_sdl_key_press(SDLK_F3, false);
+              send_sdl_key_press(sink, SDLK_F3, false);
               break;
             case 14:
-              send_sdl_key_press(SDLK_F4, false);
+              send_sdl_key_press(sink, SDLK_F4, false);
               break;
             case 15:
-              send_sdl_key_press(SDLK_F5, false);
+              send_sdl_key_press(sink, SDLK_F5, false);
               break;
             case 17:
-              send_sdl_key_press(SDLK_F6, false);
+              send_sdl_key_press(sink, SDLK_F6, false);
               break;
             case 18:
-              send_sdl_key_press(SDLK_F7, false);
+              send_sdl_key_press(sink, SDLK_F7, false);
               break;
             case 19:
-              send_sdl_key_press(SDLK_F8, false);
+              send_sdl_key_press(sink, SDLK_F8, false);
               break;
             case 20:
-              send_sdl_key_press(SDLK_F9, false);
+              send_sdl_key_press(sink, SDLK_F9, false);
               break;
             case 21:
-              send_sdl_key_press(SDLK_F10, false);
+              send_sdl_key_press(sink, SDLK_F10, false);
               break;
             case 23:
-              send_sdl_key_press(SDLK_F11, false);
+              send_sdl_key_press(sink, SDLK_F11, false);
               break;
             case 24:
-              send_sdl_key_press(SDLK_F12, false);
+              send_sdl_key_press(sink, SDLK_F12, false);
               break;
             default:
               unknown = true;
@@ -536,16 +611,16 @@ static void xterm_handle_input_escape() {
     case 'O':  // SS3
       switch (end) {
         case 'P':
-          send_sdl_key_press(SDLK_F1, false);
+          send_sdl_key_press(sink, SDLK_F1, false);
           break;
         case 'Q':
-          send_sdl_key_press(SDLK_F2, false);
+          send_sdl_key_press(sink, SDLK_F2, false);
           break;
         case 'R':
-          send_sdl_key_press(SDLK_F3, false);
+          send_sdl_key_press(sink, SDLK_F3, false);
           break;
         case 'S':
-          send_sdl_key_press(SDLK_F4, false);
+          send_sdl_key_press(sink, SDLK_F4, false);
           break;
         default:
           unknown = true;
@@ -554,26 +629,92 @@ static void xterm_handle_input_escape() {
     default:
       unknown = true;
   }
-  if (unknown) TCOD_log_debug_f("unknown input escape code '%c' '%c' %i %i\n", start, end, arg0, arg1);
+  if (unknown) TCOD_log_debug_f("unknown input escape code '%c' '%c' %i %i\n", start, end, args[0], args[1]);
+}
+/**
+ *  Parse one input event from the start of `data` and send it to `sink`.
+ *
+ *  Returns the number of bytes used, or zero if `data` ends before the event is complete.
+ */
+static size_t xterm_parse_input(
+    struct XtermInput* input, struct XtermEventSink* sink, const char* data, size_t length) {
+  if (length == 0) return 0;
+  if (data[0] != '\x1b') {
+    send_sdl_key_press(sink, data[0], isupper((unsigned char)data[0]));
+    return 1;
+  }
+  if (length < 2) return 0;
+  const char start = data[1];
+  if (start != '[' && start != 'O') return 2;  // Discard unknown sequences.
+  int args[3] = {0, -1, -1};
+  int args_count = 1;
+  size_t i = 2;
+  for (;; ++i) {
+    if (i >= length) return 0;
+    if (isdigit((unsigned char)data[i])) {
+      int* arg = &args[args_count - 1];
+      if (*arg < 0) *arg = 0;
+      if (*arg < 100000) *arg = *arg * 10 + (data[i] - '0');
+    } else if (data[i] == ';') {
+      if (args_count < 3) ++args_count;
+    } else {
+      break;
+    }
+  }
+  const char end = data[i++];
+  if (start == '[' && end == 'M') {  // Mouse events have three more bytes.
+    if (length < i + 3) return 0;
+    xterm_handle_mouse_escape(input, sink, &data[i]);
+    return i + 3;
+  }
+  xterm_handle_input_escape(sink, start, end, args, args_count);
+  return i;
+}
+/// Send every complete event in the buffer of `input` to `sink` while it has room, then discard the parsed bytes.
+static void xterm_parse_input_buffer(struct XtermInput* input, struct XtermEventSink* sink) {
+  size_t parsed = 0;
+  while (!sink->events || sink->capacity - sink->count >= XTERM_MAX_EVENTS_PER_INPUT) {
+    const size_t event_length = xterm_parse_input(input, sink, input->buffer + parsed, input->length - parsed);
+    if (!event_length) break;
+    parsed += event_length;
+  }
+  // Sequences longer than the buffer can never complete, drop their first byte to make progress.
+  if (!parsed && input->length == sizeof(input->buffer)) parsed = 1;
+  memmove(input->buffer, input->buffer + parsed, input->length - parsed);
+  input->length -= parsed;
 }
 /// ANSI input event loop.
 static int xterm_handle_input(void* nulldata) {
   (void)nulldata;  // Unused
+  struct XtermInput* input = &g_stdin_input;
+  struct XtermEventSink sink = {.events = NULL, .count = 0, .capacity = 0, .context = NULL};
   while (true) {
-    const char ch = (char)getchar();
-    if (ch == '\x1b') {
-      xterm_handle_input_escape();
-      continue;
-    }
-    send_sdl_key_press(ch, isupper(ch));
+#if defined(_WIN32)
+    const int ch = getchar();
+    if (ch == EOF) return 0;
+    input->buffer[input->length++] = (char)ch;
+#else
+    const ssize_t read_length =
+        read(STDIN_FILENO, input->buffer + input->length, sizeof(input->buffer) - input->length);
+    if (read_length < 0 && errno == EINTR) continue;
+    if (read_length <= 0) return 0;
+    input->length += (size_t)read_length;
+#endif
+    xterm_parse_input_buffer(input, &sink);
   }
   return 0;
 }
 
 static TCOD_Error xterm_recommended_console_size(
     struct TCOD_Context* __restrict self, float magnification, int* __restrict columns, int* __restrict rows) {
-  (void)self;  // Unused.
   (void)magnification;
+  struct TCOD_RendererXterm* context = self ? self->contextdata_ : NULL;
+  if (context && !context->uses_stdio) {
+    if (context->columns <= 0 || context->rows <= 0) return TCOD_set_errorv("The terminal size is not known yet.");
+    *columns = context->columns;
+    *rows = context->rows;
+    return TCOD_E_OK;
+  }
   struct TerminalSizeOut size_out;
   TCOD_Error err = xterm_get_terminal_size(&size_out);
   if (err < 0) return err;
@@ -626,6 +767,7 @@ TCOD_Context* TCOD_renderer_init_xterm(
     TCOD_set_errorv("Could not allocate memory.");
     return NULL;
   }
+  data->uses_stdio = true;
   context->c_present_ = &xterm_present;
   context->c_destructor_ = &xterm_destructor;
   context->c_recommended_console_size_ = xterm_recommended_console_size;
@@ -677,4 +819,154 @@ TCOD_Context* TCOD_renderer_init_xterm(
   data->input_thread = SDL_CreateThread(&xterm_handle_input, "input thread", NULL);
   return context;
 }
+#if !defined(_WIN32)
+/// Add `O_NONBLOCK` to the flags of `fd`.
+static bool xterm_set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+#endif
+TCOD_Context* TCOD_renderer_init_xterm_fd(
+    int input_fd, int output_fd, int columns, int rows, const char* window_title) {
+#if defined(_WIN32)
+  (void)input_fd;
+  (void)output_fd;
+  (void)columns;
+  (void)rows;
+  (void)window_title;
+  TCOD_set_errorv("Renderer not supported.");
+  return NULL;
+#else
+  if (input_fd < 0 || output_fd < 0) {
+    TCOD_set_errorvf("Invalid file descriptors: %i, %i", input_fd, output_fd);
+    return NULL;
+  }
+  if (!xterm_set_nonblocking(input_fd) || !xterm_set_nonblocking(output_fd)) {
+    TCOD_set_errorvf("Could not make the file descriptors non-blocking: %s", strerror(errno));
+    return NULL;
+  }
+  TCOD_Context* context = TCOD_context_new_();
+  if (!context) return NULL;
+  context->type = TCOD_RENDERER_XTERM;
+  struct TCOD_RendererXterm* data = context->contextdata_ = calloc(1, sizeof(*data));
+  if (!data) {
+    TCOD_context_delete(context);
+    TCOD_set_errorv("Could not allocate memory.");
+    return NULL;
+  }
+  data->uses_stdio = false;
+  data->input_fd = input_fd;
+  data->output_fd = output_fd;
+  data->columns = TCOD_MAX(0, columns);
+  data->rows = TCOD_MAX(0, rows);
+  data->input = (struct XtermInput)XTERM_INPUT_INIT;
+  TCOD_xterm_encoder_forget_cursor_(&data->encoder);
+  context->c_present_ = &xterm_present;
+  context->c_destructor_ = &xterm_destructor;
+  context->c_recommended_console_size_ = xterm_recommended_console_size;
+  static const char SETUP[] =
+      "\x1b[?1049h"  // Enable alternative screen buffer.
+      "\x1b[2J"  // Clear the screen.
+      "\x1b[?25l"  // Hide cursor.
+      "\x1b[?1003h"  // Enable all motion mouse tracking.
+      "\x1b[?1004h";  // Send focus in/out events.
+  static const char QUERY_SIZE[] = "\x1b[18t";  // Report the text area size in characters.
+  static const char TITLE_START[] = "\x1b]0;";
+  TCOD_Error err = TCOD_xterm_encoder_append_(&data->encoder, SETUP, sizeof(SETUP) - 1);
+  if (err >= 0 && (data->columns <= 0 || data->rows <= 0)) {
+    data->columns = data->rows = 0;
+    err = TCOD_xterm_encoder_append_(&data->encoder, QUERY_SIZE, sizeof(QUERY_SIZE) - 1);
+  }
+  if (err >= 0 && window_title) {
+    err = TCOD_xterm_encoder_append_(&data->encoder, TITLE_START, sizeof(TITLE_START) - 1);
+    if (err >= 0) err = TCOD_xterm_encoder_append_(&data->encoder, window_title, strlen(window_title));
+    if (err >= 0) err = TCOD_xterm_encoder_append_(&data->encoder, "\x07", 1);
+  }
+  if (err >= 0) err = xterm_flush_fd(data);
+  if (err < 0) {
+    TCOD_context_delete(context);
+    return NULL;
+  }
+  return context;
+#endif  // _WIN32
+}
+/// Return the renderer data of a context made with TCOD_renderer_init_xterm_fd, or set an error and return NULL.
+static struct TCOD_RendererXterm* xterm_get_fd_context(TCOD_Context* context) {
+  if (!context || context->type != TCOD_RENDERER_XTERM || !context->contextdata_ ||
+      ((struct TCOD_RendererXterm*)context->contextdata_)->uses_stdio) {
+    TCOD_set_errorv("Context must be made with TCOD_renderer_init_xterm_fd.");
+    return NULL;
+  }
+  return context->contextdata_;
+}
+int TCOD_context_xterm_poll_events(TCOD_Context* context, SDL_Event* events, int max_events) {
+  struct TCOD_RendererXterm* data = xterm_get_fd_context(context);
+  if (!data) return TCOD_E_INVALID_ARGUMENT;
+  if (!events || max_events < XTERM_MAX_EVENTS_PER_INPUT) {
+    TCOD_set_errorvf("max_events must be at least %i.", XTERM_MAX_EVENTS_PER_INPUT);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (data->input_errno) {  // A read failed after the events of the previous poll were parsed.
+    const int input_errno = data->input_errno;
+    data->input_errno = 0;
+    return TCOD_set_errorvf("Could not read from the terminal: %s", strerror(input_errno));
+  }
+  struct XtermEventSink sink = {.events = events, .count = 0, .capacity = max_events, .context = data};
+#if !defined(_WIN32)
+  while (true) {
+    xterm_parse_input_buffer(&data->input, &sink);
+    if (data->input_closed || sink.capacity - sink.count < XTERM_MAX_EVENTS_PER_INPUT) break;
+    const ssize_t read_length = read(
+        data->input_fd, data->input.buffer + data->input.length, sizeof(data->input.buffer) - data->input.length);
+    if (read_length < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      if (sink.count) {  // Return the events parsed so far and report the error on the next call.
+        data->input_errno = errno;
+        break;
+      }
+      return TCOD_set_errorvf("Could not read from the terminal: %s", strerror(errno));
+    }
+    if (read_length == 0) {  // The client has disconnected.
+      data->input_closed = true;
+      SDL_Event quit_event = {.quit = {.type = SDL_EVENT_QUIT, .timestamp = SDL_GetTicks()}};
+      xterm_emit(&sink, &quit_event);
+      break;
+    }
+    data->input.length += (size_t)read_length;
+  }
+#endif  // _WIN32
+  return sink.count;
+}
+TCOD_Error TCOD_context_xterm_set_size(TCOD_Context* context, int columns, int rows) {
+  struct TCOD_RendererXterm* data = xterm_get_fd_context(context);
+  if (!data) return TCOD_E_INVALID_ARGUMENT;
+  if (columns <= 0 || rows <= 0) {
+    TCOD_set_errorvf("Terminal size must be positive, got %i by %i.", columns, rows);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  xterm_resize(data, columns, rows);
+  return TCOD_E_OK;
+}
+int TCOD_context_xterm_flush(TCOD_Context* context) {
+  struct TCOD_RendererXterm* data = xterm_get_fd_context(context);
+  if (!data) return TCOD_E_INVALID_ARGUMENT;
+  TCOD_Error err = xterm_flush_fd(data);
+  if (err < 0) return err;
+  return (int)TCOD_MIN(data->encoder.length - data->output_sent, INT_MAX);
+}
+TCOD_Error TCOD_context_xterm_set_color_mode(TCOD_Context* context, TCOD_XtermColorMode mode, bool dither) {
+  if (!context || context->type != TCOD_RENDERER_XTERM || !context->contextdata_) {
+    TCOD_set_errorv("Context must be an xterm context.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  struct TCOD_RendererXterm* data = context->contextdata_;
+  TCOD_Error err = TCOD_xterm_encoder_set_color_mode_(&data->encoder, mode, dither);
+  if (err < 0) return err;
+  if (data->cache) {  // The cached colors are from the old color mode.
+    TCOD_console_delete(data->cache);
+    data->cache = NULL;
+  }
+  return TCOD_E_OK;
+}
 #endif  // NO_SDL
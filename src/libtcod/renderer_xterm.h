@@ -34,11 +34,95 @@
 #define LIBTCOD_RENDERER_XTERM_H_
 #include "config.h"
 #include "context.h"
+/**
+    Color output modes of the xterm renderer.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef enum TCOD_XtermColorMode {
+  /// 24-bit colors, this is the default.
+  TCOD_XTERM_COLOR_TRUECOLOR = 0,
+  /// The xterm 256 color palette.  Only the color cube and the grayscale ramp are used.
+  TCOD_XTERM_COLOR_256 = 1,
+  /// The 16 ANSI colors, matched against the default xterm palette.
+  TCOD_XTERM_COLOR_16 = 2,
+} TCOD_XtermColorMode;
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 TCOD_PUBLIC TCOD_NODISCARD TCOD_Context* TCOD_renderer_init_xterm(
     int window_x, int window_y, int pixel_width, int pixel_height, int columns, int rows, const char* window_title);
+/**
+    Return a new xterm context which reads terminal input from `input_fd` and draws to `output_fd`.
+
+    This is for programs which serve many terminals at once, such as over sockets or pseudoterminals.
+    Unlike TCOD_renderer_init_xterm this does not start an input thread, install signal handlers, or change the
+    terminal mode.  The caller should put a pseudoterminal into raw mode and ignore `SIGPIPE` for sockets.
+
+    Both file descriptors are made non-blocking and are not closed by the context, they can be the same descriptor.
+    `columns` and `rows` are the terminal size if it is known, otherwise the size is queried from the terminal.
+
+    TCOD_context_present never blocks on these contexts.  If the previous frame is still being sent then the new
+    frame is skipped and its changes are sent with the next frame which can be.
+
+    Returns NULL on an error, check `TCOD_get_error`.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_NODISCARD TCOD_Context* TCOD_renderer_init_xterm_fd(
+    int input_fd, int output_fd, int columns, int rows, const char* window_title);
+/**
+    Read the pending input of a context from TCOD_renderer_init_xterm_fd and convert it into SDL events.
+
+    Up to `max_events` events are written to `events`, which must have room for at least 2 events.
+    This never blocks and the events are not pushed to the SDL event queue.
+    A `SDL_EVENT_QUIT` event is returned once the input is closed, and a `SDL_EVENT_WINDOW_RESIZED` event is
+    returned when the terminal reports a new size.
+
+    Returns the number of events written, or a negative value on an error, check `TCOD_get_error`.
+    If reading fails after some events were already written then those are returned and the next call fails instead.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC int TCOD_context_xterm_poll_events(struct TCOD_Context* context, union SDL_Event* events, int max_events);
+/**
+    Set the terminal size of a context from TCOD_renderer_init_xterm_fd, such as after a pseudoterminal is resized.
+
+    The screen is cleared and redrawn on the next present if the size has changed.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_context_xterm_set_size(struct TCOD_Context* context, int columns, int rows);
+/**
+    Write any output of a context from TCOD_renderer_init_xterm_fd which is still pending, without blocking.
+
+    This can be called when `output_fd` becomes writable to send the rest of a frame before the next present.
+
+    Returns the number of bytes still pending, or a negative value on an error, check `TCOD_get_error`.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC int TCOD_context_xterm_flush(struct TCOD_Context* context);
+/**
+    Set the color output mode of an xterm context.
+
+    Indexed modes send fewer bytes and work on terminals without 24-bit color.
+    Colors are converted to palette indexes using a lookup table of 15-bit colors, and tiles whose colors convert to
+    the same indexes as before are not redrawn.
+    If `dither` is true then an ordered dither pattern is added to colors before they are converted.
+
+    The whole screen is redrawn on the next present.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_context_xterm_set_color_mode(
+    struct TCOD_Context* context, TCOD_XtermColorMode mode, bool dither);
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,425 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "console.h"
+#include "error.h"
+#include "libtcod_int.h"
+#include "utility.h"
+
+/// The most bytes a single tile can append: a cursor move, a full SGR, a reprinted gap, and a glyph.
+#define XTERM_MAX_TILE_BYTES 128
+/// The longest gap of unchanged tiles which may be reprinted instead of moving the cursor over it.
+#define XTERM_MAX_REPRINT 3
+
+void TCOD_xterm_encoder_uninit_(struct TCOD_XtermEncoder* encoder) {
+  free(encoder->buffer);
+  encoder->buffer = NULL;
+  encoder->length = encoder->capacity = 0;
+  free(encoder->palette_lut);
+  encoder->palette_lut = NULL;
+  free(encoder->quantized_row);
+  encoder->quantized_row = NULL;
+  encoder->quantized_row_capacity = 0;
+}
+void TCOD_xterm_encoder_begin_(struct TCOD_XtermEncoder* encoder) { encoder->length = 0; }
+void TCOD_xterm_encoder_forget_cursor_(struct TCOD_XtermEncoder* encoder) {
+  encoder->cursor_x = encoder->cursor_y = -1;
+}
+/// Ensure that at least `extra` more bytes can be written to the buffer of `encoder`.
+static TCOD_Error xterm_reserve(struct TCOD_XtermEncoder* encoder, size_t extra) {
+  if (encoder->length + extra <= encoder->capacity) return TCOD_E_OK;
+  size_t new_capacity = encoder->capacity ? encoder->capacity * 2 : 4096;
+  while (new_capacity < encoder->length + extra) new_capacity *= 2;
+  char* new_buffer = realloc(encoder->buffer, new_capacity);
+  if (!new_buffer) {
+    TCOD_set_errorv("Could not allocate memory.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  encoder->buffer = new_buffer;
+  encoder->capacity = new_capacity;
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_xterm_encoder_append_(struct TCOD_XtermEncoder* encoder, const char* data, size_t length) {
+  TCOD_Error err = xterm_reserve(encoder, length);
+  if (err < 0) return err;
+  memcpy(encoder->buffer + encoder->length, data, length);
+  encoder->length += length;
+  return TCOD_E_OK;
+}
+/// The default xterm colors of the 16 ANSI color indexes.
+static const TCOD_ColorRGB ANSI_16_PALETTE[16] = {
+    {0, 0, 0},
+    {205, 0, 0},
+    {0, 205, 0},
+    {205, 205, 0},
+    {0, 0, 238},
+    {205, 0, 205},
+    {0, 205, 205},
+    {229, 229, 229},
+    {127, 127, 127},
+    {255, 0, 0},
+    {0, 255, 0},
+    {255, 255, 0},
+    {92, 92, 255},
+    {255, 0, 255},
+    {0, 255, 255},
+    {255, 255, 255},
+};
+/// The channel levels of the 6x6x6 color cube at indexes 16 to 231 of the xterm 256 color palette.
+static const uint8_t CUBE_LEVELS[6] = {0, 95, 135, 175, 215, 255};
+/// A weighted squared distance between two colors, green differences are the most visible.
+static int color_distance(int r0, int g0, int b0, int r1, int g1, int b1) {
+  return 2 * (r0 - r1) * (r0 - r1) + 4 * (g0 - g1) * (g0 - g1) + 3 * (b0 - b1) * (b0 - b1);
+}
+/// Return the nearest cube level index of a channel.
+static int nearest_cube_level(int channel) {
+  int nearest = 0;
+  for (int i = 1; i < 6; ++i) {
+    if (abs(CUBE_LEVELS[i] - channel) < abs(CUBE_LEVELS[nearest] - channel)) nearest = i;
+  }
+  return nearest;
+}
+/// Return the nearest xterm 256 color index to a color, ignoring the terminal defined colors from 0 to 15.
+static uint8_t nearest_256_color(int r, int g, int b) {
+  const int cube_r = nearest_cube_level(r);
+  const int cube_g = nearest_cube_level(g);
+  const int cube_b = nearest_cube_level(b);
+  const int cube_distance =
+      color_distance(r, g, b, CUBE_LEVELS[cube_r], CUBE_LEVELS[cube_g], CUBE_LEVELS[cube_b]);
+  // The grayscale ramp at indexes 232 to 255 has the levels 8, 18, ..., 238.
+  const int gray_step = TCOD_CLAMP(0, 23, ((r + g + b) / 3 - 3) / 10);
+  const int gray = 8 + gray_step * 10;
+  if (color_distance(r, g, b, gray, gray, gray) < cube_distance) return (uint8_t)(232 + gray_step);
+  return (uint8_t)(16 + cube_r * 36 + cube_g * 6 + cube_b);
+}
+/// Return the nearest ANSI color index to a color.
+static uint8_t nearest_16_color(int r, int g, int b) {
+  int nearest = 0;
+  int nearest_distance = INT_MAX;
+  for (int i = 0; i < 16; ++i) {
+    const int distance = color_distance(r, g, b, ANSI_16_PALETTE[i].r, ANSI_16_PALETTE[i].g, ANSI_16_PALETTE[i].b);
+    if (distance < nearest_distance) {
+      nearest = i;
+      nearest_distance = distance;
+    }
+  }
+  return (uint8_t)nearest;
+}
+TCOD_Error TCOD_xterm_encoder_set_color_mode_(
+    struct TCOD_XtermEncoder* encoder, TCOD_XtermColorMode mode, bool dither) {
+  if (mode != TCOD_XTERM_COLOR_TRUECOLOR && mode != TCOD_XTERM_COLOR_256 && mode != TCOD_XTERM_COLOR_16) {
+    TCOD_set_errorvf("Unknown color mode: %i", (int)mode);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (mode != TCOD_XTERM_COLOR_TRUECOLOR && (mode != encoder->color_mode || !encoder->palette_lut)) {
+    if (!encoder->palette_lut) encoder->palette_lut = malloc(32768);
+    if (!encoder->palette_lut) {
+      TCOD_set_errorv("Could not allocate memory.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    for (int i = 0; i < 32768; ++i) {
+      // The center of the range of 8-bit colors which share these upper 5 bits.
+      const int r = ((i >> 10) << 3) | 4;
+      const int g = (((i >> 5) & 31) << 3) | 4;
+      const int b = ((i & 31) << 3) | 4;
+      encoder->palette_lut[i] = mode == TCOD_XTERM_COLOR_256 ? nearest_256_color(r, g, b) : nearest_16_color(r, g, b);
+    }
+  }
+  encoder->color_mode = mode;
+  encoder->dither = dither;
+  encoder->fg_known = encoder->bg_known = false;
+  return TCOD_E_OK;
+}
+/// A 4x4 Bayer matrix of ordered dither thresholds.
+static const uint8_t BAYER_4X4[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+/// Return the palette index of a color, `offset` is added to each channel first for dithering.
+static uint8_t quantize_color(const uint8_t* __restrict palette_lut, TCOD_ColorRGBA color, int offset) {
+  const int r = TCOD_CLAMP(0, 255, color.r + offset);
+  const int g = TCOD_CLAMP(0, 255, color.g + offset);
+  const int b = TCOD_CLAMP(0, 255, color.b + offset);
+  return palette_lut[((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)];
+}
+/**
+ *  Return row `y` of `console` with palette indexes in place of colors.
+ *
+ *  Returns NULL if memory could not be allocated.
+ */
+static const TCOD_ConsoleTile* quantize_row(struct TCOD_XtermEncoder* encoder, const TCOD_Console* console, int y) {
+  if (encoder->quantized_row_capacity < console->w) {
+    TCOD_ConsoleTile* new_row = realloc(encoder->quantized_row, sizeof(*new_row) * (size_t)console->w);
+    if (!new_row) {
+      TCOD_set_errorv("Could not allocate memory.");
+      return NULL;
+    }
+    encoder->quantized_row = new_row;
+    encoder->quantized_row_capacity = console->w;
+  }
+  // Dither offsets are spread over roughly one palette step.
+  const int spread = !encoder->dither ? 0 : encoder->color_mode == TCOD_XTERM_COLOR_256 ? 40 : 96;
+  const TCOD_ConsoleTile* __restrict row = &console->tiles[console->w * y];
+  TCOD_ConsoleTile* __restrict out = encoder->quantized_row;
+  for (int x = 0; x < console->w; ++x) {
+    const int offset = spread ? (BAYER_4X4[y & 3][x & 3] * 2 - 15) * spread / 32 : 0;
+    out[x].ch = row[x].ch;
+    out[x].fg = (TCOD_ColorRGBA){quantize_color(encoder->palette_lut, row[x].fg, offset), 0, 0, 255};
+    out[x].bg = (TCOD_ColorRGBA){quantize_color(encoder->palette_lut, row[x].bg, offset), 0, 0, 255};
+  }
+  return out;
+}
+/// Write the decimal digits of `value` to `out` and return the end of the written digits.
+static char* write_uint(char* out, unsigned value) {
+  char digits[10];
+  int count = 0;
+  do {
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (count) *out++ = digits[--count];
+  return out;
+}
+/// Write a control sequence with an optional numeric parameter, the parameter is omitted when it is the default of 1.
+static char* write_csi(char* out, unsigned value, char final) {
+  *out++ = '\x1b';
+  *out++ = '[';
+  if (value != 1) out = write_uint(out, value);
+  *out++ = final;
+  return out;
+}
+/// Write the shortest horizontal move from column `from_x` to `to_x` on the same row.
+static char* write_horizontal_move(char* out, int from_x, int to_x) {
+  if (to_x == from_x) return out;
+  if (to_x == 0) {
+    *out++ = '\r';
+    return out;
+  }
+  if (to_x > from_x) return write_csi(out, (unsigned)(to_x - from_x), 'C');
+  char backward[16];
+  char absolute[16];
+  const size_t backward_length = (size_t)(write_csi(backward, (unsigned)(from_x - to_x), 'D') - backward);
+  const size_t absolute_length = (size_t)(write_csi(absolute, (unsigned)(to_x + 1), 'G') - absolute);
+  if (backward_length <= absolute_length) {
+    memcpy(out, backward, backward_length);
+    return out + backward_length;
+  }
+  memcpy(out, absolute, absolute_length);
+  return out + absolute_length;
+}
+/// Write the shortest cursor move to `x`,`y` into `out` and return the end of the written sequence.
+static char* write_cursor_move(const struct TCOD_XtermEncoder* encoder, char* out, int x, int y) {
+  char absolute[32] = "\x1b[";
+  char* absolute_end = absolute + 2;
+  if (x > 0 || y > 0) absolute_end = write_uint(absolute_end, (unsigned)y + 1);
+  if (x > 0) {
+    *absolute_end++ = ';';
+    absolute_end = write_uint(absolute_end, (unsigned)x + 1);
+  }
+  *absolute_end++ = 'H';
+  const size_t absolute_length = (size_t)(absolute_end - absolute);
+  if (encoder->cursor_x >= 0 && encoder->cursor_y >= 0) {
+    char relative[48];
+    char* relative_end = relative;
+    const int dy = y - encoder->cursor_y;
+    // Line feeds are avoided since terminals with output post-processing also return the cursor to column 0.
+    if (dy > 0) {
+      relative_end = write_csi(relative_end, (unsigned)dy, 'B');
+    } else if (dy < 0) {
+      relative_end = write_csi(relative_end, (unsigned)-dy, 'A');
+    }
+    relative_end = write_horizontal_move(relative_end, encoder->cursor_x, x);
+    const size_t relative_length = (size_t)(relative_end - relative);
+    if (relative_length <= absolute_length) {
+      memcpy(out, relative, relative_length);
+      return out + relative_length;
+    }
+  }
+  memcpy(out, absolute, absolute_length);
+  return out + absolute_length;
+}
+/// Return the codepoint to print for a console glyph, control characters and invalid glyphs are shown as spaces.
+static int xterm_codepoint(int ch) {
+  if (ch < 0x20 || (0x7F <= ch && ch < 0xA0)) return ' ';
+  if (ch > 0x10FFFF) return '?';
+  return ch;
+}
+/// Write `codepoint` as UTF-8 and return the end of the written bytes.
+static char* write_utf8(char* out, int codepoint) {
+  if (codepoint <= 0x7F) {
+    *out++ = (char)codepoint;
+  } else if (codepoint <= 0x07FF) {
+    *out++ = (char)(0xC0 | (codepoint >> 6));
+    *out++ = (char)(0x80 | (codepoint & 0x3F));
+  } else if (codepoint <= 0xFFFF) {
+    *out++ = (char)(0xE0 | (codepoint >> 12));
+    *out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    *out++ = (char)(0x80 | (codepoint & 0x3F));
+  } else {
+    *out++ = (char)(0xF0 | (codepoint >> 18));
+    *out++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    *out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    *out++ = (char)(0x80 | (codepoint & 0x3F));
+  }
+  return out;
+}
+/// Return the length of `codepoint` encoded as UTF-8.
+static int utf8_length(int codepoint) {
+  return codepoint <= 0x7F ? 1 : codepoint <= 0x07FF ? 2 : codepoint <= 0xFFFF ? 3 : 4;
+}
+/// Compare the color channels of `a` and `b`, the terminal has no alpha channel.
+static bool color_equals(TCOD_ColorRGBA a, TCOD_ColorRGBA b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+/// Return true if `tile` would look the same when printed with the current terminal colors.
+static bool xterm_matches_colors(const struct TCOD_XtermEncoder* encoder, const TCOD_ConsoleTile* tile) {
+  if (!encoder->bg_known || !color_equals(encoder->bg, tile->bg)) return false;
+  return xterm_codepoint(tile->ch) == ' ' || (encoder->fg_known && color_equals(encoder->fg, tile->fg));
+}
+/// Write a color parameter for SGR, `selector` is 38 for the foreground or 48 for the background.
+static char* write_sgr_color(char* out, TCOD_XtermColorMode mode, unsigned selector, TCOD_ColorRGBA color) {
+  if (mode == TCOD_XTERM_COLOR_16) {
+    // Foreground colors are 30 to 37 and 90 to 97, background colors are 40 to 47 and 100 to 107.
+    const unsigned base = color.r < 8 ? selector - 8 : selector + 52;
+    return write_uint(out, base + (color.r & 7));
+  }
+  out = write_uint(out, selector);
+  if (mode == TCOD_XTERM_COLOR_256) {
+    *out++ = ';';
+    *out++ = '5';
+    *out++ = ';';
+    return write_uint(out, color.r);
+  }
+  *out++ = ';';
+  *out++ = '2';
+  *out++ = ';';
+  out = write_uint(out, color.r);
+  *out++ = ';';
+  out = write_uint(out, color.g);
+  *out++ = ';';
+  return write_uint(out, color.b);
+}
+/// Write the SGR parameters needed to print `tile`, parameters already in effect are skipped.
+static char* write_tile_colors(struct TCOD_XtermEncoder* encoder, char* out, const TCOD_ConsoleTile* tile) {
+  const bool set_bg = !encoder->bg_known || !color_equals(encoder->bg, tile->bg);
+  // The foreground color of a space is never seen.
+  const bool set_fg =
+      xterm_codepoint(tile->ch) != ' ' && (!encoder->fg_known || !color_equals(encoder->fg, tile->fg));
+  if (!set_bg && !set_fg) return out;
+  *out++ = '\x1b';
+  *out++ = '[';
+  if (set_fg) {
+    out = write_sgr_color(out, encoder->color_mode, 38, tile->fg);
+    encoder->fg = tile->fg;
+    encoder->fg_known = true;
+  }
+  if (set_fg && set_bg) *out++ = ';';
+  if (set_bg) {
+    out = write_sgr_color(out, encoder->color_mode, 48, tile->bg);
+    encoder->bg = tile->bg;
+    encoder->bg_known = true;
+  }
+  *out++ = 'm';
+  return out;
+}
+/**
+ *  Write the cursor movement to column `x` of `row`.
+ *
+ *  A short gap of unchanged tiles which match the current colors is printed again when that is shorter than moving
+ *  the cursor over them.
+ */
+static char* write_move_to_tile(
+    struct TCOD_XtermEncoder* encoder, char* out, const TCOD_ConsoleTile* row, int x, int y) {
+  const int gap = x - encoder->cursor_x;
+  if (encoder->cursor_y == y && encoder->cursor_x >= 0 && 0 < gap && gap <= XTERM_MAX_REPRINT) {
+    int reprint_length = 0;
+    for (int i = encoder->cursor_x; i < x && reprint_length >= 0; ++i) {
+      if (xterm_matches_colors(encoder, &row[i])) {
+        reprint_length += utf8_length(xterm_codepoint(row[i].ch));
+      } else {
+        reprint_length = -1;
+      }
+    }
+    const int move_length = gap == 1 ? 3 : 4;  // The length of "\x1b[C" or "\x1b[#C".
+    if (0 <= reprint_length && reprint_length < move_length) {
+      for (int i = encoder->cursor_x; i < x; ++i) out = write_utf8(out, xterm_codepoint(row[i].ch));
+      return out;
+    }
+  }
+  return write_cursor_move(encoder, out, x, y);
+}
+TCOD_Error TCOD_xterm_encode_frame_(
+    struct TCOD_XtermEncoder* __restrict encoder,
+    const TCOD_Console* __restrict console,
+    TCOD_Console* __restrict cache,
+    int columns,
+    int rows) {
+  const int terminal_columns = columns;
+  columns = TCOD_MIN(columns, console->w);
+  rows = TCOD_MIN(rows, console->h);
+  const struct TCOD_ConsoleDirty* console_rows = TCOD_console_observe_dirty_(console);
+  struct TCOD_ConsoleDirty* cache_rows = TCOD_console_get_dirty_(cache);
+  for (int y = 0; y < rows; ++y) {
+    if (TCOD_console_row_is_drawn_(console_rows, cache_rows, y)) continue;  // Skip rows without changes.
+    const TCOD_ConsoleTile* row = &console->tiles[console->w * y];
+    if (encoder->color_mode != TCOD_XTERM_COLOR_TRUECOLOR) {
+      row = quantize_row(encoder, console, y);
+      if (!row) return TCOD_E_OUT_OF_MEMORY;
+    }
+    TCOD_ConsoleTile* cache_row = &cache->tiles[console->w * y];
+    for (int x_begin = 0; x_begin < columns; x_begin += 64) {
+      const int chunk_length = TCOD_MIN(64, columns - x_begin);
+      uint64_t bg_changed;
+      uint64_t fg_changed;
+      TCOD_console_diff_tiles(&row[x_begin], &cache_row[x_begin], chunk_length, &bg_changed, &fg_changed);
+      uint64_t changed = bg_changed | fg_changed;
+      if (!changed) continue;
+      TCOD_Error err = xterm_reserve(encoder, (size_t)chunk_length * XTERM_MAX_TILE_BYTES);
+      if (err < 0) return err;
+      char* out = encoder->buffer + encoder->length;
+      for (; changed; changed &= changed - 1) {
+        const int x = x_begin + TCOD_lowest_bit_(changed);
+        const TCOD_ConsoleTile* tile = &row[x];
+        out = write_move_to_tile(encoder, out, row, x, y);
+        out = write_tile_colors(encoder, out, tile);
+        out = write_utf8(out, xterm_codepoint(tile->ch));
+        cache_row[x] = *tile;
+        encoder->cursor_x = x + 1;
+        encoder->cursor_y = y;
+        // Printing the last column leaves the cursor in an implementation defined wrapping state.
+        if (encoder->cursor_x >= terminal_columns) encoder->cursor_x = encoder->cursor_y = -1;
+      }
+      encoder->length = (size_t)(out - encoder->buffer);
+    }
+    // Columns past the edge of the terminal are still undrawn.
+    if (columns == console->w) TCOD_console_row_set_drawn_(console_rows, cache_rows, y);
+  }
+  return TCOD_E_OK;
+}
@@ -41,6 +41,7 @@
 
 #include "libtcod_int.h"
 #include "sys.h"
+#include "utility.h"
 #include "version.h"
 #ifdef TCOD_WINDOWS
 #define NOMINMAX 1
@@ -123,7 +124,7 @@ static void TCOD_sys_map_clone_(int new_codepoint, int old_codepoint) {
   if (old_codepoint >= TCOD_ctx.tileset->character_map_length) {
     return;
   }
-  TCOD_sys_map_ascii_to_font(new_codepoint, TCOD_ctx.tileset->character_map[old_codepoint], 0);
+  TCOD_sys_map_ascii_to_font(new_codepoint, TCOD_tileset_get_tile_id(TCOD_ctx.tileset, old_codepoint), 0);
 }
 /**
     Decode the font layout depending on the current flags.
@@ -280,6 +281,13 @@ TCOD_list_t TCOD_sys_get_directory_content(const char* path, const char* pattern
 int TCOD_sys_get_num_cores(void) {
 #ifndef NO_SDL
   return SDL_GetNumLogicalCPUCores();
+#elif defined(TCOD_WINDOWS)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
 #else
   return 1;
 #endif  // NO_SDL
@@ -324,7 +332,7 @@ TCOD_mutex_t TCOD_mutex_new() {
 #else
   static pthread_mutex_t tmp = PTHREAD_MUTEX_INITIALIZER;
   pthread_mutex_t* mut = calloc(1, sizeof(pthread_mutex_t));
-  *mut = tmp;
+  if (mut) *mut = tmp;
   return (TCOD_mutex_t)mut;
 #endif
 }
@@ -506,7 +514,92 @@ void TCOD_condition_delete(TCOD_cond_t p_cond) {
   }
 #endif
 }
+/**
+    Counts the running workers of TCOD_parallel_for.
+
+    Semaphores are not used since unnamed POSIX semaphores are unsupported on macOS.
+ */
+typedef struct ParallelWait {
+  TCOD_mutex_t mutex;
+  TCOD_cond_t finished;  // Signaled when `running` reaches zero.
+  int running;
+} ParallelWait;
+/**
+    A slice of work for TCOD_parallel_for.
+ */
+typedef struct ParallelJob {
+  TCOD_ParallelFunc func;
+  void* userdata;
+  int begin;
+  int end;
+  ParallelWait* wait;
+} ParallelJob;
+static int parallel_worker(void* job_ptr) {
+  const ParallelJob* job = job_ptr;
+  ParallelWait* wait = job->wait;
+  job->func(job->userdata, job->begin, job->end);
+  TCOD_mutex_in(wait->mutex);
+  if (--wait->running == 0) TCOD_condition_signal(wait->finished);
+  TCOD_mutex_out(wait->mutex);  // `job` and `wait` may be gone once this is released.
+  return 0;
+}
+#endif  // TCOD_NO_THREADS
+/// The most threads used by TCOD_parallel_for, or 0 to use the number of cores.
+static int g_parallel_max_threads = 0;
+void TCOD_parallel_set_max_threads_(int max_threads) { g_parallel_max_threads = TCOD_MAX(0, max_threads); }
+void TCOD_parallel_for(int count, int grain, TCOD_ParallelFunc func, void* userdata) {
+  if (count <= 0) return;
+  if (grain < 1) grain = 1;
+  int threads = 1;
+#ifndef TCOD_NO_THREADS
+  enum { MAX_THREADS = 64 };
+  threads = g_parallel_max_threads ? g_parallel_max_threads : TCOD_sys_get_num_cores();
+  threads = TCOD_CLAMP(1, MAX_THREADS, threads);
+  threads = TCOD_MIN(threads, count / grain);
 #endif  // TCOD_NO_THREADS
+  if (threads <= 1) {
+    func(userdata, 0, count);
+    return;
+  }
+#ifndef TCOD_NO_THREADS
+  ParallelWait wait = {TCOD_mutex_new(), TCOD_condition_new(), 0};
+  const bool can_start = wait.mutex && wait.finished;  // Otherwise every slice is run here.
+  // Round each slice up to a multiple of grain.
+  const int slice = ((count + threads - 1) / threads + grain - 1) / grain * grain;
+  ParallelJob jobs[MAX_THREADS];
+  TCOD_thread_t handles[MAX_THREADS];
+  int started = 0;
+  int begin = 0;
+  for (int i = 0; begin < count; ++i) {
+    jobs[i] = (ParallelJob){func, userdata, begin, TCOD_MIN(count, begin + slice), &wait};
+    begin = jobs[i].end;
+    bool is_started = false;
+    if (begin < count && can_start) {
+      TCOD_mutex_in(wait.mutex);
+      ++wait.running;
+      TCOD_mutex_out(wait.mutex);
+      is_started = (handles[started] = TCOD_thread_new(parallel_worker, &jobs[i])) != NULL;
+      if (is_started) {
+        ++started;
+      } else {
+        TCOD_mutex_in(wait.mutex);
+        --wait.running;
+        TCOD_mutex_out(wait.mutex);
+      }
+    }
+    if (!is_started) func(userdata, jobs[i].begin, jobs[i].end);  // Run the last slice, or any failed slice, here.
+  }
+  if (started) {
+    // The threads are detached, so wait until no worker can touch `jobs` or `userdata`.
+    TCOD_mutex_in(wait.mutex);
+    while (wait.running > 0) TCOD_condition_wait(wait.finished, wait.mutex);
+    TCOD_mutex_out(wait.mutex);
+  }
+  for (int i = 0; i < started; ++i) TCOD_thread_delete(handles[i]);
+  if (wait.finished) TCOD_condition_delete(wait.finished);
+  if (wait.mutex) TCOD_mutex_delete(wait.mutex);
+#endif  // TCOD_NO_THREADS
+}
 void TCOD_sys_get_fullscreen_offsets(int* offset_x, int* offset_y) {
   if (offset_x) *offset_x = TCOD_ctx.fullscreen_offset_x;
   if (offset_y) *offset_y = TCOD_ctx.fullscreen_offset_y;
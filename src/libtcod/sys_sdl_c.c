@@ -125,7 +125,10 @@ void TCOD_sys_update_char(int asciiCode, int font_x, int font_y, const TCOD_Imag
   if (TCOD_tileset_reserve(TCOD_ctx.tileset, tile_id + 1) < 0) {
     return;
   }
-  struct TCOD_ColorRGBA* tile_out = TCOD_ctx.tileset->pixels + tile_id * TCOD_ctx.tileset->tile_length;
+  struct TCOD_ColorRGBA* tile_out = malloc(sizeof(*tile_out) * TCOD_ctx.tileset->tile_length);
+  if (!tile_out) {
+    return;
+  }
   for (int px = 0; px < TCOD_ctx.tileset->tile_width; ++px) {
     for (int py = 0; py < TCOD_ctx.tileset->tile_height; ++py) {
       TCOD_color_t col = TCOD_image_get_pixel(img, x + px, y + py);
@@ -137,6 +140,12 @@ void TCOD_sys_update_char(int asciiCode, int font_x, int font_y, const TCOD_Imag
       *out = (TCOD_ColorRGBA){col.r, col.g, col.b, 255};
     }
   }
+  // The tileset may store alpha only, so its tiles are not written to directly.
+  const TCOD_Error err = TCOD_tileset_store_tile_(TCOD_ctx.tileset, tile_id, tile_out);
+  free(tile_out);
+  if (err < 0) {
+    return;
+  }
   TCOD_tileset_assign_tile(TCOD_ctx.tileset, tile_id, asciiCode);
   TCOD_tileset_notify_tile_changed(TCOD_ctx.tileset, tile_id);
 }
@@ -34,16 +34,157 @@
 #ifndef TCOD_NO_PNG
 #include <lodepng.h>
 #endif  // TCOD_NO_PNG
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif  // _MSC_VER
 
 #include "color.h"
+#include "libtcod_int.h"
+#include "sys.h"
+#include "tileset_cache.h"
+#include "utility.h"
 
 // Starting sizes of arrays:
 #define DEFAULT_TILES_LENGTH 256
-#define DEFAULT_CHARMAP_LENGTH 256
+#define DEFAULT_CHARMAP_PAGES 1
+// The highest page count which keeps `character_map_length` within an int.
+#define MAX_CHARMAP_PAGES (INT_MAX / TCOD_CHARMAP_PAGE_SIZE)
 
+/// The page shared by every unpopulated range of codepoints, this is never written to.
+static int empty_charmap_page[TCOD_CHARMAP_PAGE_SIZE];
+
+/// Lock `tileset` if it has ever had pending tiles.
+static void tileset_lock(const TCOD_Tileset* tileset) {
+#ifndef TCOD_NO_THREADS
+  if (tileset->pending_lock) TCOD_mutex_in(tileset->pending_lock);
+#else
+  (void)tileset;
+#endif  // TCOD_NO_THREADS
+}
+static void tileset_unlock(const TCOD_Tileset* tileset) {
+#ifndef TCOD_NO_THREADS
+  if (tileset->pending_lock) TCOD_mutex_out(tileset->pending_lock);
+#else
+  (void)tileset;
+#endif  // TCOD_NO_THREADS
+}
+/// Return true if `tile_id` is still waiting to be rendered.  Pairs with `clear_tile_pending`.
+static bool tile_is_pending(const TCOD_Tileset* tileset, int tile_id) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(&tileset->pending_tiles[tile_id], __ATOMIC_ACQUIRE) != 0;
+#else
+  return tileset->pending_tiles[tile_id] != 0;  // MSVC treats volatile reads as acquire loads.
+#endif
+}
+static void clear_tile_pending(TCOD_Tileset* tileset, int tile_id) {
+#if defined(__GNUC__) || defined(__clang__)
+  __atomic_store_n(&tileset->pending_tiles[tile_id], 0, __ATOMIC_RELEASE);
+#else
+  tileset->pending_tiles[tile_id] = 0;  // MSVC treats volatile writes as release stores.
+#endif
+}
+/// Return the RGBA view of an alpha-only tileset, or NULL if it was not made yet.  Pairs with `publish_rgba_view`.
+static const struct TCOD_ColorRGBA* load_rgba_view(const TCOD_Tileset* tileset) {
+  struct TCOD_ColorRGBA* const* pixels = (struct TCOD_ColorRGBA* const*)&tileset->pixels;
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(pixels, __ATOMIC_ACQUIRE);
+#else
+  return *(struct TCOD_ColorRGBA* const volatile*)pixels;  // MSVC treats volatile reads as acquire loads.
+#endif
+}
+/// Set the RGBA view of an alpha-only tileset unless another thread already did, returns false in that case.
+static bool publish_rgba_view(const TCOD_Tileset* tileset, struct TCOD_ColorRGBA* view) {
+  struct TCOD_ColorRGBA** pixels = (struct TCOD_ColorRGBA**)&tileset->pixels;
+#if defined(__GNUC__) || defined(__clang__)
+  struct TCOD_ColorRGBA* expected = NULL;
+  return __atomic_compare_exchange_n(pixels, &expected, view, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+  return _InterlockedCompareExchangePointer((void* volatile*)pixels, view, NULL) == NULL;
+#else
+  *pixels = view;
+  return true;
+#endif
+}
+/// Write `length` white pixels with the alpha values of `alpha` to `out`.
+static void expand_alpha(struct TCOD_ColorRGBA* __restrict out, const unsigned char* __restrict alpha, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    out[i] = (struct TCOD_ColorRGBA){255, 255, 255, alpha[i]};
+  }
+}
+/// Return true if every pixel of a tile is white or fully transparent.
+static bool tile_is_white(const TCOD_Tileset* tileset, const void* pixels, int stride) {
+  for (int y = 0; y < tileset->tile_height; ++y) {
+    const struct TCOD_ColorRGBA* row = (const void*)((const char*)pixels + (ptrdiff_t)y * stride);
+    for (int x = 0; x < tileset->tile_width; ++x) {
+      if (row[x].a != 0 && (row[x].r != 255 || row[x].g != 255 || row[x].b != 255)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+/**
+    Make the RGBA view of an alpha-only tileset if it does not exist yet.  The tileset must be locked.
+
+    Tilesets without pending tiles have no lock, in that case the first thread to finish its view keeps it.
+ */
+TCOD_NODISCARD
+static TCOD_Error make_rgba_view_locked(const TCOD_Tileset* tileset) {
+  if (load_rgba_view(tileset)) {
+    return TCOD_E_OK;
+  }
+  const size_t length = (size_t)tileset->tiles_capacity * tileset->tile_length;
+  struct TCOD_ColorRGBA* view = malloc(sizeof(*view) * length);
+  if (!view) {
+    TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  expand_alpha(view, tileset->alpha, length);
+  if (!publish_rgba_view(tileset, view)) {
+    free(view);  // Another thread made the view first.
+  }
+  return TCOD_E_OK;
+}
+/// Make the RGBA view of an alpha-only tileset, this is safe to call from multiple threads.
+TCOD_NODISCARD
+static TCOD_Error make_rgba_view(const TCOD_Tileset* tileset) {
+  if (load_rgba_view(tileset)) {
+    return TCOD_E_OK;
+  }
+  tileset_lock(tileset);  // Pending tiles must not be rendered while they are copied.
+  const TCOD_Error err = make_rgba_view_locked(tileset);
+  tileset_unlock(tileset);
+  return err;
+}
+/// Free the alpha of an alpha-only tileset, or release the cache file it was mapped from.
+static void free_alpha(TCOD_Tileset* tileset) {
+  if (tileset->pixels_mapping) {
+    TCOD_mapped_file_delete_(tileset->pixels_mapping);
+    tileset->pixels_mapping = NULL;
+  } else {
+    free(tileset->alpha);
+  }
+  tileset->alpha = NULL;
+}
+/**
+    Switch an alpha-only tileset to RGBA storage, its RGBA view becomes the tile storage.
+
+    The tileset must be locked.
+ */
+TCOD_NODISCARD
+static TCOD_Error expand_to_rgba(TCOD_Tileset* tileset) {
+  const TCOD_Error err = make_rgba_view_locked(tileset);
+  if (err < 0) {
+    return err;
+  }
+  free_alpha(tileset);
+  return TCOD_E_OK;
+}
 TCOD_Tileset* TCOD_tileset_new(int tile_width, int tile_height) {
   TCOD_Tileset* tileset = calloc(1, sizeof(*tileset));
   if (!tileset) {
@@ -66,41 +207,114 @@ void TCOD_tileset_delete(TCOD_Tileset* tileset) {
   while (tileset->observer_list) {
     TCOD_tileset_observer_delete(tileset->observer_list);
   }
-  free(tileset->pixels);
-  free(tileset->character_map);
+  if (tileset->alpha) {
+    free(tileset->pixels);  // The RGBA view.
+    free_alpha(tileset);
+  } else if (tileset->pixels_mapping) {
+    TCOD_mapped_file_delete_(tileset->pixels_mapping);
+  } else {
+    free(tileset->pixels);
+  }
+  const int pages_count = tileset->character_map_length / TCOD_CHARMAP_PAGE_SIZE;
+  for (int i = 0; i < pages_count; ++i) {
+    if (tileset->character_map_pages[i] != empty_charmap_page) {
+      free(tileset->character_map_pages[i]);
+    }
+  }
+  free(tileset->character_map_pages);
+  free((void*)tileset->pending_tiles);
+  free(tileset->batch_changed);
+#ifndef TCOD_NO_THREADS
+  if (tileset->pending_lock) TCOD_mutex_delete(tileset->pending_lock);
+#endif  // TCOD_NO_THREADS
   free(tileset);
 }
+void TCOD_tileset_lock_(const TCOD_Tileset* tileset) { tileset_lock(tileset); }
+void TCOD_tileset_unlock_(const TCOD_Tileset* tileset) { tileset_unlock(tileset); }
 struct TCOD_TilesetObserver* TCOD_tileset_observer_new(struct TCOD_Tileset* tileset) {
   if (!tileset) {
     return NULL;
   }
   struct TCOD_TilesetObserver* observer = calloc(1, sizeof(*observer));
+  if (!observer) {
+    return NULL;
+  }
   observer->tileset = tileset;
+  tileset_lock(tileset);
   observer->next = tileset->observer_list;
   tileset->observer_list = observer;
+  tileset_unlock(tileset);
   return observer;
 }
 void TCOD_tileset_observer_delete(struct TCOD_TilesetObserver* observer) {
   if (!observer) {
     return;
   }
+  tileset_lock(observer->tileset);
   for (struct TCOD_TilesetObserver** it = &observer->tileset->observer_list; *it; it = &(*it)->next) {
     if (*it != observer) {
       continue;
     }
     *it = observer->next;
+    // The callback may wait on threads which render pending tiles, so the lock is released first.
+    tileset_unlock(observer->tileset);
     if (observer->on_observer_delete) {
       observer->on_observer_delete(observer);
     }
     free(observer);
     return;
   }
-  return;
+  tileset_unlock(observer->tileset);
+}
+TCOD_Error TCOD_tileset_compact_alpha(TCOD_Tileset* tileset) {
+  if (!tileset) {
+    TCOD_set_errorv("Tileset argument must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (tileset->alpha || tileset->tile_length == 0) {
+    return TCOD_E_OK;
+  }
+  tileset_lock(tileset);
+  for (int tile_id = 0; tile_id < tileset->tiles_count; ++tile_id) {
+    const int stride = (int)sizeof(*tileset->pixels) * tileset->tile_width;
+    if (!tile_is_white(tileset, tileset->pixels + (size_t)tileset->tile_length * tile_id, stride)) {
+      tileset_unlock(tileset);
+      return TCOD_E_OK;  // This tileset has color.
+    }
+  }
+  // An empty tileset allocates its first tiles here, in the same way as TCOD_tileset_reserve.
+  const int capacity = tileset->tiles_capacity ? tileset->tiles_capacity : DEFAULT_TILES_LENGTH;
+  const size_t length = (size_t)capacity * tileset->tile_length;
+  unsigned char* alpha = calloc(length, 1);
+  if (!alpha) {
+    tileset_unlock(tileset);
+    TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  for (size_t i = 0; i < (size_t)tileset->tiles_capacity * tileset->tile_length; ++i) {
+    alpha[i] = tileset->pixels[i].a;
+  }
+  if (tileset->pixels_mapping) {
+    TCOD_mapped_file_delete_(tileset->pixels_mapping);
+    tileset->pixels_mapping = NULL;
+  } else {
+    free(tileset->pixels);
+  }
+  tileset->pixels = NULL;
+  tileset->alpha = alpha;
+  tileset->tiles_capacity = capacity;
+  if (tileset->tiles_count == 0) {
+    tileset->tiles_count = 1;  // Keep tile at zero blank.
+  }
+  tileset_unlock(tileset);
+  return TCOD_E_OK;
 }
 int TCOD_tileset_get_tile_width_(const TCOD_Tileset* tileset) { return tileset ? tileset->tile_width : 0; }
 int TCOD_tileset_get_tile_height_(const TCOD_Tileset* tileset) { return tileset ? tileset->tile_height : 0; }
 /**
- *  Reserve memory for the character mapping array.
+ *  Reserve top-level page entries so that codepoints up to `want` can be looked up.
+ *
+ *  New entries point to the shared empty page, pages are allocated when a codepoint is assigned.
  */
 TCOD_NODISCARD
 static TCOD_Error TCOD_tileset_charmap_reserve(TCOD_Tileset* tileset, int want) {
@@ -115,23 +329,26 @@ static TCOD_Error TCOD_tileset_charmap_reserve(TCOD_Tileset* tileset, int want)
   if (want <= tileset->character_map_length) {
     return TCOD_E_OK;
   }
-  int new_length = tileset->character_map_length;
-  if (new_length == 0) {
-    new_length = DEFAULT_CHARMAP_LENGTH;
+  const int old_pages = tileset->character_map_length / TCOD_CHARMAP_PAGE_SIZE;
+  const int want_pages = want / TCOD_CHARMAP_PAGE_SIZE + (want % TCOD_CHARMAP_PAGE_SIZE != 0);
+  if (want_pages > MAX_CHARMAP_PAGES) {
+    TCOD_set_errorv("Codepoint is too large for the character map.");
+    return TCOD_E_INVALID_ARGUMENT;
   }
-  while (want > new_length) {
-    new_length *= 2;
+  int new_pages = old_pages ? old_pages : DEFAULT_CHARMAP_PAGES;
+  while (want_pages > new_pages) {
+    new_pages = new_pages > MAX_CHARMAP_PAGES / 2 ? MAX_CHARMAP_PAGES : new_pages * 2;
   }
-  int* new_charmap = realloc(tileset->character_map, sizeof(int) * new_length);
-  if (!new_charmap) {
+  int** new_pages_array = realloc(tileset->character_map_pages, sizeof(*new_pages_array) * new_pages);
+  if (!new_pages_array) {
     TCOD_set_errorv("Could not allocate enough memory for the tileset.");
     return TCOD_E_OUT_OF_MEMORY;
   }
-  for (int i = tileset->character_map_length; i < new_length; ++i) {
-    new_charmap[i] = 0;
+  for (int i = old_pages; i < new_pages; ++i) {
+    new_pages_array[i] = empty_charmap_page;
   }
-  tileset->character_map_length = new_length;
-  tileset->character_map = new_charmap;
+  tileset->character_map_length = new_pages * TCOD_CHARMAP_PAGE_SIZE;
+  tileset->character_map_pages = new_pages_array;
   return TCOD_E_OK;
 }
 TCOD_Error TCOD_tileset_reserve(TCOD_Tileset* tileset, int want) {
@@ -156,37 +373,59 @@ TCOD_Error TCOD_tileset_reserve(TCOD_Tileset* tileset, int want) {
   if (new_capacity < want) {
     new_capacity = want;
   }
-  struct TCOD_ColorRGBA* new_pixels =
-      realloc(tileset->pixels, sizeof(tileset->pixels[0]) * new_capacity * tileset->tile_length);
-  if (!new_pixels) {
-    TCOD_set_errorv("Could not allocate enough memory for the tileset.");
-    return TCOD_E_OUT_OF_MEMORY;
+  const size_t old_length = (size_t)tileset->tiles_capacity * tileset->tile_length;
+  const size_t new_length = (size_t)new_capacity * tileset->tile_length;
+  if (tileset->alpha) {
+    // Alpha borrowed from a mapped cache file is moved to the heap before it can grow.
+    unsigned char* new_alpha = tileset->pixels_mapping ? malloc(new_length) : realloc(tileset->alpha, new_length);
+    if (!new_alpha) {
+      TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    if (tileset->pixels_mapping) {
+      memcpy(new_alpha, tileset->alpha, old_length);
+      TCOD_mapped_file_delete_(tileset->pixels_mapping);
+      tileset->pixels_mapping = NULL;
+    }
+    memset(new_alpha + old_length, 0, new_length - old_length);  // Clear allocated tiles.
+    tileset->alpha = new_alpha;
+    free(tileset->pixels);  // The RGBA view is made again when it is next requested.
+    tileset->pixels = NULL;
+  } else {
+    // Pixels borrowed from a mapped cache file are moved to the heap before they can grow.
+    struct TCOD_ColorRGBA* new_pixels = tileset->pixels_mapping
+                                            ? malloc(sizeof(*new_pixels) * new_length)
+                                            : realloc(tileset->pixels, sizeof(*new_pixels) * new_length);
+    if (!new_pixels) {
+      TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    if (tileset->pixels_mapping) {
+      memcpy(new_pixels, tileset->pixels, sizeof(*new_pixels) * old_length);
+      TCOD_mapped_file_delete_(tileset->pixels_mapping);
+      tileset->pixels_mapping = NULL;
+    }
+    for (size_t i = old_length; i < new_length; ++i) {
+      // Clear allocated tiles.
+      new_pixels[i] = (struct TCOD_ColorRGBA){0, 0, 0, 0};
+    }
+    tileset->pixels = new_pixels;
   }
-  for (int i = tileset->tiles_capacity * tileset->tile_length; i < new_capacity * tileset->tile_length; ++i) {
-    // Clear allocated tiles.
-    new_pixels[i] = (struct TCOD_ColorRGBA){0, 0, 0, 0};
+  if (tileset->pending_tiles) {
+    volatile unsigned char* new_pending = realloc((void*)tileset->pending_tiles, new_capacity);
+    if (!new_pending) {
+      TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    memset((void*)(new_pending + tileset->tiles_capacity), 0, new_capacity - tileset->tiles_capacity);
+    tileset->pending_tiles = new_pending;
   }
   tileset->tiles_capacity = new_capacity;
-  tileset->pixels = new_pixels;
   if (tileset->tiles_count == 0) {
     tileset->tiles_count = 1;  // Keep tile at zero blank.
   }
   return TCOD_E_OK;
 }
-/**
- *  Return the tile ID that `codepoint` is assigned to.
- *
- *  Returns 0 for unassigned codepoints.
- */
-static int TCOD_tileset_get_tile_id(const TCOD_Tileset* tileset, int codepoint) {
-  if (!tileset) {
-    return 0;
-  }
-  if (codepoint < 0 || codepoint >= tileset->character_map_length) {
-    return 0;
-  }
-  return tileset->character_map[codepoint];
-}
 int TCOD_tileset_assign_tile(struct TCOD_Tileset* tileset, int tile_id, int codepoint) {
   if (tile_id < 0 || tile_id >= tileset->tiles_count) {
     TCOD_set_errorv("Tile_ID is out of bounds.");
@@ -196,11 +435,27 @@ int TCOD_tileset_assign_tile(struct TCOD_Tileset* tileset, int tile_id, int code
     TCOD_set_errorv("Codepoint argument can not be negative.");
     return TCOD_E_INVALID_ARGUMENT;
   }
+  if (codepoint / TCOD_CHARMAP_PAGE_SIZE >= MAX_CHARMAP_PAGES) {
+    TCOD_set_errorvf("Codepoint %i is too large for the character map.", codepoint);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
   TCOD_Error err = TCOD_tileset_charmap_reserve(tileset, codepoint + 1);
   if (err < 0) {
     return err;
   }
-  tileset->character_map[codepoint] = tile_id;
+  int** page = &tileset->character_map_pages[codepoint / TCOD_CHARMAP_PAGE_SIZE];
+  if (*page == empty_charmap_page) {
+    if (tile_id == 0) {
+      return tile_id;  // Unassigned codepoints are already zero.
+    }
+    *page = calloc(TCOD_CHARMAP_PAGE_SIZE, sizeof(**page));
+    if (!*page) {
+      *page = empty_charmap_page;
+      TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+  }
+  (*page)[codepoint % TCOD_CHARMAP_PAGE_SIZE] = tile_id;
   return tile_id;
 }
 /**
@@ -224,7 +479,7 @@ static int TCOD_tileset_generate_tile(struct TCOD_Tileset* tileset) {
  *  Returns a negative value on error.
  */
 static int TCOD_tileset_generate_codepoint(struct TCOD_Tileset* tileset, int codepoint) {
-  int tile_id = TCOD_tileset_get_tile_id(tileset, codepoint);
+  int tile_id = tileset ? TCOD_tileset_get_tile_id(tileset, codepoint) : 0;
   if (tile_id != 0) {
     return tile_id;
   }
@@ -234,6 +489,82 @@ static int TCOD_tileset_generate_codepoint(struct TCOD_Tileset* tileset, int cod
   }
   return TCOD_tileset_assign_tile(tileset, tile_id, codepoint);
 }
+int TCOD_tileset_new_pending_tile_(TCOD_Tileset* tileset) {
+  if (!tileset) {
+    TCOD_set_errorv("Tileset argument must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (!tileset->pending_tiles) {
+    tileset->pending_tiles = calloc(TCOD_MAX(1, tileset->tiles_capacity), 1);
+    if (!tileset->pending_tiles) {
+      TCOD_set_errorv("Could not allocate enough memory for the tileset.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+#ifndef TCOD_NO_THREADS
+    tileset->pending_lock = TCOD_mutex_new();
+    if (!tileset->pending_lock) {
+      TCOD_set_errorv("Could not create a mutex for the tileset.");
+      return TCOD_E_ERROR;
+    }
+#endif  // TCOD_NO_THREADS
+  }
+  tileset_lock(tileset);
+  const int tile_id = TCOD_tileset_generate_tile(tileset);
+  if (tile_id > 0) {
+    tileset->pending_tiles[tile_id] = 1;
+  }
+  tileset_unlock(tileset);
+  return tile_id;
+}
+void TCOD_tileset_render_pending_tile_(TCOD_Tileset* tileset, int tile_id) {
+  tileset_lock(tileset);
+  if (tile_is_pending(tileset, tile_id)) {
+    // Alpha-only tilesets are rendered in place, RGBA tilesets are rendered to a temporary buffer and expanded.
+    unsigned char* alpha =
+        tileset->alpha ? tileset->alpha + (size_t)tileset->tile_length * tile_id : malloc(tileset->tile_length);
+    if (alpha) {
+      memset(alpha, 0, tileset->tile_length);
+      for (struct TCOD_TilesetObserver* it = tileset->observer_list; it; it = it->next) {
+        if (it->on_tile_requested && it->on_tile_requested(it, tile_id, alpha) >= 0) {
+          break;
+        }
+      }
+      if (tileset->pixels) {
+        expand_alpha(tileset->pixels + (size_t)tileset->tile_length * tile_id, alpha, tileset->tile_length);
+      }
+      if (!tileset->alpha) {
+        free(alpha);
+      }
+    }
+    clear_tile_pending(tileset, tile_id);
+  }
+  tileset_unlock(tileset);
+}
+/// Render `tile_id` if it is still pending.
+static void render_if_pending(const TCOD_Tileset* tileset, int tile_id) {
+  if (tileset->pending_tiles && tile_is_pending(tileset, tile_id)) {
+    // Rendering a pending tile does not change the tile from the point of view of the caller.
+    TCOD_tileset_render_pending_tile_((TCOD_Tileset*)tileset, tile_id);
+  }
+}
+const struct TCOD_ColorRGBA* TCOD_tileset_get_tile_pixels_(const TCOD_Tileset* tileset, int tile_id) {
+  render_if_pending(tileset, tile_id);
+  if (tileset->alpha && make_rgba_view(tileset) < 0) {
+    return NULL;
+  }
+  const struct TCOD_ColorRGBA* pixels = load_rgba_view(tileset);
+  if (!pixels) {
+    return NULL;  // No tiles were allocated.
+  }
+  return pixels + (size_t)tileset->tile_length * tile_id;
+}
+const unsigned char* TCOD_tileset_get_tile_alpha_(const TCOD_Tileset* tileset, int tile_id) {
+  if (!tileset->alpha) {
+    return NULL;
+  }
+  render_if_pending(tileset, tile_id);
+  return tileset->alpha + (size_t)tileset->tile_length * tile_id;
+}
 const struct TCOD_ColorRGBA* TCOD_tileset_get_tile(const TCOD_Tileset* tileset, int codepoint) {
   if (!tileset) {
     return NULL;
@@ -242,7 +573,7 @@ const struct TCOD_ColorRGBA* TCOD_tileset_get_tile(const TCOD_Tileset* tileset,
   if (tile_id < 0) {
     return NULL;  // No tile for the given codepoint in this tileset.
   }
-  return tileset->pixels + tileset->tile_length * tile_id;
+  return TCOD_tileset_get_tile_pixels_(tileset, tile_id);
 }
 TCOD_Error TCOD_tileset_get_tile_(
     const TCOD_Tileset* __restrict tileset, int codepoint, struct TCOD_ColorRGBA* __restrict buffer) {
@@ -250,44 +581,157 @@ TCOD_Error TCOD_tileset_get_tile_(
     TCOD_set_errorv("Tileset argument must not be NULL.");
     return TCOD_E_INVALID_ARGUMENT;
   }
-  const struct TCOD_ColorRGBA* tile = TCOD_tileset_get_tile(tileset, codepoint);
-  if (!tile) {
+  const int tile_id = TCOD_tileset_get_tile_id(tileset, codepoint);
+  // Alpha-only tiles are expanded directly, this avoids making the RGBA view of the whole tileset.
+  const unsigned char* alpha = TCOD_tileset_get_tile_alpha_(tileset, tile_id);
+  const struct TCOD_ColorRGBA* tile = alpha ? NULL : TCOD_tileset_get_tile_pixels_(tileset, tile_id);
+  if (!alpha && !tile) {
     TCOD_set_errorvf("Codepoint %i is not assigned to a tile in this tileset.", codepoint);
     return TCOD_E_INVALID_ARGUMENT;
   }
   if (!buffer) {
     return TCOD_E_OK;  // buffer is NULL, just return an OK status.
   }
-  memcpy(buffer, tile, sizeof(*tile) * tileset->tile_length);
+  if (alpha) {
+    expand_alpha(buffer, alpha, tileset->tile_length);
+  } else {
+    memcpy(buffer, tile, sizeof(*tile) * tileset->tile_length);
+  }
   return TCOD_E_OK;  // Tile exists and was copied to buffer.
 }
+/**
+    Add `tile_id` to the changes of the current batch.  Returns false if the batch could not be grown.
+ */
+static bool batch_add_tile(TCOD_Tileset* tileset, int tile_id) {
+  const int word = tile_id / 64;
+  if (word >= tileset->batch_changed_length) {
+    int new_length = TCOD_MAX(tileset->batch_changed_length * 2, 1);
+    while (new_length <= word) new_length *= 2;
+    uint64_t* new_changed = realloc(tileset->batch_changed, sizeof(*new_changed) * new_length);
+    if (!new_changed) {
+      return false;
+    }
+    memset(
+        new_changed + tileset->batch_changed_length,
+        0,
+        sizeof(*new_changed) * (new_length - tileset->batch_changed_length));
+    tileset->batch_changed = new_changed;
+    tileset->batch_changed_length = new_length;
+  }
+  tileset->batch_changed[word] |= (uint64_t)1 << (tile_id % 64);
+  return true;
+}
 void TCOD_tileset_notify_tile_changed(TCOD_Tileset* tileset, int tile_id) {
+  if (tileset->batch_depth > 0 && tile_id >= 0 && batch_add_tile(tileset, tile_id)) {
+    return;  // Observers are notified at the end of the batch.
+  }
   for (struct TCOD_TilesetObserver* it = tileset->observer_list; it; it = it->next) {
     if (it->on_tile_changed) {
       it->on_tile_changed(it, tile_id);
     }
   }
 }
+void TCOD_tileset_begin_batch(TCOD_Tileset* tileset) {
+  if (!tileset) {
+    return;
+  }
+  ++tileset->batch_depth;
+}
+void TCOD_tileset_end_batch(TCOD_Tileset* tileset) {
+  if (!tileset || tileset->batch_depth <= 0) {
+    return;
+  }
+  if (--tileset->batch_depth > 0) {
+    return;
+  }
+  int length = tileset->batch_changed_length;
+  while (length > 0 && !tileset->batch_changed[length - 1]) --length;
+  if (length == 0) {
+    return;  // Nothing changed.
+  }
+  for (struct TCOD_TilesetObserver* it = tileset->observer_list; it; it = it->next) {
+    if (it->on_tiles_changed) {
+      it->on_tiles_changed(it, tileset->batch_changed, length);
+      continue;
+    }
+    if (!it->on_tile_changed) {
+      continue;
+    }
+    for (int word = 0; word < length; ++word) {
+      for (uint64_t changed = tileset->batch_changed[word]; changed; changed &= changed - 1) {
+        it->on_tile_changed(it, word * 64 + TCOD_lowest_bit_(changed));
+      }
+    }
+  }
+  memset(tileset->batch_changed, 0, sizeof(*tileset->batch_changed) * length);
+}
+/**
+    Copy RGBA pixels into an existing tile, the tileset must be locked.
+ */
+TCOD_NODISCARD
+static TCOD_Error store_tile_locked(
+    TCOD_Tileset* __restrict tileset, int tile_id, const void* __restrict pixels, int stride) {
+  if (tileset->alpha && !tile_is_white(tileset, pixels, stride)) {
+    const TCOD_Error err = expand_to_rgba(tileset);  // Tiles with color need RGBA storage.
+    if (err < 0) {
+      return err;
+    }
+  }
+  for (int y = 0; y < tileset->tile_height; ++y) {
+    const char* ptr_in = pixels;
+    const struct TCOD_ColorRGBA* row_in = (const void*)(ptr_in + y * stride);
+    const size_t out_index = (size_t)tile_id * tileset->tile_length + (size_t)y * tileset->tile_width;
+    if (!tileset->alpha) {
+      memcpy(tileset->pixels + out_index, row_in, sizeof(*row_in) * tileset->tile_width);
+      continue;
+    }
+    for (int x = 0; x < tileset->tile_width; ++x) {
+      tileset->alpha[out_index + x] = row_in[x].a;
+      if (tileset->pixels) {
+        tileset->pixels[out_index + x] = (struct TCOD_ColorRGBA){255, 255, 255, row_in[x].a};
+      }
+    }
+  }
+  if (tileset->pending_tiles) {
+    clear_tile_pending(tileset, tile_id);  // Do not render over the new pixels later.
+  }
+  return TCOD_E_OK;
+}
 static TCOD_Error TCOD_tileset_set_tile_rgba(
     TCOD_Tileset* __restrict tileset, int codepoint, const void* __restrict pixels, int stride) {
-  int tile_id = TCOD_tileset_generate_codepoint(tileset, codepoint);
   if (!pixels) {
     TCOD_set_errorv("Pixels argument must not be NULL.");
     return TCOD_E_INVALID_ARGUMENT;
   }
+  tileset_lock(tileset);
+  int tile_id = TCOD_tileset_generate_codepoint(tileset, codepoint);
   if (tile_id < 0) {
+    tileset_unlock(tileset);
     return (TCOD_Error)tile_id;
   }
-  for (int y = 0; y < tileset->tile_height; ++y) {
-    const char* ptr_in = pixels;
-    const struct TCOD_ColorRGBA* row_in = (const void*)(ptr_in + y * stride);
-    for (int x = 0; x < tileset->tile_width; ++x) {
-      tileset->pixels[tile_id * tileset->tile_length + y * tileset->tile_width + x] = row_in[x];
-    }
+  const TCOD_Error err = store_tile_locked(tileset, tile_id, pixels, stride);
+  tileset_unlock(tileset);
+  if (err < 0) {
+    return err;
   }
   TCOD_tileset_notify_tile_changed(tileset, tile_id);
   return TCOD_E_OK;
 }
+TCOD_Error TCOD_tileset_store_tile_(
+    TCOD_Tileset* __restrict tileset, int tile_id, const struct TCOD_ColorRGBA* __restrict pixels) {
+  if (!tileset || !pixels) {
+    TCOD_set_errorv("Tileset and pixels must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (tile_id < 0 || tile_id >= tileset->tiles_capacity) {
+    TCOD_set_errorv("Tile_ID is out of bounds.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  tileset_lock(tileset);
+  const TCOD_Error err = store_tile_locked(tileset, tile_id, pixels, (int)sizeof(*pixels) * tileset->tile_width);
+  tileset_unlock(tileset);
+  return err;
+}
 TCOD_Error TCOD_tileset_set_tile_(
     TCOD_Tileset* __restrict tileset, int codepoint, const struct TCOD_ColorRGBA* __restrict buffer) {
   if (!tileset) {
@@ -384,6 +828,10 @@ TCOD_Tileset* TCOD_tileset_load_raw(
       return NULL;
     }
   }
+  if (TCOD_tileset_compact_alpha(tileset) < 0) {
+    TCOD_tileset_delete(tileset);
+    return NULL;
+  }
   return tileset;
 }
 #ifndef TCOD_NO_PNG
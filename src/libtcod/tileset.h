@@ -35,6 +35,7 @@
 #ifndef LIBTCOD_TILESET_H_
 #define LIBTCOD_TILESET_H_
 #include <stddef.h>
+#include <stdint.h>
 
 #include "color.h"
 #include "config.h"
@@ -45,12 +46,37 @@
 /// @{
 
 struct TCOD_Tileset;
+/// The number of low codepoint bits which index into a single page of a tilesets character map.
+#define TCOD_CHARMAP_PAGE_BITS 8
+/// The number of codepoints covered by a single page of a tilesets character map.
+#define TCOD_CHARMAP_PAGE_SIZE (1 << TCOD_CHARMAP_PAGE_BITS)
 struct TCOD_TilesetObserver {
   struct TCOD_Tileset* tileset;
   struct TCOD_TilesetObserver* next;
   void* userdata;
   void (*on_observer_delete)(struct TCOD_TilesetObserver* observer);
   int (*on_tile_changed)(struct TCOD_TilesetObserver* observer, int tile_id);
+  /**
+      Called once at the end of a batch with every tile changed during it, see `TCOD_tileset_begin_batch`.
+
+      Bit `tile_id % 64` of `changed[tile_id / 64]` is set for each changed tile, `length` is the number of words.
+      If this is NULL then `on_tile_changed` is called for each changed tile instead.
+      \rst
+      .. versionadded:: Unreleased
+      \endrst
+   */
+  int (*on_tiles_changed)(struct TCOD_TilesetObserver* observer, const uint64_t* changed, int length);
+  /**
+      Called when a pending tile is read for the first time, this should write the alpha of each pixel to `alpha`.
+
+      Pending tiles are always white.  `alpha` is zeroed before this is called.
+      Return a negative value if this observer does not render `tile_id`.
+      This is called with the tileset lock held and may be called from any thread.
+      \rst
+      .. versionadded:: Unreleased
+      \endrst
+   */
+  int (*on_tile_requested)(struct TCOD_TilesetObserver* observer, int tile_id, unsigned char* alpha);
 };
 /**
     @brief A container for libtcod tileset graphics.
@@ -63,12 +89,54 @@ struct TCOD_Tileset {
   int tile_length;
   int tiles_capacity;
   int tiles_count;
+  /**
+      The RGBA pixels of every tile.
+
+      When `alpha` is set this is a view of those tiles which is NULL until it is first requested,
+      use `TCOD_tileset_get_tile` instead of reading this directly.
+   */
   struct TCOD_ColorRGBA* __restrict pixels;
+  /**
+      One past the highest codepoint which `character_map_pages` can look up, a multiple of `TCOD_CHARMAP_PAGE_SIZE`.
+   */
   int character_map_length;
-  int* __restrict character_map;
+  /**
+      A two-level map of codepoints to tile IDs, use `TCOD_tileset_get_tile_id` to look up a codepoint.
+
+      Each page maps `TCOD_CHARMAP_PAGE_SIZE` codepoints.
+      Pages without any assigned codepoints all point to one shared page of zeros.
+      \rst
+      .. versionadded:: Unreleased
+      \endrst
+   */
+  int** __restrict character_map_pages;
   struct TCOD_TilesetObserver* observer_list;
   int virtual_columns;
   volatile int ref_count;
+  /** Internal use only.  Nonzero for tiles which are rendered when first read, NULL if no tile was ever pending. */
+  volatile unsigned char* pending_tiles;
+  /** Internal use only.  Guards pending tiles, pixels, and observers once a tile is pending or alpha is used. */
+  void* pending_lock;
+  /**
+      Internal use only.  The mapped cache file which `alpha`, or `pixels` when `alpha` is NULL, points into.
+      NULL if tiles are on the heap.
+   */
+  struct TCOD_MappedFile* pixels_mapping;
+  /**
+      The alpha of every pixel when all tiles are white, stored with one byte per pixel.  NULL if tiles are RGBA.
+
+      See `TCOD_tileset_compact_alpha`.
+      \rst
+      .. versionadded:: Unreleased
+      \endrst
+   */
+  unsigned char* __restrict alpha;
+  /** Internal use only.  The number of unfinished `TCOD_tileset_begin_batch` calls. */
+  int batch_depth;
+  /** Internal use only.  A bitset of the tiles changed during the current batch, NULL if none were. */
+  uint64_t* batch_changed;
+  /** Internal use only.  The number of 64-bit words in `batch_changed`. */
+  int batch_changed_length;
 };
 typedef struct TCOD_Tileset TCOD_Tileset;
 // clang-format off
@@ -272,20 +340,70 @@ TCOD_PUBLIC TCOD_Tileset* TCOD_tileset_load_raw(
  */
 TCOD_NODISCARD
 TCOD_PUBLIC int TCOD_tileset_assign_tile(struct TCOD_Tileset* tileset, int tile_id, int codepoint);
+/**
+    Return the tile ID assigned to `codepoint`, or 0 if `codepoint` is not assigned to a tile.
+
+    `tileset` must not be NULL.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+static inline int TCOD_tileset_get_tile_id(const struct TCOD_Tileset* __restrict tileset, int codepoint) {
+  // Negative codepoints become large unsigned values, so one comparison handles both bounds.
+  if ((unsigned)codepoint >= (unsigned)tileset->character_map_length) return 0;
+  return tileset->character_map_pages[codepoint >> TCOD_CHARMAP_PAGE_BITS][codepoint & (TCOD_CHARMAP_PAGE_SIZE - 1)];
+}
 /**
  *  Return a pointer to the tile for `codepoint`.
  *
  *  Returns NULL if no tile exists for codepoint.
+ *
+ *  The pointer is valid until the tileset is modified.
  */
 TCOD_NODISCARD
 TCOD_PUBLIC const struct TCOD_ColorRGBA* TCOD_tileset_get_tile(const TCOD_Tileset* tileset, int codepoint);
+/**
+    Store the tiles of `tileset` as one byte of alpha per pixel if every tile is white.
+
+    Pixels which are fully transparent are ignored and are read back as transparent white.
+    This does nothing if any tile has color.  Setting a tile with color later moves the tileset back to RGBA.
+
+    Alpha-only tilesets use a quarter of the memory of RGBA tilesets.
+    `TCOD_tileset_get_tile` still returns RGBA pixels, an RGBA copy of the tileset is made the first time it is called.
+
+    Returns a negative value on error, the tileset is left unchanged in that case.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_NODISCARD
+TCOD_PUBLIC TCOD_Error TCOD_tileset_compact_alpha(TCOD_Tileset* tileset);
+/**
+    Start collecting tile changes instead of notifying observers of each one.
+
+    Observers such as context atlases and cache consoles are notified once when the matching
+    `TCOD_tileset_end_batch` is called, use this around bulk changes to a tileset which is in use.
+    Batches can be nested, only the outermost batch notifies observers.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_tileset_begin_batch(TCOD_Tileset* tileset);
+/**
+    Finish a batch started by `TCOD_tileset_begin_batch`, notifying observers of every tile changed during it.
+
+    Calls without a matching `TCOD_tileset_begin_batch` are ignored.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC void TCOD_tileset_end_batch(TCOD_Tileset* tileset);
 /**
  *  Return a new observer to this tileset.
  *
  *  For internal use.
  */
-TCOD_NODISCARD
-struct TCOD_TilesetObserver* TCOD_tileset_observer_new(struct TCOD_Tileset* tileset);
+TCOD_PUBLIC TCOD_NODISCARD struct TCOD_TilesetObserver* TCOD_tileset_observer_new(struct TCOD_Tileset* tileset);
 /**
  *  Delete an existing observer.
  *
@@ -293,7 +411,7 @@ struct TCOD_TilesetObserver* TCOD_tileset_observer_new(struct TCOD_Tileset* tile
  *
  *  For internal use.
  */
-void TCOD_tileset_observer_delete(struct TCOD_TilesetObserver* observer);
+TCOD_PUBLIC void TCOD_tileset_observer_delete(struct TCOD_TilesetObserver* observer);
 /**
  *  Called to notify any observers that a tile has been changed.  This may
  *  cause running atlases to update or mark cache consoles as dirty.
@@ -301,6 +419,63 @@ void TCOD_tileset_observer_delete(struct TCOD_TilesetObserver* observer);
  *  For internal use.
  */
 void TCOD_tileset_notify_tile_changed(TCOD_Tileset* tileset, int tile_id);
+/**
+ *  Copy RGBA `pixels` into the tile at `tile_id`, which must have been reserved.
+ *
+ *  Observers are not notified, call `TCOD_tileset_notify_tile_changed` afterwards.
+ *
+ *  For internal use.
+ */
+TCOD_NODISCARD
+TCOD_Error TCOD_tileset_store_tile_(
+    TCOD_Tileset* __restrict tileset, int tile_id, const struct TCOD_ColorRGBA* __restrict pixels);
+/**
+ *  Lock the observer list and pending tiles of `tileset`.  Does nothing if the tileset never had a pending tile.
+ *
+ *  For internal use.
+ */
+void TCOD_tileset_lock_(const TCOD_Tileset* tileset);
+/**
+ *  Unlock a tileset locked with `TCOD_tileset_lock_`.
+ *
+ *  For internal use.
+ */
+void TCOD_tileset_unlock_(const TCOD_Tileset* tileset);
+/**
+ *  Add a blank tile which is rendered by an observers `on_tile_requested` callback the first time it is read.
+ *
+ *  Returns the new tile ID, or a negative value on error.
+ *
+ *  For internal use.
+ */
+TCOD_PUBLIC TCOD_NODISCARD int TCOD_tileset_new_pending_tile_(TCOD_Tileset* tileset);
+/**
+ *  Render `tile_id` with the first observer which accepts it if the tile is still pending.
+ *
+ *  The tile is left blank if no observer renders it.  This is safe to call from any thread.
+ *
+ *  For internal use.
+ */
+void TCOD_tileset_render_pending_tile_(TCOD_Tileset* tileset, int tile_id);
+/**
+ *  Return the pixels of `tile_id`, rendering the tile first if it is still pending.
+ *
+ *  This is safe to call from multiple threads as long as the tileset is not being modified.
+ *
+ *  For internal use.
+ */
+TCOD_NODISCARD
+const struct TCOD_ColorRGBA* TCOD_tileset_get_tile_pixels_(const TCOD_Tileset* tileset, int tile_id);
+/**
+ *  Return the alpha of `tile_id` if `tileset` is alpha-only, rendering the tile first if it is still pending.
+ *
+ *  Returns NULL if the tileset is RGBA, use `TCOD_tileset_get_tile_pixels_` in that case.
+ *  This is safe to call from multiple threads as long as the tileset is not being modified.
+ *
+ *  For internal use.
+ */
+TCOD_NODISCARD
+const unsigned char* TCOD_tileset_get_tile_alpha_(const TCOD_Tileset* tileset, int tile_id);
 /**
  *  Reserve memory for a specific amount of tiles.
  *
@@ -295,6 +295,10 @@ static int parse_bdf(struct BDFLoader* loader) {
       if (!loader->tileset) {
         return -1;
       }
+      // BDF glyphs are white, so only their alpha is stored.
+      if (TCOD_tileset_compact_alpha(loader->tileset) < 0) {
+        return -1;
+      }
     } else if (check_keyword(loader, "METRICSSET") == 0) {
       // Ignore.
     } else if (check_keyword(loader, "STARTPROPERTIES") == 0) {
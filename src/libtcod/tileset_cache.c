@@ -0,0 +1,488 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tileset_cache.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "error.h"
+#include "logging.h"
+#include "portability.h"
+#include "tileset_bdf.h"
+#include "tileset_truetype.h"
+#ifdef TCOD_WINDOWS
+#define NOMINMAX 1
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // TCOD_WINDOWS
+
+TCOD_NODISCARD unsigned char* TCOD_load_binary_file_(const char* path, size_t* size);
+
+/*
+    Cache file layout, all values are little-endian:
+
+    - `struct CacheHeader`.
+    - `charmap_count` codepoint and tile ID pairs sorted by codepoint.
+    - Zero padding up to a multiple of CACHE_ALIGNMENT.
+    - `tiles_count` tiles of RGBA or 8-bit alpha pixels, starting at `pixels_offset`.
+
+    `content_hash` covers everything after the header.
+ */
+#define CACHE_MAGIC "TCODTSC"
+enum {
+  CACHE_VERSION = 1,
+  CACHE_BYTE_ORDER_MARK = 0x01020304,  // Caches are only loaded on hosts with the same byte order.
+  CACHE_ALIGNMENT = 64,  // Pixels are aligned so that they can be used directly from a mapped file.
+  CACHE_MAX_TILE_SIZE = 4096,
+};
+enum CachePixelFormat {
+  CACHE_PIXELS_RGBA = 0,
+  CACHE_PIXELS_ALPHA = 1,  // Only alpha is stored, pixels are loaded as white.
+};
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t pixel_format;
+  int32_t tile_width;
+  int32_t tile_height;
+  int32_t tiles_count;
+  int32_t charmap_count;
+  uint32_t reserved;
+  uint64_t source_hash;
+  uint64_t content_hash;
+  uint64_t charmap_offset;
+  uint64_t pixels_offset;
+  uint64_t file_size;
+};
+struct CacheCharmapEntry {
+  int32_t codepoint;
+  int32_t tile_id;
+};
+/**
+ *  Mix one 64-bit word into `hash`.
+ */
+static uint64_t hash_mix(uint64_t hash, uint64_t word) {
+  hash ^= word * 0xBF58476D1CE4E5B9ull;
+  hash = (hash << 31 | hash >> 33) * 0x94D049BB133111EBull;
+  return hash;
+}
+/**
+ *  Hash `size` bytes of `data` eight bytes at a time, continuing from `hash`.
+ */
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = data;
+  for (; size >= 8; size -= 8, bytes += 8) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    hash = hash_mix(hash, word);
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, bytes, size);
+  hash = hash_mix(hash, tail ^ ((uint64_t)size << 56));
+  return hash ^ (hash >> 32);
+}
+/*****************************************************************************
+    Memory mapped files.
+ */
+struct TCOD_MappedFile {
+  unsigned char* data;
+  size_t size;
+#ifdef TCOD_WINDOWS
+  HANDLE mapping;
+#endif  // TCOD_WINDOWS
+};
+/**
+ *  Map a file privately, so that its memory can be written to without changing the file.
+ *
+ *  Returns NULL on failure.
+ */
+TCOD_NODISCARD
+static struct TCOD_MappedFile* mapped_file_open(const char* path) {
+  struct TCOD_MappedFile* file = calloc(1, sizeof(*file));
+  if (!file) {
+    TCOD_set_errorv("Out of memory.");
+    return NULL;
+  }
+#ifdef TCOD_WINDOWS
+  HANDLE handle = CreateFileA(
+      path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER size;
+  if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &size) || size.QuadPart <= 0) {
+    if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+    free(file);
+    TCOD_set_errorvf("Could not open file:\n%s", path);
+    return NULL;
+  }
+  file->size = (size_t)size.QuadPart;
+  file->mapping = CreateFileMappingA(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(handle);
+  file->data = file->mapping ? MapViewOfFile(file->mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+  if (!file->data) {
+    if (file->mapping) CloseHandle(file->mapping);
+    free(file);
+    TCOD_set_errorvf("Could not map file:\n%s", path);
+    return NULL;
+  }
+#else
+  const int fd = open(path, O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0) {
+    if (fd >= 0) close(fd);
+    free(file);
+    TCOD_set_errorvf("Could not open file:\n%s", path);
+    return NULL;
+  }
+  file->size = (size_t)info.st_size;
+  void* data = mmap(NULL, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    free(file);
+    TCOD_set_errorvf("Could not map file:\n%s", path);
+    return NULL;
+  }
+  file->data = data;
+#endif  // TCOD_WINDOWS
+  return file;
+}
+void TCOD_mapped_file_delete_(struct TCOD_MappedFile* file) {
+  if (!file) {
+    return;
+  }
+#ifdef TCOD_WINDOWS
+  UnmapViewOfFile(file->data);
+  CloseHandle(file->mapping);
+#else
+  munmap(file->data, file->size);
+#endif  // TCOD_WINDOWS
+  free(file);
+}
+/*****************************************************************************
+    Tileset sources.
+ */
+TCOD_Tileset* TCOD_tileset_load_source(const TCOD_TilesetSource* source) {
+  if (!source || !source->path) {
+    TCOD_set_errorv("Source and its path must not be NULL.");
+    return NULL;
+  }
+  switch (source->type) {
+    case TCOD_TILESET_SOURCE_TILESHEET:
+#ifndef TCOD_NO_PNG
+      return TCOD_tileset_load(source->path, source->columns, source->rows, source->charmap_length, source->charmap);
+#else
+      TCOD_set_errorv("libtcod was built without PNG support.");
+      return NULL;
+#endif  // TCOD_NO_PNG
+    case TCOD_TILESET_SOURCE_TRUETYPE:
+      return TCOD_load_truetype_font_(source->path, source->tile_width, source->tile_height);
+    case TCOD_TILESET_SOURCE_BDF:
+      return TCOD_load_bdf(source->path);
+    default:
+      TCOD_set_errorvf("Unknown tileset source type %i.", (int)source->type);
+      return NULL;
+  }
+}
+TCOD_Error TCOD_tileset_source_hash(const TCOD_TilesetSource* source, uint64_t* hash_out) {
+  if (!source || !source->path || !hash_out) {
+    TCOD_set_errorv("Source, its path, and hash_out must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (source->charmap_length > 0 && !source->charmap) {
+    TCOD_set_errorv("Charmap must not be NULL when charmap_length is nonzero.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  size_t size = 0;
+  unsigned char* data = TCOD_load_binary_file_(source->path, &size);
+  if (!data) {
+    return TCOD_E_ERROR;
+  }
+  // Only parameters which affect the loaded tileset are hashed.
+  int32_t params[4] = {(int32_t)source->type, CACHE_VERSION, 0, 0};
+  if (source->type == TCOD_TILESET_SOURCE_TILESHEET) {
+    params[2] = source->columns;
+    params[3] = source->rows;
+  } else if (source->type == TCOD_TILESET_SOURCE_TRUETYPE) {
+    params[2] = source->tile_width;
+    params[3] = source->tile_height;
+  }
+  uint64_t hash = hash_bytes(0, params, sizeof(params));
+  if (source->type == TCOD_TILESET_SOURCE_TILESHEET && source->charmap_length > 0) {
+    hash = hash_bytes(hash, source->charmap, sizeof(*source->charmap) * source->charmap_length);
+  }
+  hash = hash_bytes(hash, data, size);
+  free(data);
+  *hash_out = hash ? hash : 1;  // Zero means that no source hash was given.
+  return TCOD_E_OK;
+}
+/*****************************************************************************
+    Saving and loading caches.
+ */
+/**
+ *  Return true if every pixel of `tileset` is white or fully transparent.
+ */
+static bool tileset_is_alpha_only(const TCOD_Tileset* tileset) {
+  if (tileset->alpha) {
+    return true;
+  }
+  for (int tile_id = 0; tile_id < tileset->tiles_count; ++tile_id) {
+    const struct TCOD_ColorRGBA* pixels = TCOD_tileset_get_tile_pixels_(tileset, tile_id);
+    for (int i = 0; i < tileset->tile_length; ++i) {
+      if (pixels[i].a != 0 && (pixels[i].r != 255 || pixels[i].g != 255 || pixels[i].b != 255)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+/**
+ *  Write `size` bytes to a temporary file and then move it to `path`.
+ */
+TCOD_NODISCARD
+static TCOD_Error write_file_atomically(const char* path, const void* data, size_t size) {
+  const size_t path_length = strlen(path);
+  char* tmp_path = malloc(path_length + 5);
+  if (!tmp_path) {
+    TCOD_set_errorv("Out of memory.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  memcpy(tmp_path, path, path_length);
+  memcpy(tmp_path + path_length, ".tmp", 5);
+  FILE* file = fopen(tmp_path, "wb");
+  if (!file) {
+    TCOD_set_errorvf("Could not open file for writing:\n%s", tmp_path);
+    free(tmp_path);
+    return TCOD_E_ERROR;
+  }
+  const bool written = fwrite(data, 1, size, file) == size;
+  if (fclose(file) != 0 || !written) {
+    remove(tmp_path);
+    TCOD_set_errorvf("Could not write file:\n%s", tmp_path);
+    free(tmp_path);
+    return TCOD_E_ERROR;
+  }
+#ifdef TCOD_WINDOWS
+  const bool renamed = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  const bool renamed = rename(tmp_path, path) == 0;
+#endif  // TCOD_WINDOWS
+  if (!renamed) {
+    remove(tmp_path);
+    TCOD_set_errorvf("Could not replace file:\n%s", path);
+    free(tmp_path);
+    return TCOD_E_ERROR;
+  }
+  free(tmp_path);
+  return TCOD_E_OK;
+}
+TCOD_Error TCOD_tileset_save_cache(const TCOD_Tileset* tileset, const char* path, uint64_t source_hash) {
+  if (!tileset || !path) {
+    TCOD_set_errorv("Tileset and path must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (tileset->tile_width <= 0 || tileset->tile_height <= 0 || tileset->tile_width > CACHE_MAX_TILE_SIZE ||
+      tileset->tile_height > CACHE_MAX_TILE_SIZE) {
+    TCOD_set_errorvf("Tile size %ix%i can not be cached.", tileset->tile_width, tileset->tile_height);
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  const int tiles_count = tileset->tiles_count > 0 ? tileset->tiles_count : 1;
+  int charmap_count = 0;
+  for (int codepoint = 0; codepoint < tileset->character_map_length; ++codepoint) {
+    charmap_count += TCOD_tileset_get_tile_id(tileset, codepoint) != 0;
+  }
+  const bool alpha_only = tileset->tiles_count == 0 || tileset_is_alpha_only(tileset);
+  const size_t pixel_size = alpha_only ? 1 : sizeof(struct TCOD_ColorRGBA);
+  const size_t charmap_offset = sizeof(struct CacheHeader);
+  const size_t charmap_end = charmap_offset + sizeof(struct CacheCharmapEntry) * charmap_count;
+  const size_t pixels_offset = (charmap_end + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+  const size_t file_size = pixels_offset + pixel_size * tileset->tile_length * tiles_count;
+  unsigned char* buffer = calloc(file_size, 1);
+  if (!buffer) {
+    TCOD_set_errorv("Out of memory.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  struct CacheCharmapEntry* charmap = (struct CacheCharmapEntry*)(buffer + charmap_offset);
+  for (int codepoint = 0; codepoint < tileset->character_map_length; ++codepoint) {
+    const int tile_id = TCOD_tileset_get_tile_id(tileset, codepoint);
+    if (tile_id != 0) {
+      *charmap++ = (struct CacheCharmapEntry){codepoint, tile_id};
+    }
+  }
+  for (int tile_id = 0; tile_id < tileset->tiles_count; ++tile_id) {
+    unsigned char* out = buffer + pixels_offset + pixel_size * tileset->tile_length * tile_id;
+    const unsigned char* alpha = TCOD_tileset_get_tile_alpha_(tileset, tile_id);
+    if (alpha) {
+      memcpy(out, alpha, tileset->tile_length);
+      continue;
+    }
+    const struct TCOD_ColorRGBA* pixels = TCOD_tileset_get_tile_pixels_(tileset, tile_id);
+    if (!alpha_only) {
+      memcpy(out, pixels, sizeof(*pixels) * tileset->tile_length);
+      continue;
+    }
+    for (int i = 0; i < tileset->tile_length; ++i) {
+      out[i] = pixels[i].a;
+    }
+  }
+  struct CacheHeader header = {
+      .magic = CACHE_MAGIC,
+      .version = CACHE_VERSION,
+      .byte_order = CACHE_BYTE_ORDER_MARK,
+      .pixel_format = alpha_only ? CACHE_PIXELS_ALPHA : CACHE_PIXELS_RGBA,
+      .tile_width = tileset->tile_width,
+      .tile_height = tileset->tile_height,
+      .tiles_count = tiles_count,
+      .charmap_count = charmap_count,
+      .source_hash = source_hash,
+      .content_hash = hash_bytes(0, buffer + sizeof(header), file_size - sizeof(header)),
+      .charmap_offset = charmap_offset,
+      .pixels_offset = pixels_offset,
+      .file_size = file_size,
+  };
+  memcpy(buffer, &header, sizeof(header));
+  const TCOD_Error err = write_file_atomically(path, buffer, file_size);
+  free(buffer);
+  return err;
+}
+/**
+ *  Return the header of a mapped cache file, or NULL if the file is not a valid cache.
+ */
+TCOD_NODISCARD
+static const struct CacheHeader* validate_cache(const struct TCOD_MappedFile* file, const char* path) {
+  if (file->size < sizeof(struct CacheHeader)) {
+    TCOD_set_errorvf("File is too small to be a tileset cache:\n%s", path);
+    return NULL;
+  }
+  const struct CacheHeader* header = (const struct CacheHeader*)file->data;
+  if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0) {
+    TCOD_set_errorvf("File is not a tileset cache:\n%s", path);
+    return NULL;
+  }
+  if (header->version != CACHE_VERSION || header->byte_order != CACHE_BYTE_ORDER_MARK) {
+    TCOD_set_errorvf("Tileset cache was written by an incompatible version of libtcod:\n%s", path);
+    return NULL;
+  }
+  const uint64_t pixel_size = header->pixel_format == CACHE_PIXELS_ALPHA ? 1 : sizeof(struct TCOD_ColorRGBA);
+  const bool valid = (header->pixel_format == CACHE_PIXELS_RGBA || header->pixel_format == CACHE_PIXELS_ALPHA) &&
+                     header->tile_width > 0 && header->tile_width <= CACHE_MAX_TILE_SIZE &&
+                     header->tile_height > 0 && header->tile_height <= CACHE_MAX_TILE_SIZE &&
+                     header->tiles_count > 0 && header->charmap_count >= 0 && header->file_size == file->size &&
+                     header->charmap_offset == sizeof(*header) &&
+                     header->charmap_offset + sizeof(struct CacheCharmapEntry) * (uint64_t)header->charmap_count <=
+                         header->pixels_offset &&
+                     header->pixels_offset % CACHE_ALIGNMENT == 0 &&
+                     header->pixels_offset + pixel_size * header->tile_width * header->tile_height *
+                                                 (uint64_t)header->tiles_count ==
+                         header->file_size;
+  if (!valid) {
+    TCOD_set_errorvf("Tileset cache is corrupt:\n%s", path);
+    return NULL;
+  }
+  if (hash_bytes(0, file->data + sizeof(*header), file->size - sizeof(*header)) != header->content_hash) {
+    TCOD_set_errorvf("Tileset cache does not match its content hash:\n%s", path);
+    return NULL;
+  }
+  return header;
+}
+TCOD_Tileset* TCOD_tileset_load_cache(const char* path, uint64_t source_hash) {
+  if (!path) {
+    TCOD_set_errorv("Path must not be NULL.");
+    return NULL;
+  }
+  struct TCOD_MappedFile* file = mapped_file_open(path);
+  if (!file) {
+    return NULL;
+  }
+  const struct CacheHeader* header = validate_cache(file, path);
+  if (!header) {
+    TCOD_mapped_file_delete_(file);
+    return NULL;
+  }
+  if (source_hash && header->source_hash != source_hash) {
+    TCOD_set_errorvf("Tileset cache is stale:\n%s", path);
+    TCOD_mapped_file_delete_(file);
+    return NULL;
+  }
+  TCOD_Tileset* tileset = TCOD_tileset_new(header->tile_width, header->tile_height);
+  if (!tileset) {
+    TCOD_set_errorv("Out of memory.");
+    TCOD_mapped_file_delete_(file);
+    return NULL;
+  }
+  const unsigned char* pixels = file->data + header->pixels_offset;
+  const struct CacheCharmapEntry* charmap = (const struct CacheCharmapEntry*)(file->data + header->charmap_offset);
+  const int charmap_count = header->charmap_count;
+  // Tiles are used in place, the tileset now owns the mapping.
+  if (header->pixel_format == CACHE_PIXELS_RGBA) {
+    tileset->pixels = (struct TCOD_ColorRGBA*)pixels;
+  } else {
+    tileset->alpha = (unsigned char*)pixels;
+  }
+  tileset->pixels_mapping = file;
+  tileset->tiles_capacity = tileset->tiles_count = header->tiles_count;
+  for (int i = 0; i < charmap_count; ++i) {
+    if (TCOD_tileset_assign_tile(tileset, charmap[i].tile_id, charmap[i].codepoint) < 0) {
+      TCOD_tileset_delete(tileset);
+      return NULL;
+    }
+  }
+  return tileset;
+}
+TCOD_Tileset* TCOD_tileset_load_cached(const TCOD_TilesetSource* source, const char* cache_path) {
+  if (!cache_path) {
+    TCOD_set_errorv("Cache path must not be NULL.");
+    return NULL;
+  }
+  uint64_t source_hash;
+  if (TCOD_tileset_source_hash(source, &source_hash) < 0) {
+    return NULL;
+  }
+  TCOD_Tileset* tileset = TCOD_tileset_load_cache(cache_path, source_hash);
+  if (tileset) {
+    return tileset;
+  }
+  TCOD_log_debug_f("Rebuilding tileset cache: %s", TCOD_get_error());
+  tileset = TCOD_tileset_load_source(source);
+  if (!tileset) {
+    return NULL;
+  }
+  if (TCOD_tileset_save_cache(tileset, cache_path, source_hash) < 0) {
+    TCOD_log_warning_f("Could not save tileset cache: %s", TCOD_get_error());
+  }
+  return tileset;
+}
@@ -0,0 +1,151 @@
+/* BSD 3-Clause License
+ *
+ * Copyright © 2008-2026, Jice and the libtcod contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/// @file tileset_cache.h
+/// Precompiled binary tileset caches.
+#pragma once
+#ifndef LIBTCOD_TILESET_CACHE_H_
+#define LIBTCOD_TILESET_CACHE_H_
+
+#include <stdint.h>
+
+#include "config.h"
+#include "error.h"
+#include "tileset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+/// @addtogroup Tileset
+/// @{
+/**
+    The kinds of files which a tileset cache can be built from.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef enum TCOD_TilesetSourceType {
+  TCOD_TILESET_SOURCE_TILESHEET = 1,  // A PNG tilesheet loaded with TCOD_tileset_load.
+  TCOD_TILESET_SOURCE_TRUETYPE = 2,  // A TrueType font loaded with TCOD_load_truetype_font_.
+  TCOD_TILESET_SOURCE_BDF = 3,  // A BDF font loaded with TCOD_load_bdf.
+} TCOD_TilesetSourceType;
+/**
+    Describes a tileset source file and the parameters it is loaded with.
+
+    Fields which do not apply to `type` are ignored.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+typedef struct TCOD_TilesetSource {
+  TCOD_TilesetSourceType type;
+  const char* path;  // The path to the source file.
+  int columns;  // The number of tile columns of a tilesheet.
+  int rows;  // The number of tile rows of a tilesheet.
+  int charmap_length;  // The length of `charmap`.
+  const int* charmap;  // The codepoint of each tile of a tilesheet, such as TCOD_CHARMAP_CP437.
+  int tile_width;  // The tile width of a TrueType font, or zero to derive it from the font.
+  int tile_height;  // The tile height of a TrueType font.
+} TCOD_TilesetSource;
+/**
+    Load a tileset from its source file.
+
+    Returns NULL on failure.  See `TCOD_get_error` for the error message.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCODLIB_API TCOD_NODISCARD TCOD_Tileset* TCOD_tileset_load_source(const TCOD_TilesetSource* source);
+/**
+    Output a hash of a tileset source file and its load parameters to `hash_out`.
+
+    A cache built from this source stores this hash so that it can be detected as stale once the source changes.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCODLIB_API TCOD_NODISCARD TCOD_Error TCOD_tileset_source_hash(const TCOD_TilesetSource* source, uint64_t* hash_out);
+/**
+    Save `tileset` as a binary cache file at `path`.
+
+    Tiles are stored as 8-bit alpha when every tile is white with alpha, otherwise they are stored as RGBA.
+    `source_hash` should come from TCOD_tileset_source_hash, or be zero if the cache has no source.
+
+    The file is written next to `path` and then renamed, so programs which have the old cache loaded are not affected.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCODLIB_API TCOD_NODISCARD TCOD_Error
+TCOD_tileset_save_cache(const TCOD_Tileset* tileset, const char* path, uint64_t source_hash);
+/**
+    Load a tileset from a binary cache file.
+
+    Caches are memory mapped and their tiles are used in place without copying them.
+    Tiles are only copied out of the mapping when the tileset is modified.
+
+    Returns NULL if the file is missing, corrupt, written by an incompatible version,
+    or if `source_hash` is nonzero and does not match the hash stored in the cache.
+    See `TCOD_get_error` for the error message.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCODLIB_API TCOD_NODISCARD TCOD_Tileset* TCOD_tileset_load_cache(const char* path, uint64_t source_hash);
+/**
+    Load a tileset from the cache at `cache_path`, rebuilding the cache from `source` if it is missing or stale.
+
+    Failing to write a rebuilt cache only logs a warning, the tileset loaded from `source` is still returned.
+
+    Returns NULL if `source` could not be loaded.  See `TCOD_get_error` for the error message.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCODLIB_API TCOD_NODISCARD TCOD_Tileset* TCOD_tileset_load_cached(
+    const TCOD_TilesetSource* source, const char* cache_path);
+/**
+    A privately memory mapped file, writes to its memory are never saved to the file.
+
+    For internal use.
+ */
+struct TCOD_MappedFile;
+/**
+    Release a memory mapped file.
+
+    For internal use.
+ */
+void TCOD_mapped_file_delete_(struct TCOD_MappedFile* file);
+/// @}
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+#endif  // LIBTCOD_TILESET_CACHE_H_
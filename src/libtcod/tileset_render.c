@@ -31,38 +31,288 @@
  */
 #include "tileset_render.h"
 
+#include <stdint.h>
+#include <string.h>
+
+#include "libtcod_int.h"
+#include "utility.h"
 #ifndef NO_SDL
 #include <SDL3/SDL.h>
 #endif  // NO_SDL
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TCOD_TILESET_RENDER_SSE2
+#include <emmintrin.h>
+#endif
+/**
+    Multiply the foreground and glyph colors, then blend the result over `bg`.
+
+    This is the reference for the vectorized compositor, which must match it exactly.
+ */
+static TCOD_ColorRGBA composite_pixel(TCOD_ColorRGBA glyph, TCOD_ColorRGBA fg, TCOD_ColorRGBA bg) {
+  const TCOD_ColorRGBA src = {
+      (uint8_t)(fg.r * glyph.r / 255),
+      (uint8_t)(fg.g * glyph.g / 255),
+      (uint8_t)(fg.b * glyph.b / 255),
+      (uint8_t)(fg.a * glyph.a / 255),
+  };
+  if (src.a == 0) return bg;  // Blending a transparent pixel leaves the background unchanged.
+  TCOD_color_alpha_blend(&bg, &src);
+  return bg;
+}
+#ifdef TCOD_TILESET_RENDER_SSE2
+/**
+    Divide 16-bit lanes of at most 255 * 255 by 255, rounding down.
+ */
+static inline __m128i div255_epu16(__m128i x) {
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+/**
+    Composite two pixels unpacked into 16-bit lanes over an opaque background.
+
+    With an opaque background the output alpha is always 255 and the blend reduces to
+    ``(src * src.a + bg * (255 - src.a)) / 255`` which fits in 16 bits.
+ */
+static inline __m128i composite_2_opaque(__m128i glyph, __m128i fg, __m128i bg) {
+  const __m128i src = div255_epu16(_mm_mullo_epi16(glyph, fg));
+  const __m128i src_a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128i inv_a = _mm_sub_epi16(_mm_set1_epi16(255), src_a);
+  return div255_epu16(_mm_add_epi16(_mm_mullo_epi16(src, src_a), _mm_mullo_epi16(bg, inv_a)));
+}
+/**
+    The colors of a tile broadcast for compositing four pixels at a time over an opaque background.
+ */
+struct Composite4 {
+  __m128i fg_x4;
+  __m128i bg_x4;
+  __m128i fg_x2;  // `fg` unpacked into 16-bit lanes.
+  __m128i bg_x2;  // `bg` unpacked into 16-bit lanes.
+  bool fg_opaque;
+};
+static inline struct Composite4 composite_4_init(TCOD_ColorRGBA fg, TCOD_ColorRGBA bg) {
+  uint32_t fg_bits;
+  uint32_t bg_bits;
+  memcpy(&fg_bits, &fg, sizeof(fg_bits));
+  memcpy(&bg_bits, &bg, sizeof(bg_bits));
+  const __m128i fg_x4 = _mm_set1_epi32((int)fg_bits);
+  const __m128i bg_x4 = _mm_set1_epi32((int)bg_bits);
+  return (struct Composite4){
+      fg_x4,
+      bg_x4,
+      _mm_unpacklo_epi8(fg_x4, _mm_setzero_si128()),
+      _mm_unpacklo_epi8(bg_x4, _mm_setzero_si128()),
+      fg.a == 255,
+  };
+}
+/**
+    Composite four RGBA glyph pixels over an opaque background.
+ */
+static inline __m128i composite_4_opaque(__m128i pixels, const struct Composite4* colors) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000u);
+  if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(pixels, alpha_mask), zero)) == 0xFFFF) {
+    return colors->bg_x4;  // Fully transparent pixels.
+  }
+  if (colors->fg_opaque && _mm_movemask_epi8(_mm_cmpeq_epi32(pixels, _mm_set1_epi32(-1))) == 0xFFFF) {
+    return colors->fg_x4;  // Fully opaque white pixels.
+  }
+  const __m128i lo = composite_2_opaque(_mm_unpacklo_epi8(pixels, zero), colors->fg_x2, colors->bg_x2);
+  const __m128i hi = composite_2_opaque(_mm_unpackhi_epi8(pixels, zero), colors->fg_x2, colors->bg_x2);
+  return _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask);
+}
+#endif  // TCOD_TILESET_RENDER_SSE2
 /**
-    Render a single tile.
+    Composite `width` glyph pixels with the colors of a tile.
+ */
+static void composite_row(
+    TCOD_ColorRGBA* __restrict out,
+    const TCOD_ColorRGBA* __restrict glyph,
+    TCOD_ColorRGBA fg,
+    TCOD_ColorRGBA bg,
+    int width) {
+  int x = 0;
+#ifdef TCOD_TILESET_RENDER_SSE2
+  if (bg.a == 255) {
+    const struct Composite4 colors = composite_4_init(fg, bg);
+    for (; x + 4 <= width; x += 4) {
+      const __m128i pixels = _mm_loadu_si128((const __m128i*)(glyph + x));
+      _mm_storeu_si128((__m128i*)(out + x), composite_4_opaque(pixels, &colors));
+    }
+  }
+#endif  // TCOD_TILESET_RENDER_SSE2
+  for (; x < width; ++x) out[x] = composite_pixel(glyph[x], fg, bg);
+}
+/**
+    Composite `width` pixels of an alpha-only glyph with the colors of a tile, glyph pixels are white.
+ */
+static void composite_alpha_row(
+    TCOD_ColorRGBA* __restrict out,
+    const unsigned char* __restrict alpha,
+    TCOD_ColorRGBA fg,
+    TCOD_ColorRGBA bg,
+    int width) {
+  int x = 0;
+#ifdef TCOD_TILESET_RENDER_SSE2
+  if (bg.a == 255) {
+    const struct Composite4 colors = composite_4_init(fg, bg);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i white = _mm_set1_epi32(0x00FFFFFF);
+    for (; x + 4 <= width; x += 4) {
+      int32_t alpha_x4;
+      memcpy(&alpha_x4, alpha + x, sizeof(alpha_x4));
+      // Widen each alpha byte to the top byte of a white pixel.
+      const __m128i alpha_x32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(alpha_x4), zero), zero);
+      const __m128i pixels = _mm_or_si128(_mm_slli_epi32(alpha_x32, 24), white);
+      _mm_storeu_si128((__m128i*)(out + x), composite_4_opaque(pixels, &colors));
+    }
+  }
+#endif  // TCOD_TILESET_RENDER_SSE2
+  for (; x < width; ++x) out[x] = composite_pixel((TCOD_ColorRGBA){255, 255, 255, alpha[x]}, fg, bg);
+}
+/**
+    Render a single tile, clipped to `width` by `height` pixels.
  */
 static void render_tile(
     const TCOD_Tileset* __restrict tileset,
     const struct TCOD_ConsoleTile* __restrict tile,
     struct TCOD_ColorRGBA* __restrict out_rgba,
+    int stride,
+    int width,
+    int height) {
+  const int tile_id = TCOD_tileset_get_tile_id(tileset, tile->ch);
+  // Alpha-only tiles are expanded while compositing, they never need the RGBA view of the tileset.
+  const unsigned char* alpha = TCOD_tileset_get_tile_alpha_(tileset, tile_id);
+  const TCOD_ColorRGBA* graphic = alpha ? NULL : TCOD_tileset_get_tile_pixels_(tileset, tile_id);
+  for (int y = 0; y < height; ++y) {
+    TCOD_ColorRGBA* out = (TCOD_ColorRGBA*)((char*)out_rgba + (ptrdiff_t)stride * y);
+    if (alpha) {
+      composite_alpha_row(out, alpha + y * tileset->tile_width, tile->fg, tile->bg, width);
+    } else if (graphic) {
+      composite_row(out, graphic + y * tileset->tile_width, tile->fg, tile->bg, width);
+    } else {
+      for (int x = 0; x < width; ++x) out[x] = tile->bg;
+    }
+  }
+}
+/**
+    The shared arguments of a TCOD_tileset_render_to_rgba call, each thread renders a range of console rows.
+ */
+struct RenderRGBAJob {
+  const TCOD_Tileset* tileset;
+  const TCOD_Console* console;
+  TCOD_Console* cache;  // May be NULL.
+  const struct TCOD_ConsoleDirty* console_rows;  // Row versions of `console`, may be NULL.
+  struct TCOD_ConsoleDirty* cache_rows;  // Row versions drawn onto `cache`, may be NULL.
+  TCOD_ColorRGBA* pixels;
+  int width;  // Pixel width of `pixels`.
+  int height;  // Pixel height of `pixels`.
+  int stride;  // Bytes per row of `pixels`.
+  int columns;  // Console columns which are at least partially inside of `pixels`.
+};
+/**
+    Render the console rows from `begin` up to but not including `end`.
+ */
+static void render_rgba_rows(void* userdata, int begin, int end) {
+  const struct RenderRGBAJob* job = userdata;
+  const TCOD_Tileset* tileset = job->tileset;
+  const TCOD_Console* console = job->console;
+  TCOD_Console* cache = job->cache;
+  uint64_t bg_changed[1];
+  uint64_t fg_changed[1];
+  for (int console_y = begin; console_y < end; ++console_y) {
+    if (TCOD_console_row_is_drawn_(job->console_rows, job->cache_rows, console_y)) continue;
+    const int pixel_y = console_y * tileset->tile_height;
+    const int tile_height = TCOD_MIN(tileset->tile_height, job->height - pixel_y);
+    const TCOD_ConsoleTile* row = console->tiles + console_y * console->w;
+    TCOD_ConsoleTile* cache_row = cache ? cache->tiles + console_y * cache->w : NULL;
+    char* out_row = (char*)job->pixels + (ptrdiff_t)job->stride * pixel_y;
+    for (int word_x = 0; word_x < job->columns; word_x += 64) {
+      const int count = TCOD_MIN(64, job->columns - word_x);
+      uint64_t changed = count == 64 ? ~(uint64_t)0 : ((uint64_t)1 << count) - 1;
+      if (cache_row) {
+        if (!TCOD_console_diff_tiles(row + word_x, cache_row + word_x, count, bg_changed, fg_changed)) continue;
+        changed = bg_changed[0] | fg_changed[0];
+      }
+      while (changed) {
+        const int console_x = word_x + TCOD_lowest_bit_(changed);
+        changed &= changed - 1;
+        const int pixel_x = console_x * tileset->tile_width;
+        render_tile(
+            tileset,
+            &row[console_x],
+            (TCOD_ColorRGBA*)(out_row + pixel_x * sizeof(TCOD_ColorRGBA)),
+            job->stride,
+            TCOD_MIN(tileset->tile_width, job->width - pixel_x),
+            tile_height);
+        if (cache_row) cache_row[console_x] = row[console_x];
+      }
+    }
+    // Only fully drawn rows can be skipped, clipped columns are never drawn onto the cache.
+    if (job->columns == console->w) TCOD_console_row_set_drawn_(job->console_rows, job->cache_rows, console_y);
+  }
+}
+TCOD_Error TCOD_tileset_render_to_rgba(
+    const TCOD_Tileset* __restrict tileset,
+    const TCOD_Console* __restrict console,
+    TCOD_Console* __restrict* cache,
+    TCOD_ColorRGBA* __restrict pixels,
+    int width,
+    int height,
     int stride) {
-  const TCOD_ColorRGBA* graphic = TCOD_tileset_get_tile(tileset, tile->ch);
-  for (int y = 0; y < tileset->tile_height; ++y) {
-    TCOD_ColorRGBA* out = (TCOD_ColorRGBA*)((char*)out_rgba + stride * y);
-    for (int x = 0; x < tileset->tile_width; ++x) {
-      if (graphic) {
-        // Multiply the foreground and tileset colors, then blend with bg.
-        struct TCOD_ColorRGBA rgba = tile->bg;
-        int graphic_i = y * tileset->tile_width + x;
-        struct TCOD_ColorRGBA fg = {
-            tile->fg.r * graphic[graphic_i].r / 255,
-            tile->fg.g * graphic[graphic_i].g / 255,
-            tile->fg.b * graphic[graphic_i].b / 255,
-            tile->fg.a * graphic[graphic_i].a / 255,
-        };
-        TCOD_color_alpha_blend(&rgba, &fg);
-        out[x] = rgba;
-      } else {
-        out[x] = tile->bg;
+  if (!tileset) {
+    TCOD_set_errorv("Tileset argument must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (!console) {
+    TCOD_set_errorv("Console argument must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (width < 0 || height < 0) {
+    return TCOD_set_errorvf("Image size (%i, %i) must not be negative.", width, height);
+  }
+  if (!pixels && width && height) {
+    TCOD_set_errorv("Pixels argument must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  if (stride < width * (int)sizeof(*pixels)) {
+    return TCOD_set_errorvf("Stride of %i bytes is too small for an image %i pixels wide.", stride, width);
+  }
+  if (cache) {
+    if (*cache) {
+      if ((*cache)->w != console->w || (*cache)->h != console->h) {
+        TCOD_console_delete(*cache);
+        *cache = NULL;
       }
     }
+    if (!*cache) {
+      *cache = TCOD_console_new(console->w, console->h);
+      if (!*cache) return TCOD_E_OUT_OF_MEMORY;
+      for (int i = 0; i < (*cache)->elements; ++i) {
+        (*cache)->tiles[i].ch = -1;  // Never matches a real tile, so everything is drawn once.
+      }
+      // Tracks which rows of the rendered console are already drawn, skipping is disabled if this fails.
+      (void)TCOD_console_set_dirty_tracking(*cache, true);
+    }
   }
+  if (tileset->tile_width <= 0 || tileset->tile_height <= 0) return TCOD_E_OK;
+  struct RenderRGBAJob job = {
+      .tileset = tileset,
+      .console = console,
+      .cache = cache ? *cache : NULL,
+      .console_rows = cache ? TCOD_console_observe_dirty_(console) : NULL,
+      .cache_rows = cache ? TCOD_console_get_dirty_(*cache) : NULL,
+      .pixels = pixels,
+      .width = width,
+      .height = height,
+      .stride = stride,
+      .columns = TCOD_MIN(console->w, (width + tileset->tile_width - 1) / tileset->tile_width),
+  };
+  const int rows = TCOD_MIN(console->h, (height + tileset->tile_height - 1) / tileset->tile_height);
+  if (job.columns <= 0 || rows <= 0) return TCOD_E_OK;
+  // Give each thread at least 64K pixels, smaller jobs are not worth the overhead of a thread.
+  const int pixels_per_row = job.columns * tileset->tile_width * tileset->tile_height;
+  TCOD_parallel_for(rows, TCOD_MAX(1, 65536 / TCOD_MAX(1, pixels_per_row)), render_rgba_rows, &job);
+  return TCOD_E_OK;
 }
 #ifndef NO_SDL
 TCOD_Error TCOD_tileset_render_to_surface(
@@ -75,7 +325,7 @@ TCOD_Error TCOD_tileset_render_to_surface(
     return TCOD_E_INVALID_ARGUMENT;
   }
   if (!console) {
-    TCOD_set_errorv("Tileset argument must not be NULL.");
+    TCOD_set_errorv("Console argument must not be NULL.");
     return TCOD_E_INVALID_ARGUMENT;
   }
   if (!surface_out) {
@@ -93,41 +343,13 @@ TCOD_Error TCOD_tileset_render_to_surface(
   }
   if (!*surface_out) {
     *surface_out = SDL_CreateSurface(total_width, total_height, SDL_PIXELFORMAT_RGBA32);
-  }
-  if (cache) {
-    if (*cache) {
-      if ((*cache)->w != console->w || (*cache)->h != console->h) {
-        TCOD_console_delete(*cache);
-        *cache = NULL;
-      }
-    }
-    if (!*cache) {
-      *cache = TCOD_console_new(console->w, console->h);
+    if (!*surface_out) return TCOD_set_errorvf("Failed to create surface: %s", SDL_GetError());
+    if (cache && *cache) {
+      TCOD_console_delete(*cache);  // The cache describes the old surface, so everything must be drawn again.
+      *cache = NULL;
     }
   }
-  for (int console_y = 0; console_y < console->h; ++console_y) {
-    for (int console_x = 0; console_x < console->w; ++console_x) {
-      // Get the console index and tileset graphic.
-      int console_i = console_y * console->w + console_x;
-      const struct TCOD_ConsoleTile* tile = &console->tiles[console_i];
-      if (cache && *cache) {
-        const struct TCOD_ConsoleTile* cache_tile = &(*cache)->tiles[console_i];
-        if (cache_tile->ch == tile->ch && cache_tile->fg.r == tile->fg.r && cache_tile->fg.g == tile->fg.g &&
-            cache_tile->fg.b == tile->fg.b && cache_tile->fg.a == tile->fg.a && cache_tile->bg.r == tile->bg.r &&
-            cache_tile->bg.g == tile->bg.g && cache_tile->bg.b == tile->bg.b && cache_tile->bg.a == tile->bg.a) {
-          continue;
-        }
-      }
-      // clang-format off
-      TCOD_ColorRGBA* out = (TCOD_ColorRGBA*)(
-          (char*)(*surface_out)->pixels
-          + console_y * tileset->tile_height * (*surface_out)->pitch
-          + console_x * tileset->tile_width * sizeof(*out)
-      );
-      // clang-format on
-      render_tile(tileset, tile, out, (*surface_out)->pitch);
-    }
-  }
-  return TCOD_E_OK;
+  return TCOD_tileset_render_to_rgba(
+      tileset, console, cache, (*surface_out)->pixels, (*surface_out)->w, (*surface_out)->h, (*surface_out)->pitch);
 }
 #endif  // NO_SDL
@@ -45,6 +45,36 @@ struct SDL_Surface;
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
+/**
+    Render a console to a caller provided buffer of RGBA pixels with a software renderer.
+
+    `tileset` is the tiles to render with, must not be NULL.
+
+    `console` is the console to render, must not be NULL.
+
+    `cache` is an optional pointer to a console used as a cache.  The console at `*cache` will be created or modified.
+    Tiles which match the cache are not drawn again, so the same `pixels` buffer must be passed on every call which
+    uses this cache.  Delete the cache to force everything to be redrawn.
+
+    `pixels` is the image to render onto.  It is `width` by `height` pixels and each row starts `stride` bytes after
+    the previous one.  The console is drawn starting at the top-left corner and is clipped to the image, the image
+    should be ``console->w * tileset->tile_width`` by ``console->h * tileset->tile_height`` pixels to show every tile.
+
+    Large consoles are split by rows and rendered on multiple threads.  This returns once every thread is done.
+
+    Returns a negative value on error, see `TCOD_get_error`.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCOD_PUBLIC TCOD_Error TCOD_tileset_render_to_rgba(
+    const TCOD_Tileset* __restrict tileset,
+    const TCOD_Console* __restrict console,
+    TCOD_Console* __restrict* cache,
+    TCOD_ColorRGBA* __restrict pixels,
+    int width,
+    int height,
+    int stride);
 #ifndef NO_SDL
 /**
     Render a console to a SDL_Surface with a software renderer.
@@ -62,6 +92,8 @@ extern "C" {
     to match the size of `console` and `tileset`.  The pixel format will be
     SDL_PIXELFORMAT_RGBA32.
 
+    Large consoles are rendered on multiple threads, see `TCOD_tileset_render_to_rgba`.
+
     Returns a negative value on error, see `TCOD_get_error`.
     @versionadded{1.16}
  */
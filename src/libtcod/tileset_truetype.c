@@ -32,12 +32,16 @@
 #include "tileset_truetype.h"
 
 #include <stb_truetype.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "error.h"
 #include "globals.h"
+#include "sys.h"
+#include "utility.h"
 
 // You can look here for a reference on glyph metrics:
 // https://www.freetype.org/freetype2/docs/glyphs/glyphs-3.html
@@ -56,7 +60,7 @@ struct FontLoader {
   float scale;
   struct BBox font_bbox;
   struct TCOD_Tileset* tileset;
-  struct TCOD_ColorRGBA* tile;
+  uint8_t* tile;  // The alpha of the tile being rendered.
   uint8_t* __restrict tile_alpha;
   int ascent;
   int descent;
@@ -93,8 +97,7 @@ void render_glyph(const struct FontLoader* __restrict loader, int glyph) {
   const struct TCOD_Tileset* tileset = loader->tileset;
   get_glyph_shift(loader, glyph, &shift_x, &shift_y);
   for (int i = 0; i < tileset->tile_length; ++i) {
-    loader->tile[i].r = loader->tile[i].g = loader->tile[i].b = 255;
-    loader->tile[i].a = 0;
+    loader->tile[i] = 0;
     loader->tile_alpha[i] = 0;
   }
   stbtt_MakeGlyphBitmapSubpixel(
@@ -118,12 +121,50 @@ void render_glyph(const struct FontLoader* __restrict loader, int glyph) {
       if (alpha_x < 0 || tileset->tile_width <= alpha_x) {
         continue;
       }
-      loader->tile[img_y * tileset->tile_width + img_x].a = loader->tile_alpha[alpha_y * tileset->tile_width + alpha_x];
+      loader->tile[img_y * tileset->tile_width + img_x] = loader->tile_alpha[alpha_y * tileset->tile_width + alpha_x];
     }
   }
 }
+/**
+ *  A font kept by its TrueType tileset so that glyphs can be rendered the first time they are used.
+ *
+ *  This is owned by an observer of the tileset and is deleted along with the tileset.
+ */
+struct TrueTypeSource {
+  unsigned char* font_data;
+  stbtt_fontinfo info;
+  struct FontLoader loader;  // `loader.tile` points to the tile being rendered, only used with the tileset locked.
+  int tiles_length;
+  int* tile_glyphs;  // The glyph index of each tile ID.
+};
+static void truetype_source_delete(struct TrueTypeSource* source) {
+  if (!source) {
+    return;
+  }
+  free(source->tile_glyphs);
+  free(source->loader.tile_alpha);
+  free(source->font_data);
+  free(source);
+}
+static void truetype_on_observer_delete(struct TCOD_TilesetObserver* observer) {
+  truetype_source_delete(observer->userdata);
+}
+/**
+ *  Render a pending tile of a TrueType tileset.
+ */
+static int truetype_on_tile_requested(struct TCOD_TilesetObserver* observer, int tile_id, unsigned char* alpha) {
+  struct TrueTypeSource* source = observer->userdata;
+  if (tile_id <= 0 || tile_id >= source->tiles_length || !source->tile_glyphs[tile_id]) {
+    return -1;
+  }
+  source->loader.tile = alpha;
+  render_glyph(&source->loader, source->tile_glyphs[tile_id]);
+  source->loader.tile = NULL;
+  return 0;
+}
 TCOD_NODISCARD
-static struct TCOD_Tileset* tileset_from_ttf(const stbtt_fontinfo* font_info, int tile_width, int tile_height) {
+static struct TCOD_Tileset* tileset_from_ttf(struct TrueTypeSource* source, int tile_width, int tile_height) {
+  const stbtt_fontinfo* font_info = &source->info;
   struct FontLoader loader = {
       .info = font_info,
       .scale = stbtt_ScaleForPixelHeight(font_info, (float)tile_height),
@@ -142,46 +183,243 @@ static struct TCOD_Tileset* tileset_from_ttf(const stbtt_fontinfo* font_info, in
     loader.scale *= (float)tile_width / font_width;
   }
   loader.tileset = TCOD_tileset_new(tile_width, tile_height);
-  loader.tile = malloc(sizeof(*loader.tile) * loader.tileset->tile_length);
+  // Glyphs are white, so only their alpha is stored.
+  if (!loader.tileset || TCOD_tileset_compact_alpha(loader.tileset) < 0) {
+    TCOD_set_errorv("Out of memory while loading tileset.");
+    truetype_source_delete(source);
+    TCOD_tileset_delete(loader.tileset);
+    return NULL;
+  }
   loader.tile_alpha = malloc(sizeof(*loader.tile_alpha) * loader.tileset->tile_length);
-  if (!loader.tileset || !loader.tile || !loader.tile_alpha) {
+  source->loader = loader;
+  source->tiles_length = font_info->numGlyphs + 1;  // Each glyph gets at most one tile after the blank tile.
+  source->tile_glyphs = calloc(source->tiles_length, sizeof(*source->tile_glyphs));
+  struct TCOD_TilesetObserver* observer = TCOD_tileset_observer_new(loader.tileset);
+  if (!loader.tile_alpha || !source->tile_glyphs || !observer) {
+    TCOD_set_errorv("Out of memory while loading tileset.");
+    truetype_source_delete(source);
+    TCOD_tileset_delete(loader.tileset);
+    return NULL;
+  }
+  // From here on the source is deleted along with the tileset.
+  observer->userdata = source;
+  observer->on_observer_delete = truetype_on_observer_delete;
+  observer->on_tile_requested = truetype_on_tile_requested;
+  // Only the character map is built here, glyphs are rendered when they are first used.
+  int* glyph_tiles = calloc(source->tiles_length, sizeof(*glyph_tiles));
+  if (!glyph_tiles) {
+    TCOD_set_errorv("Out of memory while loading tileset.");
     TCOD_tileset_delete(loader.tileset);
-    free(loader.tile);
-    free(loader.tile_alpha);
     return NULL;
   }
   for (int codepoint = 1; codepoint <= 0x1ffff; ++codepoint) {
-    int glyph = stbtt_FindGlyphIndex(font_info, codepoint);
-    if (!glyph) {
+    const int glyph = stbtt_FindGlyphIndex(font_info, codepoint);
+    if (glyph <= 0 || glyph >= source->tiles_length) {
       continue;
     }
-    render_glyph(&loader, glyph);
-    if (TCOD_tileset_set_tile_(loader.tileset, codepoint, loader.tile) < 0) {
-      TCOD_set_errorv("Out of memory while loading tileset.");
+    if (!glyph_tiles[glyph]) {
+      const int tile_id = TCOD_tileset_new_pending_tile_(loader.tileset);
+      if (tile_id < 0) {
+        free(glyph_tiles);
+        TCOD_tileset_delete(loader.tileset);
+        return NULL;
+      }
+      glyph_tiles[glyph] = tile_id;
+      source->tile_glyphs[tile_id] = glyph;
+    }
+    if (TCOD_tileset_assign_tile(loader.tileset, glyph_tiles[glyph], codepoint) < 0) {
+      free(glyph_tiles);
       TCOD_tileset_delete(loader.tileset);
-      loader.tileset = NULL;
-      break;
+      return NULL;
     }
   }
-  free(loader.tile);
-  free(loader.tile_alpha);
+  free(glyph_tiles);
   return loader.tileset;
 }
 
 TCOD_Tileset* TCOD_load_truetype_font_(const char* path, int tile_width, int tile_height) {
-  unsigned char* font_data = TCOD_load_binary_file_(path, NULL);
-  if (!font_data) {
+  struct TrueTypeSource* source = calloc(1, sizeof(*source));
+  if (!source) {
+    TCOD_set_errorv("Out of memory while loading tileset.");
+    return NULL;
+  }
+  source->font_data = TCOD_load_binary_file_(path, NULL);
+  if (!source->font_data) {
+    free(source);
     return NULL;
   }
-  stbtt_fontinfo font_info;
-  if (!stbtt_InitFont(&font_info, font_data, 0)) {
+  if (!stbtt_InitFont(&source->info, source->font_data, 0)) {
     TCOD_set_errorvf("Failed to read font file:\n%s", path);
-    free(font_data);
+    truetype_source_delete(source);
     return NULL;
   }
-  struct TCOD_Tileset* tileset = tileset_from_ttf(&font_info, tile_width, tile_height);
-  free(font_data);
-  return tileset;
+  return tileset_from_ttf(source, tile_width, tile_height);
+}
+#ifndef TCOD_NO_THREADS
+/**
+ *  Pending tiles queued to be rendered on a background thread.
+ *
+ *  This is owned by an observer of the tileset, which is added after the observers that render the tiles.
+ *  Observers are deleted newest first, so workers are stopped before the observers they render with are deleted.
+ */
+struct RenderAheadQueue {
+  TCOD_Tileset* tileset;
+  TCOD_mutex_t queue_lock;  // Guards the queue and `worker_running`.
+  TCOD_semaphore_t workers_done;  // Unlocked by each worker as it exits.
+  int workers_started;
+  bool worker_running;
+  bool cancel;  // Set when workers should stop early.
+  int queue_begin;
+  int queue_end;
+  int queue_capacity;
+  int* queue;  // Tile IDs to render ahead of their first use.
+};
+static void render_ahead_on_observer_delete(struct TCOD_TilesetObserver* observer) {
+  struct RenderAheadQueue* queue = observer->userdata;
+  TCOD_mutex_in(queue->queue_lock);
+  queue->cancel = true;
+  TCOD_mutex_out(queue->queue_lock);
+  for (int i = 0; i < queue->workers_started; ++i) {
+    TCOD_semaphore_lock(queue->workers_done);  // Wait for background workers to stop.
+  }
+  TCOD_semaphore_delete(queue->workers_done);
+  TCOD_mutex_delete(queue->queue_lock);
+  free(queue->queue);
+  free(queue);
+}
+/**
+ *  Return the render-ahead queue of `tileset`, adding one if it has none.  Returns NULL on error.
+ */
+TCOD_NODISCARD
+static struct RenderAheadQueue* get_render_ahead_queue(TCOD_Tileset* tileset) {
+  struct RenderAheadQueue* queue = NULL;
+  TCOD_tileset_lock_(tileset);  // Observers are added and removed while holding this lock.
+  for (struct TCOD_TilesetObserver* it = tileset->observer_list; it; it = it->next) {
+    if (it->on_observer_delete == render_ahead_on_observer_delete) {
+      queue = it->userdata;
+    }
+  }
+  TCOD_tileset_unlock_(tileset);
+  if (queue) {
+    return queue;
+  }
+  queue = calloc(1, sizeof(*queue));
+  if (!queue) {
+    TCOD_set_errorv("Out of memory.");
+    return NULL;
+  }
+  queue->tileset = tileset;
+  queue->queue_lock = TCOD_mutex_new();
+  queue->workers_done = TCOD_semaphore_new(0);
+  struct TCOD_TilesetObserver* observer = NULL;
+  if (queue->queue_lock && queue->workers_done) {
+    observer = TCOD_tileset_observer_new(tileset);
+  }
+  if (!observer) {
+    if (queue->workers_done) TCOD_semaphore_delete(queue->workers_done);
+    if (queue->queue_lock) TCOD_mutex_delete(queue->queue_lock);
+    free(queue);
+    TCOD_set_errorv("Could not create the synchronization objects for a background thread.");
+    return NULL;
+  }
+  observer->userdata = queue;
+  observer->on_observer_delete = render_ahead_on_observer_delete;
+  return queue;
+}
+/**
+ *  Render queued tiles until the queue is empty or the tileset is deleted.
+ */
+static int render_ahead_worker(void* userdata) {
+  struct RenderAheadQueue* queue = userdata;
+  while (true) {
+    TCOD_mutex_in(queue->queue_lock);
+    if (queue->cancel || queue->queue_begin == queue->queue_end) {
+      queue->worker_running = false;
+      TCOD_mutex_out(queue->queue_lock);
+      break;
+    }
+    const int tile_id = queue->queue[queue->queue_begin++];
+    TCOD_mutex_out(queue->queue_lock);
+    TCOD_tileset_render_pending_tile_(queue->tileset, tile_id);
+  }
+  TCOD_semaphore_unlock(queue->workers_done);
+  return 0;
+}
+/**
+ *  Add tile IDs to the queue and start a worker if none is running.
+ */
+TCOD_NODISCARD
+static TCOD_Error render_ahead_queue_tiles(struct RenderAheadQueue* queue, int count, const int* tile_ids) {
+  TCOD_mutex_in(queue->queue_lock);
+  if (queue->queue_begin == queue->queue_end) {
+    queue->queue_begin = queue->queue_end = 0;
+  }
+  if (queue->queue_end + count > queue->queue_capacity) {
+    const int new_capacity = TCOD_MAX(queue->queue_capacity * 2, queue->queue_end + count);
+    int* new_queue = realloc(queue->queue, sizeof(*new_queue) * new_capacity);
+    if (!new_queue) {
+      TCOD_mutex_out(queue->queue_lock);
+      TCOD_set_errorv("Out of memory.");
+      return TCOD_E_OUT_OF_MEMORY;
+    }
+    queue->queue = new_queue;
+    queue->queue_capacity = new_capacity;
+  }
+  memcpy(queue->queue + queue->queue_end, tile_ids, sizeof(*tile_ids) * count);
+  queue->queue_end += count;
+  const bool start_worker = !queue->worker_running;
+  queue->worker_running = true;
+  TCOD_mutex_out(queue->queue_lock);
+  if (!start_worker) {
+    return TCOD_E_OK;
+  }
+  TCOD_thread_t thread = TCOD_thread_new(render_ahead_worker, queue);
+  if (!thread) {
+    TCOD_mutex_in(queue->queue_lock);
+    queue->worker_running = false;
+    TCOD_mutex_out(queue->queue_lock);
+    return TCOD_set_errorv("Could not start a background thread.");
+  }
+  ++queue->workers_started;
+  TCOD_thread_delete(thread);  // Completion is tracked by `workers_done` instead.
+  return TCOD_E_OK;
+}
+#endif  // TCOD_NO_THREADS
+TCOD_Error TCOD_tileset_truetype_render_ahead_(TCOD_Tileset* tileset, int first_codepoint, int last_codepoint) {
+  if (!tileset) {
+    TCOD_set_errorv("Tileset argument must not be NULL.");
+    return TCOD_E_INVALID_ARGUMENT;
+  }
+  first_codepoint = TCOD_MAX(first_codepoint, 0);
+  last_codepoint = TCOD_MIN(last_codepoint, tileset->character_map_length - 1);
+  if (!tileset->pending_tiles || first_codepoint > last_codepoint) {
+    return TCOD_E_OK;
+  }
+  int* tile_ids = malloc(sizeof(*tile_ids) * (last_codepoint - first_codepoint + 1));
+  if (!tile_ids) {
+    TCOD_set_errorv("Out of memory.");
+    return TCOD_E_OUT_OF_MEMORY;
+  }
+  int count = 0;
+  for (int codepoint = first_codepoint; codepoint <= last_codepoint; ++codepoint) {
+    const int tile_id = TCOD_tileset_get_tile_id(tileset, codepoint);
+    if (tile_id > 0) {  // Tiles which are no longer pending are skipped when they are rendered.
+      tile_ids[count++] = tile_id;
+    }
+  }
+  TCOD_Error err = TCOD_E_OK;
+#ifndef TCOD_NO_THREADS
+  if (count) {
+    struct RenderAheadQueue* queue = get_render_ahead_queue(tileset);
+    err = queue ? render_ahead_queue_tiles(queue, count, tile_ids) : TCOD_E_ERROR;
+  }
+#else
+  for (int i = 0; i < count; ++i) {
+    TCOD_tileset_render_pending_tile_(tileset, tile_ids[i]);
+  }
+#endif  // TCOD_NO_THREADS
+  free(tile_ids);
+  return err;
 }
 TCOD_Error TCOD_tileset_load_truetype_(const char* path, int tile_width, int tile_height) {
   TCOD_Tileset* tileset = TCOD_load_truetype_font_(path, tile_width, tile_height);
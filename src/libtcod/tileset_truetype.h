@@ -41,9 +41,30 @@ extern "C" {
 /**
     Return a tileset from a TrueType font file.
 
+    Glyphs are rendered the first time they are read from the tileset, the font file is kept in memory until then.
+
     This function is provisional and may change in future releases.
  */
 TCODLIB_API TCOD_NODISCARD TCOD_Tileset* TCOD_load_truetype_font_(const char* path, int tile_width, int tile_height);
+/**
+    Render the glyphs for `first_codepoint` to `last_codepoint` of a TrueType tileset ahead of their first use.
+
+    Glyphs are otherwise rendered the first time they are read.
+    The glyphs are rendered on a background thread and this function returns immediately.
+    If libtcod was built without threads then the glyphs are rendered before this function returns.
+    Codepoints missing from the font and glyphs which were already rendered are skipped.
+    Deleting the tileset stops the background thread.
+
+    This works with any tileset whose tiles are rendered on first use, such as those of TCOD_load_truetype_font_.
+    Other tilesets have nothing to render ahead, so this does nothing for them.
+
+    This function is provisional and may change in future releases.
+    \rst
+    .. versionadded:: Unreleased
+    \endrst
+ */
+TCODLIB_API TCOD_NODISCARD TCOD_Error
+TCOD_tileset_truetype_render_ahead_(TCOD_Tileset* tileset, int first_codepoint, int last_codepoint);
 /**
     Set the global tileset from a TrueType font file.
 
@@ -137,6 +137,7 @@ void TCOD_console_fill_background(TCOD_Console* con, int* r, int* g, int* b) {
   for (int i = 0; i < con->w * con->h; ++i) {
     con->tiles[i].bg = (TCOD_ColorRGBA){(uint8_t)r[i], (uint8_t)g[i], (uint8_t)b[i], 255};
   }
+  TCOD_console_mark_dirty(con, 0, 0, con->w, con->h);
 }
 void TCOD_console_fill_foreground(TCOD_Console* con, int* r, int* g, int* b) {
   con = TCOD_console_validate_(con);
@@ -146,6 +147,7 @@ void TCOD_console_fill_foreground(TCOD_Console* con, int* r, int* g, int* b) {
   for (int i = 0; i < con->w * con->h; ++i) {
     con->tiles[i].fg = (TCOD_ColorRGBA){(uint8_t)r[i], (uint8_t)g[i], (uint8_t)b[i], 255};
   }
+  TCOD_console_mark_dirty(con, 0, 0, con->w, con->h);
 }
 void TCOD_console_fill_char(TCOD_Console* con, int* arr) {
   con = TCOD_console_validate_(con);
@@ -155,6 +157,7 @@ void TCOD_console_fill_char(TCOD_Console* con, int* arr) {
   for (int i = 0; i < con->w * con->h; ++i) {
     con->tiles[i].ch = arr[i];
   }
+  TCOD_console_mark_dirty(con, 0, 0, con->w, con->h);
 }
 
 colornum_t TCOD_console_get_fading_color_wrapper() { return color_to_int(TCOD_console_get_fading_color()); }
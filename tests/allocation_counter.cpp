@@ -0,0 +1,23 @@
+#include "allocation_counter.hpp"
+
+#ifdef TEST_COUNT_ALLOCATIONS
+bool count_allocations = false;
+int64_t allocation_count = 0;
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* malloc(size_t size) {
+  if (count_allocations) ++allocation_count;
+  return __libc_malloc(size);
+}
+void* calloc(size_t count, size_t size) {
+  if (count_allocations) ++allocation_count;
+  return __libc_calloc(count, size);
+}
+void* realloc(void* ptr, size_t size) {
+  if (count_allocations) ++allocation_count;
+  return __libc_realloc(ptr, size);
+}
+}  // extern "C"
+#endif  // TEST_COUNT_ALLOCATIONS
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+// Heap allocations are counted by replacing the glibc allocator, see allocation_counter.cpp.
+// This does not work with other C libraries or when a sanitizer replaces the allocator.
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define TEST_COUNT_ALLOCATIONS 1
+#endif
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#undef TEST_COUNT_ALLOCATIONS
+#endif
+#endif  // __has_feature
+
+#ifdef TEST_COUNT_ALLOCATIONS
+/// Calls to malloc, calloc, and realloc are counted in `allocation_count` while this is true.
+extern bool count_allocations;
+extern int64_t allocation_count;
+#endif  // TEST_COUNT_ALLOCATIONS
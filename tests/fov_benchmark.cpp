@@ -0,0 +1,158 @@
+// Field-of-view benchmark over every algorithm, map kind, size, and radius.
+//
+// Prints one JSON object per line so that results can be diffed between builds:
+//   fov_benchmark [min_ms_per_case]
+// `checksum` hashes the computed fov flags and only changes when an algorithm's output changes.
+// `allocations_per_call` and `cache_misses_per_call` are null when they can not be measured on this platform.
+#include <libtcod/fov.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "allocation_counter.hpp"
+#include "fov_maps.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+/// Hardware cache miss counter for the calling thread, inactive if perf events are unavailable.
+class CacheMissCounter {
+ public:
+  CacheMissCounter() {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+  CacheMissCounter(const CacheMissCounter&) = delete;
+  CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+  ~CacheMissCounter() {
+    if (fd_ >= 0) close(fd_);
+  }
+  bool active() const noexcept { return fd_ >= 0; }
+  void start() {
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  int64_t stop() {
+    if (fd_ < 0) return 0;
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    int64_t count = 0;
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) return 0;
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+#else
+class CacheMissCounter {
+ public:
+  bool active() const noexcept { return false; }
+  void start() {}
+  int64_t stop() { return 0; }
+};
+#endif  // __linux__
+
+/// FNV-1a hash of the fov flags of `map`.
+static uint64_t fov_checksum(const TCOD_Map* map) {
+  uint64_t hash = 14695981039346656037ull;
+  for (int i = 0; i < map->nbcells; ++i) {
+    hash ^= map->cells[i].fov;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+int main(int argc, char** argv) {
+  using Clock = std::chrono::steady_clock;
+  const double min_ms = argc > 1 ? std::atof(argv[1]) : 50.0;
+  static constexpr std::array<std::pair<int, int>, 3> SIZES{{{80, 50}, {200, 200}, {1000, 1000}}};
+  static constexpr std::array<int, 4> RADII{{8, 20, 60, 0}};
+  CacheMissCounter cache_misses;
+  for (const auto& [width, height] : SIZES) {
+    for (const auto& [kind, kind_name] : FOV_MAP_KINDS) {
+      const tcod::MapPtr_ map = make_fov_map(kind, width, height, 1);
+      const int pov_x = width / 2;
+      const int pov_y = height / 2;
+      for (const int radius : RADII) {
+        // Cells within the square bounding the view, the whole map if the radius is unlimited.
+        const int64_t scanned_width = radius > 0 ? std::min(width, radius * 2 + 1) : width;
+        const int64_t scanned_height = radius > 0 ? std::min(height, radius * 2 + 1) : height;
+        const int64_t cells = scanned_width * scanned_height;
+        for (int algo = 0; algo < NB_FOV_ALGORITHMS; ++algo) {
+          const auto compute = [&]() {
+            if (TCOD_map_compute_fov(map.get(), pov_x, pov_y, radius, true, (TCOD_fov_algorithm_t)algo) != TCOD_E_OK) {
+              std::fprintf(stderr, "%s\n", TCOD_get_error());
+              std::exit(EXIT_FAILURE);
+            }
+          };
+          compute();  // Warm up any cached tables and scratch memory.
+          const uint64_t checksum = fov_checksum(map.get());
+          int visible = 0;
+          for (int i = 0; i < map->nbcells; ++i) visible += map->cells[i].fov;
+
+          int64_t calls = 0;
+          int64_t misses = 0;
+#ifdef TEST_COUNT_ALLOCATIONS
+          allocation_count = 0;
+          count_allocations = true;
+#endif  // TEST_COUNT_ALLOCATIONS
+          const auto start = Clock::now();
+          auto elapsed = Clock::duration{};
+          do {
+            cache_misses.start();
+            for (int i = 0; i < 8; ++i) compute();
+            misses += cache_misses.stop();
+            calls += 8;
+            elapsed = Clock::now() - start;
+          } while (std::chrono::duration<double, std::milli>(elapsed).count() < min_ms);
+#ifdef TEST_COUNT_ALLOCATIONS
+          count_allocations = false;
+#endif  // TEST_COUNT_ALLOCATIONS
+          const double us_per_call = std::chrono::duration<double, std::micro>(elapsed).count() / calls;
+
+          char allocations[32] = "null";
+#ifdef TEST_COUNT_ALLOCATIONS
+          std::snprintf(allocations, sizeof(allocations), "%.3f", (double)allocation_count / calls);
+#endif  // TEST_COUNT_ALLOCATIONS
+          char misses_text[32] = "null";
+          if (cache_misses.active()) std::snprintf(misses_text, sizeof(misses_text), "%.1f", (double)misses / calls);
+          std::printf(
+              "{\"algorithm\": \"%s\", \"map\": \"%s\", \"width\": %d, \"height\": %d, \"radius\": %d, "
+              "\"calls\": %" PRId64
+              ", \"us_per_call\": %.3f, \"cells_per_us\": %.2f, \"visible\": %d, "
+              "\"allocations_per_call\": %s, \"cache_misses_per_call\": %s, \"checksum\": \"%016" PRIx64 "\"}\n",
+              FOV_ALGORITHM_NAMES[algo],
+              kind_name,
+              width,
+              height,
+              radius,
+              calls,
+              us_per_call,
+              cells / us_per_call,
+              visible,
+              allocations,
+              misses_text,
+              checksum);
+          std::fflush(stdout);
+        }
+      }
+    }
+  }
+  TCOD_fov_free_scratch();
+  return EXIT_SUCCESS;
+}
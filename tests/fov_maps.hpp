@@ -0,0 +1,127 @@
+#pragma once
+
+#include <libtcod/fov.h>
+#include <libtcod/fov.hpp>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// Kinds of generated maps used to test and benchmark field-of-view.
+enum class FOVMapKind { open, pillars, cave, maze };
+
+static constexpr std::array<std::pair<FOVMapKind, const char*>, 4> FOV_MAP_KINDS{{
+    {FOVMapKind::open, "open"},
+    {FOVMapKind::pillars, "pillars"},
+    {FOVMapKind::cave, "cave"},
+    {FOVMapKind::maze, "maze"},
+}};
+
+static constexpr std::array<const char*, NB_FOV_ALGORITHMS> FOV_ALGORITHM_NAMES{
+    "FOV_BASIC",
+    "FOV_DIAMOND",
+    "FOV_SHADOW",
+    "FOV_PERMISSIVE_0",
+    "FOV_PERMISSIVE_1",
+    "FOV_PERMISSIVE_2",
+    "FOV_PERMISSIVE_3",
+    "FOV_PERMISSIVE_4",
+    "FOV_PERMISSIVE_5",
+    "FOV_PERMISSIVE_6",
+    "FOV_PERMISSIVE_7",
+    "FOV_PERMISSIVE_8",
+    "FOV_RESTRICTIVE",
+    "FOV_SYMMETRIC_SHADOWCAST",
+};
+
+/// Small deterministic generator so that maps are the same on every platform.
+class FOVMapRandom {
+ public:
+  explicit FOVMapRandom(uint32_t seed) : state_{seed * 2654435761u + 1} {}
+  uint32_t operator()() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+  bool chance(int percent) { return static_cast<int>((*this)() % 100) < percent; }
+
+ private:
+  uint32_t state_;
+};
+
+/***************************************************************************
+    @brief Generate a map of the given kind.  The center cell is always transparent.
+ */
+static inline tcod::MapPtr_ make_fov_map(FOVMapKind kind, int width, int height, uint32_t seed = 0) {
+  tcod::MapPtr_ map{TCOD_map_new(width, height)};
+  FOVMapRandom rng{seed};
+  auto set = [&](int x, int y, bool transparent) { TCOD_map_set_properties(map.get(), x, y, transparent, transparent); };
+  switch (kind) {
+    case FOVMapKind::open:
+      TCOD_map_clear(map.get(), true, true);
+      break;
+    case FOVMapKind::pillars:
+      TCOD_map_clear(map.get(), true, true);
+      for (int y = 2; y < height; y += 4) {
+        for (int x = 2; x < width; x += 4) set(x, y, false);
+      }
+      break;
+    case FOVMapKind::cave: {
+      // Cellular automata smoothing of random noise.
+      std::vector<bool> open(width * height);
+      for (auto&& cell : open) cell = rng.chance(55);
+      for (int step = 0; step < 4; ++step) {
+        std::vector<bool> next(open.size());
+        for (int y = 0; y < height; ++y) {
+          for (int x = 0; x < width; ++x) {
+            int walls = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+              for (int dx = -1; dx <= 1; ++dx) {
+                const int nx = x + dx;
+                const int ny = y + dy;
+                walls += (nx < 0 || ny < 0 || nx >= width || ny >= height || !open[nx + ny * width]);
+              }
+            }
+            next[x + y * width] = walls < 5;
+          }
+        }
+        open.swap(next);
+      }
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) set(x, y, open[x + y * width]);
+      }
+      break;
+    }
+    case FOVMapKind::maze: {
+      // Depth-first maze with corridors on odd coordinates.
+      TCOD_map_clear(map.get(), false, false);
+      std::vector<std::pair<int, int>> stack{{1, 1}};
+      set(1, 1, true);
+      while (!stack.empty()) {
+        const auto [x, y] = stack.back();
+        std::array<std::pair<int, int>, 4> options;
+        int options_count = 0;
+        for (const auto& [dx, dy] : {std::pair{2, 0}, std::pair{-2, 0}, std::pair{0, 2}, std::pair{0, -2}}) {
+          const int nx = x + dx;
+          const int ny = y + dy;
+          if (nx > 0 && ny > 0 && nx < width - 1 && ny < height - 1 && !TCOD_map_is_transparent(map.get(), nx, ny)) {
+            options[options_count++] = {nx, ny};
+          }
+        }
+        if (!options_count) {
+          stack.pop_back();
+          continue;
+        }
+        const auto [nx, ny] = options[rng() % options_count];
+        set((x + nx) / 2, (y + ny) / 2, true);
+        set(nx, ny, true);
+        stack.push_back({nx, ny});
+      }
+      break;
+    }
+  }
+  set(width / 2, height / 2, true);
+  return map;
+}
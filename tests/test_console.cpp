@@ -2,6 +2,8 @@
 #include <catch2/catch_all.hpp>
 #include <libtcod/console.hpp>
 #include <libtcod/console_printing.hpp>
+#include <random>
+#include <vector>
 
 #include "common.hpp"
 
@@ -110,3 +112,121 @@ TEST_CASE("Console wchar SMP", "[!nonportable][!mayfail][.]") {
   CHECK(console.getChar(0, 0) == 0x1F30D);
   CHECK(console.getChar(1, 0) == 0x20);
 }
+
+TEST_CASE("Console dirty row tracking") {
+  auto console = tcod::Console{8, 4};
+  auto get_versions = [&]() {
+    std::vector<uint64_t> versions;
+    for (int y = 0; y < console.get_height(); ++y) versions.push_back(TCOD_console_get_row_version(console.get(), y));
+    return versions;
+  };
+  // Returns the rows which changed since `before`.
+  auto changed_rows = [&](const std::vector<uint64_t>& before) {
+    std::vector<int> rows;
+    const auto after = get_versions();
+    for (int y = 0; y < console.get_height(); ++y) {
+      if (before.at(y) != after.at(y)) rows.push_back(y);
+    }
+    return rows;
+  };
+  REQUIRE(get_versions() == std::vector<uint64_t>(4, 0));
+  REQUIRE(TCOD_console_set_dirty_tracking(console.get(), true) == TCOD_E_OK);
+  for (const auto version : get_versions()) REQUIRE(version != 0);
+
+  auto before = get_versions();
+  TCOD_console_put_char(console.get(), 1, 2, '@', TCOD_BKGND_SET);
+  REQUIRE(changed_rows(before) == std::vector<int>{2});
+
+  before = get_versions();
+  const TCOD_ColorRGB red{255, 0, 0};
+  TCOD_console_put_rgb(console.get(), 7, 0, 0, &red, nullptr, TCOD_BKGND_SET);
+  REQUIRE(changed_rows(before) == std::vector<int>{0});
+
+  before = get_versions();
+  TCOD_console_set_char_background(console.get(), 0, 3, red, TCOD_BKGND_SET);
+  REQUIRE(changed_rows(before) == std::vector<int>{3});
+
+  before = get_versions();
+  TCOD_console_draw_rect_rgb(console.get(), 2, 1, 3, 2, 'x', nullptr, nullptr, TCOD_BKGND_SET);
+  REQUIRE(changed_rows(before) == std::vector<int>{1, 2});
+
+#ifndef TCOD_NO_UNICODE
+  before = get_versions();
+  tcod::print(console, {0, 3}, "hello", std::nullopt, std::nullopt);
+  REQUIRE(changed_rows(before) == std::vector<int>{3});
+#endif  // TCOD_NO_UNICODE
+
+  before = get_versions();
+  auto source = tcod::Console{2, 2};
+  TCOD_console_blit(source.get(), 0, 0, 0, 0, console.get(), 4, -1, 1.0f, 1.0f);
+  REQUIRE(changed_rows(before) == std::vector<int>{0});
+
+  before = get_versions();
+  console.at(5, 2).ch = 'Z';  // Direct writes need to be marked by hand.
+  REQUIRE(changed_rows(before).empty());
+  TCOD_console_mark_dirty(console.get(), 5, 2, 1, 1);
+  REQUIRE(changed_rows(before) == std::vector<int>{2});
+
+  before = get_versions();
+  TCOD_console_mark_dirty(console.get(), 8, 0, 1, 4);  // Out of bounds.
+  TCOD_console_mark_dirty(console.get(), 0, -3, 8, 2);
+  REQUIRE(changed_rows(before).empty());
+
+  before = get_versions();
+  TCOD_console_clear(console.get());
+  REQUIRE(changed_rows(before) == std::vector<int>{0, 1, 2, 3});
+
+  // Versions are never shared between consoles.
+  REQUIRE(TCOD_console_set_dirty_tracking(source.get(), true) == TCOD_E_OK);
+  for (int y = 0; y < source.get_height(); ++y) {
+    for (const auto version : get_versions()) REQUIRE(TCOD_console_get_row_version(source.get(), y) != version);
+  }
+
+  REQUIRE(TCOD_console_set_dirty_tracking(console.get(), false) == TCOD_E_OK);
+  REQUIRE(get_versions() == std::vector<uint64_t>(4, 0));
+}
+
+TEST_CASE("Console tile diff") {
+  std::mt19937 rng(0);
+  for (const int count : {0, 1, 15, 16, 17, 64, 100, 333}) {
+    std::vector<TCOD_ConsoleTile> tiles(count);
+    for (auto& tile : tiles) {
+      tile = {static_cast<int>(rng() % 512), {uint8_t(rng()), 2, 3, 255}, {uint8_t(rng()), 5, 6, 255}};
+    }
+    std::vector<TCOD_ConsoleTile> cache = tiles;
+    const size_t words = (count + 63) / 64;
+    std::vector<uint64_t> expected_bg(words, 0);
+    std::vector<uint64_t> expected_fg(words, 0);
+    for (int i = 0; i < count; ++i) {
+      switch (rng() % 8) {
+        case 0:
+          cache[i].ch ^= 1;
+          expected_fg[i / 64] |= uint64_t{1} << (i % 64);
+          break;
+        case 1:
+          cache[i].fg.a ^= 1;
+          expected_fg[i / 64] |= uint64_t{1} << (i % 64);
+          break;
+        case 2:
+          cache[i].bg.g ^= 1;
+          expected_bg[i / 64] |= uint64_t{1} << (i % 64);
+          break;
+        case 3:
+          cache[i] = {-1, {0, 0, 0, 0}, {0, 0, 0, 0}};
+          expected_fg[i / 64] |= uint64_t{1} << (i % 64);
+          expected_bg[i / 64] |= uint64_t{1} << (i % 64);
+          break;
+        default:
+          break;
+      }
+    }
+    std::vector<uint64_t> bg(words + 1, ~uint64_t{0});
+    std::vector<uint64_t> fg(words + 1, ~uint64_t{0});
+    const bool any_changed = TCOD_console_diff_tiles(tiles.data(), cache.data(), count, bg.data(), fg.data());
+    INFO("count=" << count);
+    CHECK(std::vector<uint64_t>(bg.begin(), bg.begin() + words) == expected_bg);
+    CHECK(std::vector<uint64_t>(fg.begin(), fg.begin() + words) == expected_fg);
+    CHECK(bg.at(words) == ~uint64_t{0});  // Words past the end are untouched.
+    CHECK(any_changed == (expected_bg != std::vector<uint64_t>(words, 0) || expected_fg != std::vector<uint64_t>(words, 0)));
+  }
+}
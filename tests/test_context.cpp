@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <libtcod.hpp>
 #include <utility>
+#include <vector>
 
 #include "common.hpp"
 
@@ -67,3 +68,85 @@ TEST_CASE("SDL Renderer", "[!nonportable]") { test_renderer(TCOD_RENDERER_SDL);
 TEST_CASE("OPENGL Renderer", "[!nonportable]") { test_renderer(TCOD_RENDERER_OPENGL); }
 TEST_CASE("OPENGL2 Renderer", "[!nonportable]") { test_renderer(TCOD_RENDERER_OPENGL2); }
 #endif  // NO_SDL
+
+TEST_CASE("Headless Renderer") {
+  auto tileset = tcod::Tileset{2, 3};
+  const std::vector<TCOD_ColorRGBA> glyph(6, TCOD_ColorRGBA{255, 255, 255, 255});
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), '#', glyph.data()) == TCOD_E_OK);
+  auto context = tcod::ContextPtr{TCOD_renderer_init_headless(8, 4, tileset.get())};
+  REQUIRE(context);
+  CHECK(context->type == TCOD_RENDERER_HEADLESS);
+  int columns = 0;
+  int rows = 0;
+  REQUIRE(TCOD_context_recommended_console_size(context.get(), 1.0f, &columns, &rows) == TCOD_E_OK);
+  CHECK(columns == 8);
+  CHECK(rows == 4);
+
+  auto console = tcod::Console{columns, rows};
+  console.at(1, 2) = {'#', {10, 20, 30, 255}, {1, 2, 3, 255}};
+  REQUIRE(TCOD_context_present(context.get(), console.get(), nullptr) == TCOD_E_OK);
+  int width = 0;
+  int height = 0;
+  const TCOD_ColorRGBA* pixels = TCOD_context_headless_get_pixels(context.get(), &width, &height);
+  REQUIRE(pixels);
+  REQUIRE(width == 16);
+  REQUIRE(height == 12);
+  CHECK(pixels[7 * width + 3].r == 10);
+  CHECK(pixels[7 * width + 4].r == 0);
+
+  // Changing a tile of the tileset redraws the tiles which use it.
+  const std::vector<TCOD_ColorRGBA> blank(6, TCOD_ColorRGBA{255, 255, 255, 0});
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), '#', blank.data()) == TCOD_E_OK);
+  REQUIRE(TCOD_context_present(context.get(), console.get(), nullptr) == TCOD_E_OK);
+  std::vector<TCOD_ColorRGBA> capture(width * height);
+  REQUIRE(TCOD_context_screen_capture(context.get(), capture.data(), &width, &height) == TCOD_E_OK);
+  CHECK(capture.at(7 * width + 3).r == 1);
+
+  double x = 5;
+  double y = 7;
+  REQUIRE(TCOD_context_screen_pixel_to_tile_d(context.get(), &x, &y) == TCOD_E_OK);
+  CHECK(x == 2.5);
+  CHECK(y == Catch::Approx(7.0 / 3.0));
+}
+
+TEST_CASE("Headless Renderer batched tile changes") {
+  auto tileset = tcod::Tileset{2, 3};
+  const std::vector<TCOD_ColorRGBA> solid(6, TCOD_ColorRGBA{255, 255, 255, 255});
+  const std::vector<TCOD_ColorRGBA> blank(6, TCOD_ColorRGBA{255, 255, 255, 0});
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'a', solid.data()) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'b', solid.data()) == TCOD_E_OK);
+  auto context = tcod::ContextPtr{TCOD_renderer_init_headless(2, 1, tileset.get())};
+  REQUIRE(context);
+  auto console = tcod::Console{2, 1};
+  console.at(0, 0) = {'a', {10, 20, 30, 255}, {1, 2, 3, 255}};
+  console.at(1, 0) = {'b', {10, 20, 30, 255}, {1, 2, 3, 255}};
+  REQUIRE(TCOD_context_present(context.get(), console.get(), nullptr) == TCOD_E_OK);
+  int width = 0;
+  int height = 0;
+  const TCOD_ColorRGBA* pixels = TCOD_context_headless_get_pixels(context.get(), &width, &height);
+  REQUIRE(pixels);
+  CHECK(pixels[0].r == 10);
+  CHECK(pixels[2].r == 10);
+
+  // Nested batches notify observers once the outermost batch ends.
+  TCOD_tileset_begin_batch(tileset.get());
+  TCOD_tileset_begin_batch(tileset.get());
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'a', blank.data()) == TCOD_E_OK);
+  TCOD_tileset_end_batch(tileset.get());
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'b', blank.data()) == TCOD_E_OK);
+  TCOD_tileset_end_batch(tileset.get());
+  TCOD_tileset_end_batch(tileset.get());  // Unbalanced calls are ignored.
+  REQUIRE(TCOD_context_present(context.get(), console.get(), nullptr) == TCOD_E_OK);
+  pixels = TCOD_context_headless_get_pixels(context.get(), &width, &height);
+  REQUIRE(pixels);
+  CHECK(pixels[0].r == 1);
+  CHECK(pixels[2].r == 1);
+
+  // Changes outside of a batch still notify observers immediately.
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'a', solid.data()) == TCOD_E_OK);
+  REQUIRE(TCOD_context_present(context.get(), console.get(), nullptr) == TCOD_E_OK);
+  pixels = TCOD_context_headless_get_pixels(context.get(), &width, &height);
+  REQUIRE(pixels);
+  CHECK(pixels[0].r == 10);
+  CHECK(pixels[2].r == 1);
+}
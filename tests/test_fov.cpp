@@ -1,9 +1,20 @@
+#include <libtcod/bresenham.h>
 #include <libtcod/fov.h>
+#include <libtcod/fov_chunked.h>
+#include <libtcod/path.h>
 
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
 #include <catch2/catch_all.hpp>
+#include <map>
 #include <utility>
 #include <vector>
 
+#include "allocation_counter.hpp"
+#include "fov_maps.hpp"
+
 // Regression for the view_array_insert off-by-one: it writes one past the
 // active_views buffer (sized width*height). The only trigger is a 2x2 map at
 // FOV_PERMISSIVE_8; under AddressSanitizer this aborts before the fix.
@@ -103,3 +114,654 @@ TEST_CASE("restrictive FOV: larger non-square overflow envelope", "[fov][bug3]")
     TCOD_map_delete(map);
   }
 }
+
+TEST_CASE("FOV visible list matches the dense fov flags", "[fov]") {
+  const int WIDTH = 40;
+  const int HEIGHT = 30;
+  TCOD_Map* dense = TCOD_map_new(WIDTH, HEIGHT);
+  TCOD_Map* sparse = TCOD_map_new(WIDTH, HEIGHT);
+  TCOD_map_clear(dense, true, true);
+  unsigned int seed = 1;
+  for (int i = 0; i < WIDTH * HEIGHT; ++i) {
+    seed = seed * 1103515245 + 12345;
+    if ((seed >> 16) % 4 == 0) dense->cells[i].transparent = false;
+  }
+  REQUIRE(TCOD_map_copy(dense, sparse) == TCOD_E_OK);
+  TCOD_FOVVisible visible{};
+  for (int algo = 0; algo < NB_FOV_ALGORITHMS; ++algo) {
+    for (const int radius : {0, 1, 5, 12}) {
+      for (const auto& pov : {std::pair{20, 15}, std::pair{0, 0}, std::pair{39, 3}}) {
+        CAPTURE(algo, radius, pov.first, pov.second);
+        REQUIRE(
+            TCOD_map_compute_fov(dense, pov.first, pov.second, radius, true, (TCOD_fov_algorithm_t)algo) == TCOD_E_OK);
+        REQUIRE(
+            TCOD_map_compute_fov_visible(
+                sparse, pov.first, pov.second, radius, true, (TCOD_fov_algorithm_t)algo, &visible) == TCOD_E_OK);
+        int expected_count = 0;
+        for (int i = 0; i < WIDTH * HEIGHT; ++i) {
+          expected_count += dense->cells[i].fov;
+          CHECK(dense->cells[i].fov == sparse->cells[i].fov);
+        }
+        REQUIRE(visible.count == expected_count);
+        int span_cells = 0;
+        for (int i = 0; i < visible.spans_count; ++i) {
+          const TCOD_FOVSpan& span = visible.spans[i];
+          span_cells += span.x_end - span.x_begin;
+          for (int x = span.x_begin; x < span.x_end; ++x) CHECK(TCOD_map_is_in_fov(dense, x, span.y));
+        }
+        CHECK(span_cells == visible.count);
+        for (int i = 0; i < visible.count; ++i) CHECK(TCOD_map_is_in_fov(dense, visible.cells[i][0], visible.cells[i][1]));
+      }
+    }
+  }
+  TCOD_fov_visible_uninit(&visible);
+  TCOD_map_delete(sparse);
+  TCOD_map_delete(dense);
+}
+
+namespace {
+struct ChunkStore {
+  std::map<std::pair<int, int>, std::vector<TCOD_MapCell>> chunks;
+  int loads = 0;
+  int misses = 0;  // Loads of chunks which were never stored.
+  int evictions = 0;
+};
+}  // namespace
+
+TEST_CASE("Chunked map streams chunks through callbacks", "[fov]") {
+  ChunkStore store;
+  TCOD_ChunkedMapCallbacks callbacks{};
+  callbacks.userdata = &store;
+  callbacks.load = [](void* userdata, int chunk_x, int chunk_y, TCOD_MapCell* cells) {
+    auto& self = *static_cast<ChunkStore*>(userdata);
+    auto it = self.chunks.find({chunk_x, chunk_y});
+    if (it == self.chunks.end()) {
+      ++self.misses;
+      return false;
+    }
+    ++self.loads;
+    std::copy(it->second.begin(), it->second.end(), cells);
+    return true;
+  };
+  callbacks.evict = [](void* userdata, int chunk_x, int chunk_y, const TCOD_MapCell* cells) {
+    auto& self = *static_cast<ChunkStore*>(userdata);
+    ++self.evictions;
+    self.chunks[{chunk_x, chunk_y}].assign(cells, cells + TCOD_MAP_CHUNK_SIZE * TCOD_MAP_CHUNK_SIZE);
+  };
+  TCOD_ChunkedMap* map = TCOD_chunked_map_new(true, true, 2, &callbacks);
+  REQUIRE(map);
+  CHECK(TCOD_chunked_map_is_transparent(map, 1000, -1000));
+  CHECK(TCOD_chunked_map_is_walkable(map, 1000, -1000));
+  CHECK(TCOD_chunked_map_get_nb_chunks(map) == 0);  // Reads do not allocate.
+  CHECK(store.misses == 1);  // Chunks with nothing stored are only looked up once.
+  REQUIRE(TCOD_chunked_map_set_properties(map, -1, -1, false, false) == TCOD_E_OK);
+  REQUIRE(TCOD_chunked_map_set_properties(map, 0, 0, false, true) == TCOD_E_OK);
+  REQUIRE(TCOD_chunked_map_set_properties(map, 200, 0, true, false) == TCOD_E_OK);
+  CHECK(TCOD_chunked_map_get_nb_chunks(map) == 2);
+  CHECK(store.evictions == 1);  // The chunk holding {-1, -1} was the least recently used.
+  CHECK(!TCOD_chunked_map_is_transparent(map, -1, -1));  // Loaded back from the store.
+  CHECK(!TCOD_chunked_map_is_walkable(map, -1, -1));
+  CHECK(store.loads == 1);
+  CHECK(!TCOD_chunked_map_is_transparent(map, 0, 0));
+  CHECK(TCOD_chunked_map_is_walkable(map, 0, 0));
+  CHECK(!TCOD_chunked_map_is_walkable(map, 200, 0));
+  // Writing to a chunk which was missing allocates it without looking it up again.
+  const int misses = store.misses;
+  REQUIRE(TCOD_chunked_map_set_properties(map, 1000, -1000, false, true) == TCOD_E_OK);
+  CHECK(!TCOD_chunked_map_is_transparent(map, 1000, -1000));
+  CHECK(TCOD_chunked_map_is_transparent(map, 1001, -1000));
+  CHECK(store.misses == misses);
+  TCOD_chunked_map_delete(map);
+  CHECK(store.chunks.size() == 4);
+}
+
+TEST_CASE("Chunked map FOV and pathfinding cross chunk boundaries", "[fov]") {
+  TCOD_ChunkedMap* map = TCOD_chunked_map_new(true, true, 0, nullptr);
+  REQUIRE(map);
+  // A wall along x=2 crossing the chunk boundary at y=0, with a gap at y=10.
+  for (int y = -20; y <= 20; ++y) {
+    if (y != 10) REQUIRE(TCOD_chunked_map_set_properties(map, 2, y, false, false) == TCOD_E_OK);
+  }
+  REQUIRE(TCOD_chunked_map_compute_fov(map, 0, 0, 8, false, FOV_SYMMETRIC_SHADOWCAST) == TCOD_E_OK);
+  CHECK(TCOD_chunked_map_is_in_fov(map, 0, 0));
+  CHECK(TCOD_chunked_map_is_in_fov(map, -5, -5));
+  CHECK(!TCOD_chunked_map_is_in_fov(map, 4, 0));
+  CHECK(!TCOD_chunked_map_is_in_fov(map, 100, 100));
+
+  TCOD_Map* dense = TCOD_map_new(20, 20);
+  REQUIRE(TCOD_chunked_map_extract(map, -10, -10, dense) == TCOD_E_OK);
+  CHECK(!TCOD_map_is_transparent(dense, 12, 10));
+  CHECK(TCOD_map_is_transparent(dense, 11, 10));
+  TCOD_map_delete(dense);
+
+  TCOD_ChunkedMapRegion region{map, -10, -10};
+  TCOD_Path* path = TCOD_path_new_using_function(40, 40, TCOD_chunked_map_path_func, &region, 1.41f);
+  REQUIRE(TCOD_path_compute(path, 10, 10, 14, 10));  // From {0, 0} to {4, 0} through the gap.
+  for (int i = 0; i < TCOD_path_size(path); ++i) {
+    int x, y;
+    TCOD_path_get(path, i, &x, &y);
+    CHECK(TCOD_chunked_map_is_walkable(map, x - 10, y - 10));
+  }
+  CHECK(TCOD_path_size(path) > 10);
+  TCOD_path_delete(path);
+  TCOD_chunked_map_delete(map);
+}
+
+static bool reference_line_of_sight(const TCOD_Map* map, int x1, int y1, int x2, int y2) {
+  if (x1 < 0 || y1 < 0 || x1 >= map->width || y1 >= map->height) return false;
+  if (x2 < 0 || y2 < 0 || x2 >= map->width || y2 >= map->height) return false;
+  TCOD_bresenham_data_t data;
+  TCOD_line_init_mt(x1, y1, x2, y2, &data);
+  int x = x1;
+  int y = y1;
+  while (!TCOD_line_step_mt(&x, &y, &data) && (x != x2 || y != y2)) {
+    if (!TCOD_map_is_transparent(map, x, y)) return false;
+  }
+  return true;
+}
+
+TEST_CASE("Batched line-of-sight matches Bresenham line walks", "[fov]") {
+  const int WIDTH = 50;
+  const int HEIGHT = 40;
+  TCOD_Map* map = TCOD_map_new(WIDTH, HEIGHT);
+  TCOD_map_clear(map, true, true);
+  unsigned int seed = 7;
+  auto next = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return static_cast<int>(seed >> 16);
+  };
+  for (int i = 0; i < WIDTH * HEIGHT; ++i) {
+    if (next() % 6 == 0) map->cells[i].transparent = false;
+  }
+  for (const int count : {0, 1, 13, 200, 5000}) {
+    CAPTURE(count);
+    std::vector<std::array<int, 4>> pairs(count);
+    for (auto& pair : pairs) {
+      // Include some out-of-bounds endpoints and repeated displacements.
+      for (auto& v : pair) v = next() % (WIDTH + 4) - 2;
+      if (next() % 4 == 0) pair = {pair[0], pair[1], pair[0] + 5, pair[1] - 3};
+    }
+    std::vector<uint8_t> out((count + 7) / 8, 0xff);
+    REQUIRE(
+        TCOD_map_compute_line_of_sight(
+            map, count, reinterpret_cast<const int(*)[4]>(pairs.data()), out.data()) == TCOD_E_OK);
+    for (int i = 0; i < count; ++i) {
+      const auto& p = pairs[i];
+      CAPTURE(i, p[0], p[1], p[2], p[3]);
+      const bool result = (out[i / 8] >> (i % 8)) & 1;
+      REQUIRE(result == reference_line_of_sight(map, p[0], p[1], p[2], p[3]));
+    }
+    if (count % 8) REQUIRE((out.back() >> (count % 8)) == 0);
+  }
+  TCOD_map_delete(map);
+}
+
+TEST_CASE("Permissive and diamond FOV reuse their scratch memory", "[fov]") {
+  TCOD_Map* map = TCOD_map_new(60, 40);
+  TCOD_map_clear(map, true, true);
+  for (int i = 0; i < map->nbcells; i += 7) map->cells[i].transparent = false;
+  for (const auto algo : {FOV_DIAMOND, FOV_PERMISSIVE_0, FOV_PERMISSIVE_8}) {
+    CAPTURE(algo);
+    REQUIRE(TCOD_map_compute_fov(map, 30, 20, 0, true, algo) == TCOD_E_OK);  // Grow the scratch buffer.
+#ifdef TEST_COUNT_ALLOCATIONS
+    allocation_count = 0;
+    count_allocations = true;
+#endif  // TEST_COUNT_ALLOCATIONS
+    for (int i = 0; i < 10; ++i) {
+      if (TCOD_map_compute_fov(map, 10 + i * 4, 5 + i * 3, 8 + i, i % 2, algo) != TCOD_E_OK) break;
+    }
+#ifdef TEST_COUNT_ALLOCATIONS
+    count_allocations = false;
+    CHECK(allocation_count == 0);
+#endif  // TEST_COUNT_ALLOCATIONS
+    CHECK(TCOD_map_is_in_fov(map, 46, 32));
+  }
+  // Results still match after the scratch memory is freed and reacquired.
+  TCOD_Map* copy = TCOD_map_new(60, 40);
+  REQUIRE(TCOD_map_copy(map, copy) == TCOD_E_OK);
+  REQUIRE(TCOD_map_compute_fov(map, 12, 9, 0, true, FOV_PERMISSIVE_4) == TCOD_E_OK);
+  TCOD_fov_free_scratch();
+  REQUIRE(TCOD_map_compute_fov(copy, 12, 9, 0, true, FOV_PERMISSIVE_4) == TCOD_E_OK);
+  for (int i = 0; i < map->nbcells; ++i) REQUIRE(map->cells[i].fov == copy->cells[i].fov);
+  TCOD_map_delete(copy);
+  TCOD_map_delete(map);
+  TCOD_fov_free_scratch();
+}
+
+// FOV_BASIC without light_walls: every cell reached by a Bresenham ray towards the view perimeter.
+static std::vector<bool> reference_basic_fov(const TCOD_Map* map, int pov_x, int pov_y, int radius) {
+  std::vector<bool> fov(map->nbcells, false);
+  fov[pov_x + pov_y * map->width] = true;
+  const int x_min = std::max(0, pov_x - radius);
+  const int y_min = std::max(0, pov_y - radius);
+  const int x_max = std::min(map->width - 1, pov_x + radius);
+  const int y_max = std::min(map->height - 1, pov_y + radius);
+  for (int y = y_min; y <= y_max; ++y) {
+    for (int x = x_min; x <= x_max; ++x) {
+      if (x != x_min && x != x_max && y != y_min && y != y_max) continue;
+      TCOD_bresenham_data_t data;
+      TCOD_line_init_mt(pov_x, pov_y, x, y, &data);
+      int cx;
+      int cy;
+      while (!TCOD_line_step_mt(&cx, &cy, &data)) {
+        if ((cx - pov_x) * (cx - pov_x) + (cy - pov_y) * (cy - pov_y) > radius * radius) break;
+        if (!TCOD_map_is_transparent(map, cx, cy)) break;
+        fov[cx + cy * map->width] = true;
+      }
+    }
+  }
+  return fov;
+}
+
+TEST_CASE("FOV_BASIC cached rays match Bresenham rays", "[fov]") {
+  TCOD_Map* map = TCOD_map_new(70, 60);
+  TCOD_map_clear(map, true, true);
+  unsigned int seed = 3;
+  for (int i = 0; i < map->nbcells; ++i) {
+    seed = seed * 1103515245 + 12345;
+    if ((seed >> 16) % 5 == 0) map->cells[i].transparent = false;
+  }
+  for (const int radius : {1, 2, 7, 20, 29}) {
+    for (const auto& pov : {std::pair{35, 30}, std::pair{30, 29}, std::pair{3, 4}, std::pair{68, 50}}) {
+      CAPTURE(radius, pov.first, pov.second);
+      REQUIRE(TCOD_map_compute_fov(map, pov.first, pov.second, radius, false, FOV_BASIC) == TCOD_E_OK);
+      const std::vector<bool> expected = reference_basic_fov(map, pov.first, pov.second, radius);
+      for (int i = 0; i < map->nbcells; ++i) REQUIRE(map->cells[i].fov == expected[i]);
+    }
+  }
+  TCOD_map_delete(map);
+  TCOD_fov_free_scratch();
+}
+
+TEST_CASE("FOV benchmarks", "[.benchmark]") {
+  TCOD_Map* map = TCOD_map_new(100, 100);
+  TCOD_map_clear(map, true, true);
+  for (int i = 0; i < map->nbcells; i += 11) map->cells[i].transparent = false;
+  BENCHMARK("FOV_BASIC radius 20") { return TCOD_map_compute_fov(map, 50, 50, 20, true, FOV_BASIC); };
+  TCOD_map_delete(map);
+}
+
+// The original floating point FOV_SYMMETRIC_SHADOWCAST scan, before slopes were made into exact fractions.
+namespace float_symmetric_shadowcast {
+struct Row {
+  int pov_x;
+  int pov_y;
+  int quadrant;
+  int max_depth;
+  int depth;
+  float slope_low;
+  float slope_high;
+};
+static const int quadrant_table[4][4] = {{1, 0, 0, 1}, {0, 1, 1, 0}, {0, -1, -1, 0}, {-1, 0, 0, -1}};
+static float slope(int depth, int column) { return (2.0f * column - 1.0f) / (2.0f * depth); }
+static bool in_map(const TCOD_Map* map, int x, int y) { return 0 <= x && x < map->width && 0 <= y && y < map->height; }
+static void scan(TCOD_Map* map, Row& row) {
+  const int* q = quadrant_table[row.quadrant];
+  if (row.max_depth > 0 && row.depth >= row.max_depth) return;
+  if (!in_map(map, row.pov_x + row.depth * q[0], row.pov_y + row.depth * q[2])) return;
+  const float low = row.depth * row.slope_low;
+  const float high = row.depth * row.slope_high;
+  const int column_min = static_cast<int>(std::round(low * (1 + FLT_EPSILON)));
+  const int column_max = static_cast<int>(std::round(high * (1 - FLT_EPSILON)));
+  bool prev_wall = false;
+  for (int column = column_min; column <= column_max; ++column) {
+    const int x = row.pov_x + row.depth * q[0] + column * q[1];
+    const int y = row.pov_y + row.depth * q[2] + column * q[3];
+    if (!in_map(map, x, y)) continue;
+    TCOD_MapCell& cell = map->cells[x + y * map->width];
+    const bool wall = !cell.transparent;
+    if (wall || (column >= row.depth * row.slope_low && column <= row.depth * row.slope_high)) cell.fov = true;
+    if (prev_wall && !wall) row.slope_low = slope(row.depth, column);
+    if (column != column_min && !prev_wall && wall) {
+      Row next{row.pov_x, row.pov_y, row.quadrant, row.max_depth, row.depth + 1, row.slope_low, slope(row.depth, column)};
+      scan(map, next);
+    }
+    prev_wall = wall;
+  }
+  if (!prev_wall) {
+    row.depth += 1;
+    scan(map, row);
+  }
+}
+static void compute(TCOD_Map* map, int pov_x, int pov_y, int max_radius, bool light_walls) {
+  for (int i = 0; i < map->nbcells; ++i) map->cells[i].fov = false;
+  map->cells[pov_x + pov_y * map->width].fov = true;
+  for (int quadrant = 0; quadrant < 4; ++quadrant) {
+    Row row{pov_x, pov_y, quadrant, std::max(max_radius, 0), 1, -1.0f, 1.0f};
+    scan(map, row);
+  }
+  for (int y = 0; y < map->height; ++y) {
+    for (int x = 0; x < map->width; ++x) {
+      TCOD_MapCell& cell = map->cells[x + y * map->width];
+      if (!light_walls && !cell.transparent) cell.fov = false;
+      const int dx = x - pov_x;
+      const int dy = y - pov_y;
+      if (max_radius > 0 && dx * dx + dy * dy >= max_radius * max_radius) cell.fov = false;
+    }
+  }
+}
+}  // namespace float_symmetric_shadowcast
+
+static void random_walls(TCOD_Map* map, unsigned int seed, int one_in) {
+  TCOD_map_clear(map, true, true);
+  for (int i = 0; i < map->nbcells; ++i) {
+    seed = seed * 1103515245 + 12345;
+    if ((seed >> 16) % one_in == 0) map->cells[i].transparent = false;
+  }
+}
+
+TEST_CASE("Integer symmetric shadowcast matches the float implementation", "[fov]") {
+  TCOD_Map* map = TCOD_map_new(61, 47);
+  TCOD_Map* expected = TCOD_map_new(61, 47);
+  long cells_checked = 0;
+  long float_misses = 0;  // Exact ties on a view edge which float rounding excluded.
+  for (unsigned int seed = 0; seed < 12; ++seed) {
+    random_walls(map, seed, 3 + seed % 5);
+    REQUIRE(TCOD_map_copy(map, expected) == TCOD_E_OK);
+    for (const int radius : {0, 4, 15, 40}) {
+      for (const bool light_walls : {false, true}) {
+        for (int pov = 0; pov < map->nbcells; pov += 97) {
+          const int pov_x = pov % map->width;
+          const int pov_y = pov / map->width;
+          CAPTURE(seed, radius, light_walls, pov_x, pov_y);
+          REQUIRE(TCOD_map_compute_fov(map, pov_x, pov_y, radius, light_walls, FOV_SYMMETRIC_SHADOWCAST) == TCOD_E_OK);
+          float_symmetric_shadowcast::compute(expected, pov_x, pov_y, radius, light_walls);
+          int extra_cells = 0;  // Cells seen by the float version only.
+          for (int i = 0; i < map->nbcells; ++i) {
+            if (map->cells[i].fov && !expected->cells[i].fov) ++float_misses;
+            if (!map->cells[i].fov && expected->cells[i].fov) ++extra_cells;
+          }
+          REQUIRE(extra_cells == 0);
+          cells_checked += map->nbcells;
+        }
+      }
+    }
+  }
+  CHECK(float_misses * 100000 < cells_checked);
+  TCOD_map_delete(expected);
+  TCOD_map_delete(map);
+}
+
+TEST_CASE("Symmetric shadowcast is symmetric between floor tiles", "[fov]") {
+  const int WIDTH = 33;
+  const int HEIGHT = 27;
+  TCOD_Map* map = TCOD_map_new(WIDTH, HEIGHT);
+  random_walls(map, 42, 4);
+  std::vector<std::vector<bool>> views;
+  for (int i = 0; i < map->nbcells; ++i) {
+    if (!map->cells[i].transparent) {
+      views.emplace_back();
+      continue;
+    }
+    REQUIRE(TCOD_map_compute_fov(map, i % WIDTH, i / WIDTH, 0, false, FOV_SYMMETRIC_SHADOWCAST) == TCOD_E_OK);
+    std::vector<bool> view(map->nbcells);
+    for (int j = 0; j < map->nbcells; ++j) view[j] = map->cells[j].fov;
+    views.push_back(std::move(view));
+  }
+  int asymmetric_pairs = 0;
+  for (int a = 0; a < map->nbcells; ++a) {
+    if (!map->cells[a].transparent) continue;
+    for (int b = a + 1; b < map->nbcells; ++b) {
+      if (map->cells[b].transparent && views[a][b] != views[b][a]) ++asymmetric_pairs;
+    }
+  }
+  CHECK(asymmetric_pairs == 0);
+  TCOD_map_delete(map);
+}
+
+TEST_CASE("Symmetric shadowcast benchmarks", "[.benchmark]") {
+  TCOD_Map* map = TCOD_map_new(100, 100);
+  random_walls(map, 1, 6);
+  BENCHMARK("FOV_SYMMETRIC_SHADOWCAST radius 20") {
+    return TCOD_map_compute_fov(map, 50, 50, 20, true, FOV_SYMMETRIC_SHADOWCAST);
+  };
+  BENCHMARK("Float symmetric shadowcast radius 20") {
+    float_symmetric_shadowcast::compute(map, 50, 50, 20, true);
+    return map->cells[0].fov;
+  };
+  BENCHMARK("FOV_SYMMETRIC_SHADOWCAST unlimited") {
+    return TCOD_map_compute_fov(map, 50, 50, 0, true, FOV_SYMMETRIC_SHADOWCAST);
+  };
+  BENCHMARK("Float symmetric shadowcast unlimited") {
+    float_symmetric_shadowcast::compute(map, 50, 50, 0, true);
+    return map->cells[0].fov;
+  };
+  TCOD_map_delete(map);
+}
+
+// The original cell by cell light_walls pass, applied to one quadrant.
+static void reference_postprocess_quadrant(TCOD_Map* map, int x0, int y0, int x1, int y1, int dx, int dy) {
+  for (int cx = x0; cx <= x1; cx++) {
+    for (int cy = y0; cy <= y1; cy++) {
+      if (!map->cells[cx + cy * map->width].fov || !map->cells[cx + cy * map->width].transparent) continue;
+      const int x2 = cx + dx;
+      const int y2 = cy + dy;
+      const bool x2_in = x2 >= x0 && x2 <= x1;
+      const bool y2_in = y2 >= y0 && y2 <= y1;
+      if (x2_in && !map->cells[x2 + cy * map->width].transparent) map->cells[x2 + cy * map->width].fov = true;
+      if (y2_in && !map->cells[cx + y2 * map->width].transparent) map->cells[cx + y2 * map->width].fov = true;
+      if (x2_in && y2_in && !map->cells[x2 + y2 * map->width].transparent) map->cells[x2 + y2 * map->width].fov = true;
+    }
+  }
+}
+
+TEST_CASE("FOV light_walls pass matches the cell by cell version", "[fov]") {
+  TCOD_Map* map = TCOD_map_new(150, 37);  // Wider than two words per bit row.
+  TCOD_Map* expected = TCOD_map_new(150, 37);
+  // FOV_DIAMOND only uses light_walls for this pass.
+  for (unsigned int seed = 0; seed < 4; ++seed) {
+    random_walls(map, seed, 3 + seed);
+    for (const int radius : {0, 1, 5, 40, 70}) {
+      for (const auto& pov : {std::pair{75, 18}, std::pair{0, 0}, std::pair{149, 36}, std::pair{63, 5}}) {
+        CAPTURE(seed, radius, pov.first, pov.second);
+        REQUIRE(TCOD_map_compute_fov(map, pov.first, pov.second, radius, false, FOV_DIAMOND) == TCOD_E_OK);
+        REQUIRE(TCOD_map_copy(map, expected) == TCOD_E_OK);
+        const int x_min = radius > 0 ? std::max(0, pov.first - radius) : 0;
+        const int y_min = radius > 0 ? std::max(0, pov.second - radius) : 0;
+        const int x_max = radius > 0 ? std::min(map->width - 1, pov.first + radius) : map->width - 1;
+        const int y_max = radius > 0 ? std::min(map->height - 1, pov.second + radius) : map->height - 1;
+        reference_postprocess_quadrant(expected, x_min, y_min, pov.first, pov.second, -1, -1);
+        reference_postprocess_quadrant(expected, pov.first, y_min, x_max, pov.second, 1, -1);
+        reference_postprocess_quadrant(expected, x_min, pov.second, pov.first, y_max, -1, 1);
+        reference_postprocess_quadrant(expected, pov.first, pov.second, x_max, y_max, 1, 1);
+        REQUIRE(TCOD_map_compute_fov(map, pov.first, pov.second, radius, true, FOV_DIAMOND) == TCOD_E_OK);
+        int mismatches = 0;
+        for (int i = 0; i < map->nbcells; ++i) mismatches += map->cells[i].fov != expected->cells[i].fov;
+        REQUIRE(mismatches == 0);
+      }
+    }
+  }
+  TCOD_map_delete(expected);
+  TCOD_map_delete(map);
+}
+
+TEST_CASE("FOV bit row conversions", "[fov]") {
+  for (const int width : {1, 8, 63, 64, 65, 130}) {
+    CAPTURE(width);
+    const int height = 5;
+    const int stride = (width + 63) / 64;
+    TCOD_Map* map = TCOD_map_new(width, height);
+    random_walls(map, width, 3);
+    for (int i = 0; i < map->nbcells; ++i) map->cells[i].fov = i % 7 < 3;
+    std::vector<uint64_t> transparent(stride * height, ~uint64_t{0});
+    std::vector<uint64_t> fov(stride * height, ~uint64_t{0});
+    REQUIRE(TCOD_map_get_transparent_bits(map, transparent.data()) == TCOD_E_OK);
+    REQUIRE(TCOD_map_get_fov_bits(map, fov.data()) == TCOD_E_OK);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < stride * 64; ++x) {
+        const bool in_map = x < width;
+        const int i = x + y * width;
+        CAPTURE(x, y);
+        CHECK(((transparent[y * stride + x / 64] >> (x % 64)) & 1) == (in_map && map->cells[i].transparent));
+        CHECK(((fov[y * stride + x / 64] >> (x % 64)) & 1) == (in_map && map->cells[i].fov));
+      }
+    }
+    TCOD_map_clear(map, true, true);
+    REQUIRE(TCOD_map_set_fov_bits(map, transparent.data()) == TCOD_E_OK);
+    std::vector<uint64_t> round_trip(stride * height);
+    REQUIRE(TCOD_map_get_fov_bits(map, round_trip.data()) == TCOD_E_OK);
+    CHECK(round_trip == transparent);
+    TCOD_map_delete(map);
+  }
+}
+
+TEST_CASE("Observers of a cell match the views from each observer", "[fov]") {
+  TCOD_Map* map = TCOD_map_new(40, 30);
+  random_walls(map, 11, 4);
+  map->cells[0].fov = true;  // Must be left alone.
+  std::vector<std::array<int, 2>> observers;
+  for (int i = 0; i < map->nbcells; i += 3) {
+    if (map->cells[i].transparent) observers.push_back({i % map->width, i / map->width});
+  }
+  observers.push_back({-1, 5});  // Out of bounds.
+  TCOD_Map* view = TCOD_map_new(40, 30);
+  REQUIRE(TCOD_map_copy(map, view) == TCOD_E_OK);
+  for (const int radius : {0, 6, 15}) {
+    for (const auto& target : {std::pair{20, 15}, std::pair{1, 1}, std::pair{38, 27}}) {
+      CAPTURE(radius, target.first, target.second);
+      map->cells[target.first + target.second * map->width].transparent = true;
+      view->cells[target.first + target.second * map->width].transparent = true;
+      std::vector<int> found(observers.size());
+      int found_count = -1;
+      REQUIRE(
+          TCOD_map_compute_observers(
+              map,
+              target.first,
+              target.second,
+              radius,
+              static_cast<int>(observers.size()),
+              reinterpret_cast<const int(*)[2]>(observers.data()),
+              found.data(),
+              &found_count) == TCOD_E_OK);
+      found.resize(found_count);
+      std::vector<int> expected;
+      for (int i = 0; i < static_cast<int>(observers.size()) - 1; ++i) {
+        const auto [x, y] = observers[i];
+        REQUIRE(TCOD_map_compute_fov(view, x, y, radius, true, FOV_SYMMETRIC_SHADOWCAST) == TCOD_E_OK);
+        if (TCOD_map_is_in_fov(view, target.first, target.second)) expected.push_back(i);
+      }
+      CHECK(found == expected);
+      CHECK(!found.empty());
+    }
+  }
+  CHECK(map->cells[0].fov);
+  TCOD_map_delete(view);
+  TCOD_map_delete(map);
+  TCOD_fov_free_scratch();
+}
+
+TEST_CASE("Layered FOV sees between layers through floor openings", "[fov]") {
+  const int WIDTH = 40;
+  const int HEIGHT = 30;
+  std::vector<TCOD_Map*> layers;
+  std::vector<TCOD_Map*> floors;
+  for (int z = 0; z < 3; ++z) {
+    layers.push_back(TCOD_map_new(WIDTH, HEIGHT));
+    floors.push_back(TCOD_map_new(WIDTH, HEIGHT));
+    TCOD_map_clear(layers.back(), true, true);
+    TCOD_map_clear(floors.back(), false, false);
+  }
+  SECTION("Solid floors keep the view on one layer") {
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 10, 15, 1, 0, true) == TCOD_E_OK);
+    for (int i = 0; i < WIDTH * HEIGHT; ++i) {
+      CAPTURE(i);
+      REQUIRE(!layers[0]->cells[i].fov);
+      REQUIRE(layers[1]->cells[i].fov);
+      REQUIRE(!layers[2]->cells[i].fov);
+    }
+    // NULL floors are solid.
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), nullptr, 3, 10, 15, 1, 0, true) == TCOD_E_OK);
+    CHECK(!TCOD_map_is_in_fov(layers[0], 10, 15));
+    CHECK(TCOD_map_is_in_fov(layers[1], 30, 25));
+  }
+  SECTION("A chasm shows the layer below") {
+    // The floor of the middle layer is open for x >= 20.
+    for (int y = 0; y < HEIGHT; ++y) {
+      for (int x = 20; x < WIDTH; ++x) TCOD_map_set_properties(floors[1], x, y, true, false);
+    }
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 10, 15, 1, 0, true) == TCOD_E_OK);
+    CHECK(TCOD_map_is_in_fov(layers[1], 10, 15));
+    CHECK(TCOD_map_is_in_fov(layers[0], 30, 15));  // Below the opening.
+    CHECK(TCOD_map_is_in_fov(layers[0], 21, 15));  // Just past the edge.
+    CHECK(!TCOD_map_is_in_fov(layers[0], 19, 15));  // Just before the edge.
+    CHECK(!TCOD_map_is_in_fov(layers[0], 5, 15));  // Below the solid floor.
+    CHECK(!TCOD_map_is_in_fov(layers[2], 10, 15));  // The top floor is solid.
+    // Looking up from the bottom layer through the same opening.
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 30, 15, 0, 0, true) == TCOD_E_OK);
+    CHECK(TCOD_map_is_in_fov(layers[1], 30, 15));
+    CHECK(TCOD_map_is_in_fov(layers[1], 15, 15));
+    CHECK(!TCOD_map_is_in_fov(layers[2], 30, 15));
+  }
+  SECTION("Walls and radius limit the view") {
+    for (int x = 5; x <= 15; ++x) {
+      TCOD_map_set_properties(layers[1], x, 10, false, false);
+      TCOD_map_set_properties(layers[1], x, 20, false, false);
+    }
+    for (int y = 10; y <= 20; ++y) {
+      TCOD_map_set_properties(layers[1], 5, y, false, false);
+      TCOD_map_set_properties(layers[1], 15, y, false, false);
+    }
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 10, 15, 1, 0, false) == TCOD_E_OK);
+    CHECK(TCOD_map_is_in_fov(layers[1], 14, 19));
+    CHECK(!TCOD_map_is_in_fov(layers[1], 15, 15));
+    CHECK(!TCOD_map_is_in_fov(layers[1], 25, 15));
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 10, 15, 1, 0, true) == TCOD_E_OK);
+    CHECK(TCOD_map_is_in_fov(layers[1], 15, 15));
+    CHECK(!TCOD_map_is_in_fov(layers[1], 16, 15));
+    REQUIRE(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 10, 15, 1, 3, true) == TCOD_E_OK);
+    CHECK(TCOD_map_is_in_fov(layers[1], 12, 15));
+    CHECK(!TCOD_map_is_in_fov(layers[1], 14, 15));
+  }
+  SECTION("Bad parameters") {
+    CHECK(TCOD_map_compute_fov_layers(layers.data(), floors.data(), 3, 10, 15, 3, 0, true) < 0);
+    TCOD_Map* small = TCOD_map_new(5, 5);
+    TCOD_Map* mixed[] = {layers[0], small};
+    CHECK(TCOD_map_compute_fov_layers(mixed, nullptr, 2, 1, 1, 0, 0, true) < 0);
+    TCOD_map_delete(small);
+  }
+  for (TCOD_Map* map : layers) TCOD_map_delete(map);
+  for (TCOD_Map* map : floors) TCOD_map_delete(map);
+  TCOD_fov_free_scratch();
+}
+
+TEST_CASE("FOV algorithm correctness matrix", "[fov]") {
+  static constexpr std::array<int, 3> RADII{0, 5, 12};
+  for (const auto& [kind, kind_name] : FOV_MAP_KINDS) {
+    const tcod::MapPtr_ map = make_fov_map(kind, 41, 31, 7);
+    const int pov_x = map->width / 2;
+    const int pov_y = map->height / 2;
+    for (int algo = 0; algo < NB_FOV_ALGORITHMS; ++algo) {
+      for (const int radius : RADII) {
+        for (const bool light_walls : {false, true}) {
+          INFO(FOV_ALGORITHM_NAMES[algo] << " on " << kind_name << " radius=" << radius << " light_walls=" << light_walls);
+          REQUIRE(
+              TCOD_map_compute_fov(map.get(), pov_x, pov_y, radius, light_walls, (TCOD_fov_algorithm_t)algo) ==
+              TCOD_E_OK);
+          std::vector<bool> dense(map->nbcells);
+          int lit_walls = 0;
+          int out_of_range = 0;
+          for (int y = 0; y < map->height; ++y) {
+            for (int x = 0; x < map->width; ++x) {
+              const bool fov = TCOD_map_is_in_fov(map.get(), x, y);
+              dense[x + y * map->width] = fov;
+              if (fov && !light_walls && !TCOD_map_is_transparent(map.get(), x, y)) ++lit_walls;
+              if (fov && radius > 0 && (std::abs(x - pov_x) > radius || std::abs(y - pov_y) > radius)) ++out_of_range;
+            }
+          }
+          CHECK(TCOD_map_is_in_fov(map.get(), pov_x, pov_y));
+          CHECK(lit_walls == 0);
+          CHECK(out_of_range == 0);
+          // Repeated calls and the sparse output agree with the dense result.
+          TCOD_FOVVisible visible{};
+          REQUIRE(
+              TCOD_map_compute_fov_visible(
+                  map.get(), pov_x, pov_y, radius, light_walls, (TCOD_fov_algorithm_t)algo, &visible) == TCOD_E_OK);
+          std::vector<bool> sparse(map->nbcells);
+          for (int i = 0; i < visible.count; ++i) sparse[visible.cells[i][0] + visible.cells[i][1] * map->width] = true;
+          TCOD_fov_visible_uninit(&visible);
+          CHECK(sparse == dense);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#include <libtcod/fov.h>
+#include <libtcod/lighting.h>
+
+#include <catch2/catch_all.hpp>
+#include <vector>
+
+namespace {
+/// Return the full lightmap of `lighting`.
+std::vector<TCOD_ColorRGB> get_lightmap(const TCOD_Lighting* lighting, const TCOD_Map* map) {
+  std::vector<TCOD_ColorRGB> out(TCOD_map_get_nb_cells(map));
+  TCOD_lighting_get_lightmap(lighting, out.data());
+  return out;
+}
+}  // namespace
+
+TEST_CASE("Lighting") {
+  TCOD_Map* map = TCOD_map_new(30, 20);
+  TCOD_map_clear(map, true, true);
+  for (int y = 0; y < 20; ++y) TCOD_map_set_properties(map, 15, y, false, false);
+  TCOD_Lighting* lighting = TCOD_lighting_new(map, FOV_SYMMETRIC_SHADOWCAST);
+  REQUIRE(lighting);
+  const int red = TCOD_lighting_add_light(lighting, 5, 10, 8, {255, 0, 0});
+  const int blue = TCOD_lighting_add_light(lighting, 25, 10, 12, {0, 0, 255});
+  REQUIRE(red >= 0);
+  REQUIRE(blue >= 0);
+  REQUIRE(TCOD_lighting_compute(lighting) == TCOD_E_OK);
+  CHECK(TCOD_lighting_get_color(lighting, 5, 10) == TCOD_ColorRGB{255, 0, 0});
+  CHECK(TCOD_lighting_get_color(lighting, 25, 10) == TCOD_ColorRGB{0, 0, 255});
+  CHECK(TCOD_lighting_get_color(lighting, 5, 19) == TCOD_ColorRGB{0, 0, 0});  // Out of range.
+  CHECK(TCOD_lighting_get_color(lighting, 10, 10).r > 0);
+  CHECK(TCOD_lighting_get_color(lighting, 14, 10).b == 0);  // Blocked by the wall.
+
+  SECTION("Incremental updates match a full recompute") {
+    TCOD_map_set_properties(map, 15, 10, true, true);  // Open a gap in the wall.
+    TCOD_lighting_mark_changed(lighting, 15, 10);
+    REQUIRE(TCOD_lighting_update_light(lighting, red, 6, 9, 10, {255, 128, 0}) == TCOD_E_OK);
+    REQUIRE(TCOD_lighting_compute(lighting) == TCOD_E_OK);
+    CHECK(TCOD_lighting_get_color(lighting, 14, 10).b > 0);
+
+    TCOD_Lighting* fresh = TCOD_lighting_new(map, FOV_SYMMETRIC_SHADOWCAST);
+    TCOD_lighting_add_light(fresh, 6, 9, 10, {255, 128, 0});
+    TCOD_lighting_add_light(fresh, 25, 10, 12, {0, 0, 255});
+    REQUIRE(TCOD_lighting_compute(fresh) == TCOD_E_OK);
+    CHECK(get_lightmap(lighting, map) == get_lightmap(fresh, map));
+    TCOD_lighting_delete(fresh);
+  }
+  SECTION("Removed lights are subtracted") {
+    REQUIRE(TCOD_lighting_remove_light(lighting, red) == TCOD_E_OK);
+    CHECK(TCOD_lighting_remove_light(lighting, red) == TCOD_E_INVALID_ARGUMENT);
+    REQUIRE(TCOD_lighting_compute(lighting) == TCOD_E_OK);
+    for (const auto& color : get_lightmap(lighting, map)) CHECK(color.r == 0);
+    CHECK(TCOD_lighting_add_light(lighting, 1, 1, 3, {1, 1, 1}) == red);  // Id is reused.
+  }
+  TCOD_lighting_delete(lighting);
+  TCOD_map_delete(map);
+}
+
+TEST_CASE("Lighting Benchmarks", "[.benchmark]") {
+  TCOD_Map* map = TCOD_map_new(200, 200);
+  TCOD_map_clear(map, true, true);
+  for (int i = 0; i < 200 * 200; i += 7) map->cells[i].transparent = false;
+  TCOD_Lighting* lighting = TCOD_lighting_new(map, FOV_SYMMETRIC_SHADOWCAST);
+  for (int i = 0; i < 300; ++i) TCOD_lighting_add_light(lighting, (i * 37) % 200, (i * 91) % 200, 8, {255, 200, 100});
+  (void)!TCOD_lighting_compute(lighting);
+  const int torch = TCOD_lighting_add_light(lighting, 100, 100, 10, {255, 255, 255});
+  int step = 0;
+  BENCHMARK("300 static torches, 1 moving light") {
+    ++step;
+    (void)!TCOD_lighting_update_light(lighting, torch, 100 + step % 10, 100, 10, {255, 255, 255});
+    return TCOD_lighting_compute(lighting);
+  };
+  TCOD_lighting_delete(lighting);
+  TCOD_map_delete(map);
+}
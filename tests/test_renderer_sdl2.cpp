@@ -0,0 +1,261 @@
+#ifndef NO_SDL
+#include <SDL3/SDL.h>
+
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <libtcod.hpp>
+#include <memory>
+#include <vector>
+
+namespace {
+struct SurfaceDeleter {
+  void operator()(SDL_Surface* surface) const { SDL_DestroySurface(surface); }
+};
+struct RendererDeleter {
+  void operator()(SDL_Renderer* renderer) const { SDL_DestroyRenderer(renderer); }
+};
+struct AtlasDeleter {
+  void operator()(TCOD_TilesetAtlasSDL2* atlas) const { TCOD_sdl2_atlas_delete(atlas); }
+};
+using SurfacePtr = std::unique_ptr<SDL_Surface, SurfaceDeleter>;
+using RendererPtr = std::unique_ptr<SDL_Renderer, RendererDeleter>;
+using AtlasPtr = std::unique_ptr<TCOD_TilesetAtlasSDL2, AtlasDeleter>;
+
+/// An SDL software renderer which draws onto an RGBA surface.
+struct SoftwareRenderer {
+  SoftwareRenderer(int width, int height) {
+    surface = SurfacePtr{SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32)};
+    REQUIRE(surface);
+    renderer = RendererPtr{SDL_CreateSoftwareRenderer(surface.get())};
+    REQUIRE(renderer);
+  }
+  SurfacePtr surface;
+  RendererPtr renderer;
+};
+
+/// Return a tileset with `count` distinct glyphs assigned to codepoints starting at 0x100.
+/// Every fifth glyph has color, the others are white.  Pixels are either opaque or fully transparent.
+auto new_glyph_tileset(int tile_width, int tile_height, int count) -> tcod::Tileset {
+  auto tileset = tcod::Tileset{tile_width, tile_height};
+  std::vector<TCOD_ColorRGBA> pixels(static_cast<size_t>(tile_width * tile_height));
+  for (int i = 0; i < count; ++i) {
+    for (int y = 0; y < tile_height; ++y) {
+      for (int x = 0; x < tile_width; ++x) {
+        const uint8_t alpha = (x * 3 + y * 5 + i) % 7 < 3 ? 255 : 0;
+        pixels.at(y * tile_width + x) = i % 5 == 0 ? TCOD_ColorRGBA{200, 100, static_cast<uint8_t>(i), alpha}
+                                                   : TCOD_ColorRGBA{255, 255, 255, alpha};
+      }
+    }
+    REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + i, pixels.data()) == TCOD_E_OK);
+  }
+  return tileset;
+}
+
+/// Return the console rendered by the software tileset renderer.
+auto render_reference(const tcod::Tileset& tileset, const tcod::Console& console) -> std::vector<TCOD_ColorRGBA> {
+  const int width = console.get_width() * tileset.get_tile_width();
+  const int height = console.get_height() * tileset.get_tile_height();
+  std::vector<TCOD_ColorRGBA> pixels(static_cast<size_t>(width * height));
+  REQUIRE(
+      TCOD_tileset_render_to_rgba(
+          tileset.get(), console.get(), nullptr, pixels.data(), width, height, width * (int)sizeof(pixels[0])) ==
+      TCOD_E_OK);
+  return pixels;
+}
+
+/// Render `console` with `atlas` and return the top-left pixels which it covers.
+/// This draws onto `target` if it is not NULL, otherwise onto the surface of `renderer`.
+/// `atlas` is const, as existing callers of TCOD_sdl2_render_texture pass it.
+auto render_sdl(
+    SoftwareRenderer& renderer,
+    const TCOD_TilesetAtlasSDL2* atlas,
+    const tcod::Console& console,
+    TCOD_Console* cache,
+    SDL_Texture* target = nullptr) -> std::vector<TCOD_ColorRGBA> {
+  REQUIRE(TCOD_sdl2_render_texture(atlas, console.get(), cache, target) == TCOD_E_OK);
+  const int width = console.get_width() * atlas->tileset->tile_width;
+  const int height = console.get_height() * atlas->tileset->tile_height;
+  REQUIRE(SDL_SetRenderTarget(renderer.renderer.get(), target));
+  auto captured = SurfacePtr{SDL_RenderReadPixels(renderer.renderer.get(), nullptr)};
+  REQUIRE(SDL_SetRenderTarget(renderer.renderer.get(), nullptr));
+  REQUIRE(captured);
+  auto rgba = SurfacePtr{SDL_ConvertSurface(captured.get(), SDL_PIXELFORMAT_RGBA32)};
+  REQUIRE(rgba);
+  REQUIRE(rgba->w >= width);
+  REQUIRE(rgba->h >= height);
+  std::vector<TCOD_ColorRGBA> pixels(static_cast<size_t>(width * height));
+  for (int y = 0; y < height; ++y) {
+    std::memcpy(
+        &pixels.at(y * width), static_cast<const char*>(rgba->pixels) + rgba->pitch * y, sizeof(pixels[0]) * width);
+  }
+  return pixels;
+}
+
+/// Return the number of pixels which differ between two images.
+/// Channels may differ by a small amount since SDL and libtcod round color modulation differently.
+auto count_mismatches(const std::vector<TCOD_ColorRGBA>& a, const std::vector<TCOD_ColorRGBA>& b) -> int {
+  REQUIRE(a.size() == b.size());
+  static constexpr int TOLERANCE = 2;
+  const auto differs = [](uint8_t x, uint8_t y) { return std::abs(int{x} - int{y}) > TOLERANCE; };
+  int mismatches = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (differs(a[i].r, b[i].r) || differs(a[i].g, b[i].g) || differs(a[i].b, b[i].b) || differs(a[i].a, b[i].a)) {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+/// Render `console` with SDL and return the number of pixels which differ from the software renderer.
+auto render_mismatches(
+    SoftwareRenderer& renderer,
+    TCOD_TilesetAtlasSDL2* atlas,
+    const tcod::Tileset& tileset,
+    const tcod::Console& console,
+    TCOD_Console* cache,
+    SDL_Texture* target = nullptr) -> int {
+  const auto expected = render_reference(tileset, console);
+  return count_mismatches(render_sdl(renderer, atlas, console, cache, target), expected);
+}
+
+/// Return a console with dirty tracking which can be used as the cache of `console`.
+auto new_cache_console(const tcod::Console& console) -> tcod::Console {
+  auto cache = tcod::Console{console.get_width(), console.get_height()};
+  REQUIRE(TCOD_console_set_dirty_tracking(cache.get(), true) == TCOD_E_OK);
+  for (auto& tile : cache) tile.ch = -1;
+  return cache;
+}
+
+/// Return the pixel width of the texture of `atlas`.
+auto get_atlas_size(const TCOD_TilesetAtlasSDL2& atlas) -> int {
+  float width = 0;
+  REQUIRE(SDL_GetTextureSize(atlas.texture, &width, nullptr));
+  return static_cast<int>(width);
+}
+}  // namespace
+
+TEST_CASE("SDL atlas matches the software renderer") {
+  auto tileset = new_glyph_tileset(8, 8, 20);
+  auto console = tcod::Console{12, 5};
+  REQUIRE(TCOD_console_set_dirty_tracking(console.get(), true) == TCOD_E_OK);
+  for (int y = 0; y < console.get_height(); ++y) {
+    for (int x = 0; x < console.get_width(); ++x) {
+      const uint8_t shade = static_cast<uint8_t>(x * 20 + y);
+      console.at(x, y) = {0x100 + (x + y * 3) % 20, {shade, 250, 40, 255}, {10, shade, 90, 255}};
+    }
+  }
+  console.at(0, 0).ch = ' ';  // Space.
+  console.at(1, 0).ch = 0x9999;  // Not in the tileset.
+  console.at(2, 0).fg.a = 0;  // Transparent glyph.
+  console.at(3, 0).fg = {10, console.at(3, 0).bg.g, 90, 255};  // Glyph matches the background.
+  SoftwareRenderer renderer{console.get_width() * 8, console.get_height() * 8};
+  auto atlas = AtlasPtr{TCOD_sdl2_atlas_new(renderer.renderer.get(), tileset.get())};
+  REQUIRE(atlas);
+  auto cache = new_cache_console(console);
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, cache.get()) == 0);
+  // Later frames only draw the tiles which changed, over vertices kept from the earlier frames.
+  console.at(5, 2) = {0x100 + 7, {1, 2, 3, 255}, {4, 5, 6, 255}};
+  console.at(6, 3).ch = ' ';
+  console.at(7, 4).bg = {200, 0, 0, 255};
+  TCOD_console_mark_dirty(console.get(), 0, 2, console.get_width(), 3);
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, cache.get()) == 0);
+  console.at(0, 0).ch = 0x100 + 3;
+  console.at(11, 4).ch = 0x100 + 19;
+  TCOD_console_mark_dirty(console.get(), 0, 0, console.get_width(), console.get_height());
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, cache.get()) == 0);
+  // Without a cache everything is drawn again.
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, nullptr) == 0);
+}
+
+// With 32x32 tiles the smallest atlas texture of 256x256 pixels holds 64 glyphs.
+TEST_CASE("SDL atlas evicts least recently used glyphs") {
+  auto tileset = new_glyph_tileset(32, 32, 200);
+  auto console = tcod::Console{8, 8};
+  REQUIRE(TCOD_console_set_dirty_tracking(console.get(), true) == TCOD_E_OK);
+  SoftwareRenderer renderer{console.get_width() * 32, console.get_height() * 32};
+  REQUIRE(SDL_SetNumberProperty(
+      SDL_GetRendererProperties(renderer.renderer.get()), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 256));
+  auto atlas = AtlasPtr{TCOD_sdl2_atlas_new(renderer.renderer.get(), tileset.get())};
+  REQUIRE(atlas);
+  REQUIRE(get_atlas_size(*atlas) == 256);
+  auto cache = new_cache_console(console);
+  // Every frame uses as many glyphs as fit, each frame replaces some of the glyphs of the previous one.
+  for (int frame = 0; frame < 6; ++frame) {
+    int i = 0;
+    for (auto& tile : console) tile = {0x100 + (frame * 37 + i++) % 200, {255, 255, 255, 255}, {0, 0, 64, 255}};
+    TCOD_console_mark_dirty(console.get(), 0, 0, console.get_width(), console.get_height());
+    CHECK(render_mismatches(renderer, atlas.get(), tileset, console, cache.get()) == 0);
+  }
+  CHECK(get_atlas_size(*atlas) == 256);
+}
+
+TEST_CASE("SDL atlas draws glyphs which did not fit once there is room") {
+  auto tileset = new_glyph_tileset(32, 32, 80);
+  auto console = tcod::Console{10, 8};
+  REQUIRE(TCOD_console_set_dirty_tracking(console.get(), true) == TCOD_E_OK);
+  SoftwareRenderer renderer{console.get_width() * 32, console.get_height() * 32};
+  REQUIRE(SDL_SetNumberProperty(
+      SDL_GetRendererProperties(renderer.renderer.get()), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 256));
+  auto atlas = AtlasPtr{TCOD_sdl2_atlas_new(renderer.renderer.get(), tileset.get())};
+  REQUIRE(atlas);
+  auto cache = new_cache_console(console);
+  // 80 different glyphs can not all fit in 64 slots, the last glyphs of this frame are skipped.
+  int i = 0;
+  for (auto& tile : console) tile = {0x100 + i++, {255, 255, 255, 255}, {0, 0, 64, 255}};
+  TCOD_console_mark_dirty(console.get(), 0, 0, console.get_width(), console.get_height());
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, cache.get()) > 0);
+  // Only the first rows change, the skipped glyphs of the last rows must still be drawn now that they fit.
+  for (int x = 0; x < console.get_width(); ++x) {
+    console.at(x, 0).ch = ' ';
+    console.at(x, 1).ch = ' ';
+  }
+  TCOD_console_mark_dirty(console.get(), 0, 0, console.get_width(), 2);
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, cache.get()) == 0);
+  CHECK(get_atlas_size(*atlas) == 256);
+}
+
+TEST_CASE("SDL atlas grows to fit the glyphs of a frame") {
+  auto tileset = new_glyph_tileset(32, 32, 100);
+  auto console = tcod::Console{10, 10};
+  SoftwareRenderer renderer{console.get_width() * 32, console.get_height() * 32};
+  REQUIRE(SDL_SetNumberProperty(
+      SDL_GetRendererProperties(renderer.renderer.get()), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 1024));
+  auto atlas = AtlasPtr{TCOD_sdl2_atlas_new(renderer.renderer.get(), tileset.get())};
+  REQUIRE(atlas);
+  REQUIRE(get_atlas_size(*atlas) == 256);
+  int i = 0;
+  for (auto& tile : console) tile = {0x100 + i++, {255, 255, 255, 255}, {0, 0, 64, 255}};
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, nullptr) == 0);
+  CHECK(get_atlas_size(*atlas) == 512);
+  // Glyphs packed before the atlas grew are still drawn correctly.
+  console.at(0, 0).ch = 0x100 + 99;
+  console.at(9, 9).ch = 0x100;
+  CHECK(render_mismatches(renderer, atlas.get(), tileset, console, nullptr) == 0);
+}
+
+TEST_CASE("SDL atlas uploads changed glyphs again") {
+  auto tileset = new_glyph_tileset(8, 8, 10);
+  auto console = tcod::Console{4, 2};
+  int i = 0;
+  for (auto& tile : console) tile = {0x100 + i++ % 3, {255, 255, 255, 255}, {0, 0, 64, 255}};
+  SoftwareRenderer renderer{console.get_width() * 8, console.get_height() * 8};
+  auto atlas = AtlasPtr{TCOD_sdl2_atlas_new(renderer.renderer.get(), tileset.get())};
+  REQUIRE(atlas);
+  TCOD_Console* cache = nullptr;
+  SDL_Texture* target = nullptr;
+  REQUIRE(TCOD_sdl2_render_texture_setup(atlas.get(), console.get(), &cache, &target) == TCOD_E_OK);
+  auto cache_owner = tcod::ConsolePtr{cache};
+  const auto expected = render_reference(tileset, console);
+  CHECK(count_mismatches(render_sdl(renderer, atlas.get(), console, cache, target), expected) == 0);
+  // Replace a glyph which is in the atlas, the console itself does not change.
+  std::vector<TCOD_ColorRGBA> pixels(8 * 8, TCOD_ColorRGBA{255, 255, 255, 0});
+  for (int y = 0; y < 8; ++y) pixels.at(y * 8 + y) = {255, 255, 255, 255};
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + 1, pixels.data()) == TCOD_E_OK);
+  const auto changed = render_reference(tileset, console);
+  REQUIRE(count_mismatches(expected, changed) > 0);
+  CHECK(count_mismatches(render_sdl(renderer, atlas.get(), console, cache, target), changed) == 0);
+  SDL_DestroyTexture(target);
+}
+#endif  // NO_SDL
@@ -0,0 +1,198 @@
+#if !defined(NO_SDL) && !defined(_WIN32)
+#include <SDL3/SDL.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <catch2/catch_all.hpp>
+#include <libtcod.hpp>
+#include <libtcod/libtcod_int.h>
+#include <string>
+
+namespace {
+/// An xterm encoder which is freed at the end of its scope.
+struct Encoder {
+  Encoder() { TCOD_xterm_encoder_forget_cursor_(&encoder); }
+  ~Encoder() { TCOD_xterm_encoder_uninit_(&encoder); }
+  Encoder(const Encoder&) = delete;
+  Encoder& operator=(const Encoder&) = delete;
+  /// Encode the changes between `console` and `cache` on an 80x24 terminal and return the escape sequences.
+  std::string encode(const tcod::Console& console, tcod::Console& cache) {
+    TCOD_xterm_encoder_begin_(&encoder);
+    REQUIRE(TCOD_xterm_encode_frame_(&encoder, console.get(), cache.get(), 80, 24) == TCOD_E_OK);
+    return std::string(encoder.buffer ? encoder.buffer : "", encoder.length);
+  }
+  /// Return the palette index of a color in an indexed color mode.
+  int palette_index(int r, int g, int b) const {
+    return encoder.palette_lut[((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)];
+  }
+  TCOD_XtermEncoder encoder{};
+};
+/// Return a renderer cache for `console` on which every tile will be drawn.
+tcod::Console new_cache_for(const tcod::Console& console) {
+  auto cache = tcod::Console{console.get_width(), console.get_height()};
+  for (auto& tile : cache) tile.ch = -1;
+  return cache;
+}
+}  // namespace
+
+TEST_CASE("Xterm encoder output") {
+  Encoder encoder;
+  auto console = tcod::Console{3, 2};
+  auto cache = new_cache_for(console);
+  console.at({0, 0}).ch = 'a';
+  console.at({1, 1}).ch = 'b';
+  // The full redraw moves down a row with CSI B, a line feed would also return to column 0 on some terminals.
+  CHECK(encoder.encode(console, cache) == "\x1b[H\x1b[38;2;255;255;255;48;2;0;0;0ma  \x1b[B\r b ");
+  console.at({2, 0}) = {'c', {255, 0, 0, 255}, {0, 0, 0, 255}};
+  CHECK(encoder.encode(console, cache) == "\x1b[A\x1b[D\x1b[38;2;255;0;0mc");
+  CHECK(encoder.encode(console, cache) == "");
+}
+
+TEST_CASE("Xterm encoder 256 color palette") {
+  Encoder encoder;
+  REQUIRE(TCOD_xterm_encoder_set_color_mode_(&encoder.encoder, TCOD_XTERM_COLOR_256, false) == TCOD_E_OK);
+  CHECK(encoder.palette_index(0, 0, 0) == 16);  // Black is in the color cube, the lightest gray is 8.
+  CHECK(encoder.palette_index(255, 255, 255) == 231);
+  CHECK(encoder.palette_index(255, 0, 0) == 196);
+  CHECK(encoder.palette_index(128, 128, 128) == 102);  // Closer to cube level 135 than to gray level 128.
+  CHECK(encoder.palette_index(100, 100, 100) == 241);
+  // Boundary between gray levels 58 and 68.
+  CHECK(encoder.palette_index(63, 63, 63) == 237);
+  CHECK(encoder.palette_index(64, 64, 64) == 238);
+  // Boundary between cube levels 95 and 135.
+  CHECK(encoder.palette_index(111, 0, 0) == 52);
+  CHECK(encoder.palette_index(112, 0, 0) == 88);
+
+  auto console = tcod::Console{4, 1};
+  auto cache = new_cache_for(console);
+  console.at({0, 0}).ch = 'x';
+  CHECK(encoder.encode(console, cache) == "\x1b[H\x1b[38;5;231;48;5;16mx   ");
+  CHECK(cache.at({0, 0}).fg.r == 231);  // The cache holds palette indexes.
+}
+
+TEST_CASE("Xterm encoder dithering") {
+  Encoder encoder;
+  REQUIRE(TCOD_xterm_encoder_set_color_mode_(&encoder.encoder, TCOD_XTERM_COLOR_256, true) == TCOD_E_OK);
+  auto console = tcod::Console{4, 1};
+  auto cache = new_cache_for(console);
+  for (auto& tile : console) tile.bg = {115, 115, 115, 255};
+  REQUIRE(encoder.palette_index(115, 115, 115) == 243);
+  (void)encoder.encode(console, cache);
+  // The first row of the Bayer matrix offsets the color by -18, 1, -13, and 6.
+  CHECK(cache.at({0, 0}).bg.r == 241);
+  CHECK(cache.at({1, 0}).bg.r == 243);
+  CHECK(cache.at({2, 0}).bg.r == 241);
+  CHECK(cache.at({3, 0}).bg.r == 244);
+}
+
+TEST_CASE("Xterm encoder 16 colors") {
+  Encoder encoder;
+  REQUIRE(TCOD_xterm_encoder_set_color_mode_(&encoder.encoder, TCOD_XTERM_COLOR_16, false) == TCOD_E_OK);
+  CHECK(encoder.palette_index(0, 0, 0) == 0);
+  CHECK(encoder.palette_index(200, 0, 0) == 1);
+  CHECK(encoder.palette_index(255, 0, 0) == 9);
+  CHECK(encoder.palette_index(128, 128, 128) == 8);
+  CHECK(encoder.palette_index(229, 229, 229) == 7);
+  CHECK(encoder.palette_index(255, 255, 255) == 15);
+
+  auto console = tcod::Console{2, 1};
+  auto cache = new_cache_for(console);
+  console.at({0, 0}) = {'x', {255, 0, 0, 255}, {200, 0, 0, 255}};
+  console.at({1, 0}) = {'y', {0, 0, 0, 255}, {255, 255, 255, 255}};
+  CHECK(encoder.encode(console, cache) == "\x1b[H\x1b[91;41mx\x1b[30;107my");
+}
+
+#if !defined(NO_SDL) && !defined(_WIN32)
+namespace {
+/// A socket pair where one end is the terminal of an xterm context and the other end is read by the test.
+struct TerminalSocket {
+  TerminalSocket() {
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    REQUIRE(fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK) == 0);
+  }
+  ~TerminalSocket() {
+    for (int fd : fds) {
+      if (fd >= 0) close(fd);
+    }
+  }
+  TerminalSocket(const TerminalSocket&) = delete;
+  TerminalSocket& operator=(const TerminalSocket&) = delete;
+  /// Return everything the context has written so far.
+  std::string read_all() {
+    std::string output;
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fds[1], buffer, sizeof(buffer))) > 0) output.append(buffer, static_cast<size_t>(length));
+    return output;
+  }
+  /// Send terminal input to the context.
+  void write_input(const std::string& input) {
+    REQUIRE(write(fds[1], input.data(), input.size()) == static_cast<ssize_t>(input.size()));
+  }
+  int fds[2] = {-1, -1};  // The context uses `fds[0]`.
+};
+}  // namespace
+
+TEST_CASE("Xterm file descriptor context") {
+  TerminalSocket terminal;
+  auto context = tcod::ContextPtr{TCOD_renderer_init_xterm_fd(terminal.fds[0], terminal.fds[0], 0, 0, "title")};
+  REQUIRE(context);
+  CHECK(
+      terminal.read_all() ==
+      "\x1b[?1049h\x1b[2J\x1b[?25l\x1b[?1003h\x1b[?1004h"  // Setup.
+      "\x1b[18t"  // Size query, since no size was given.
+      "\x1b]0;title\x07");
+  SDL_Event events[8];
+  CHECK(TCOD_context_xterm_poll_events(context.get(), events, 8) == 0);
+
+  // The reply to the size query is returned as a resize event.
+  terminal.write_input("\x1b[8;24;80t");
+  REQUIRE(TCOD_context_xterm_poll_events(context.get(), events, 8) == 1);
+  CHECK(events[0].type == SDL_EVENT_WINDOW_RESIZED);
+  CHECK(events[0].window.data1 == 80);
+  CHECK(events[0].window.data2 == 24);
+
+  auto console = tcod::Console{2, 1};
+  console.at({0, 0}).ch = 'a';
+  REQUIRE(TCOD_context_present(context.get(), console.get(), nullptr) == TCOD_E_OK);
+  CHECK(terminal.read_all() == "\x1b[2J\x1b[H\x1b[38;2;255;255;255;48;2;0;0;0ma ");
+
+  SECTION("Frames are skipped while the previous output is pending") {
+    auto big_console = tcod::Console{80, 24};
+    // Fill the socket buffer with frames until the context has output it can not send yet.
+    int pending = 0;
+    for (int frame = 0; frame < 1000 && pending == 0; ++frame) {
+      const auto red = static_cast<uint8_t>(frame);
+      for (auto& tile : big_console) tile = {'0' + frame % 10, {255, 255, 255, 255}, {red, 0, 0, 255}};
+      REQUIRE(TCOD_context_present(context.get(), big_console.get(), nullptr) == TCOD_E_OK);
+      pending = TCOD_context_xterm_flush(context.get());
+    }
+    REQUIRE(pending > 0);
+    // This frame is skipped and none of its output is queued.
+    big_console.at({0, 0}).ch = 'Z';
+    REQUIRE(TCOD_context_present(context.get(), big_console.get(), nullptr) == TCOD_E_OK);
+    CHECK(TCOD_context_xterm_flush(context.get()) == pending);
+    std::string output;
+    while (pending > 0) {
+      output += terminal.read_all();
+      pending = TCOD_context_xterm_flush(context.get());
+      REQUIRE(pending >= 0);
+    }
+    output += terminal.read_all();
+    CHECK(output.find('Z') == std::string::npos);
+    // The skipped change is sent with the next frame.
+    REQUIRE(TCOD_context_present(context.get(), big_console.get(), nullptr) == TCOD_E_OK);
+    CHECK(terminal.read_all() == "\x1b[HZ");
+  }
+  SECTION("Closing the terminal input sends a quit event") {
+    terminal.write_input("a");
+    REQUIRE(shutdown(terminal.fds[1], SHUT_WR) == 0);
+    REQUIRE(TCOD_context_xterm_poll_events(context.get(), events, 8) == 3);
+    CHECK(events[0].type == SDL_EVENT_KEY_DOWN);
+    CHECK(events[1].type == SDL_EVENT_KEY_UP);
+    CHECK(events[2].type == SDL_EVENT_QUIT);
+    CHECK(TCOD_context_xterm_poll_events(context.get(), events, 8) == 0);
+  }
+}
+#endif  // !defined(NO_SDL) && !defined(_WIN32)
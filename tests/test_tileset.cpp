@@ -1,6 +1,17 @@
 #include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <libtcod/console_types.hpp>
+#include <libtcod/libtcod_int.h>
 #include <libtcod/tileset.hpp>
 #include <libtcod/tileset_bdf.hpp>
+#include <libtcod/tileset_cache.h>
+#include <libtcod/tileset_render.h>
+#include <libtcod/tileset_truetype.h>
+#include <string>
+#include <vector>
 
 #include "common.hpp"
 
@@ -23,3 +34,470 @@ TEST_CASE("Load BDF.") {
   tileset = tcod::load_bdf(get_file("fonts/Tamzen5x9r.bdf"));
   REQUIRE(tileset);
 }
+
+/// Return the expected pixel of a tile, matching the blend used by the software renderer.
+static TCOD_ColorRGBA expected_pixel(const TCOD_ConsoleTile& tile, const TCOD_ColorRGBA* graphic) {
+  if (!graphic) return tile.bg;
+  const TCOD_ColorRGBA fg{
+      static_cast<uint8_t>(tile.fg.r * graphic->r / 255),
+      static_cast<uint8_t>(tile.fg.g * graphic->g / 255),
+      static_cast<uint8_t>(tile.fg.b * graphic->b / 255),
+      static_cast<uint8_t>(tile.fg.a * graphic->a / 255),
+  };
+  const int out_a = fg.a + tile.bg.a * (255 - fg.a) / 255;
+  const auto channel = [&](int dst, int src) {
+    return static_cast<uint8_t>((src * fg.a + dst * tile.bg.a * (255 - fg.a) / 255) / out_a);
+  };
+  return {channel(tile.bg.r, fg.r), channel(tile.bg.g, fg.g), channel(tile.bg.b, fg.b), static_cast<uint8_t>(out_a)};
+}
+
+TEST_CASE("Render console to RGBA.") {
+  static constexpr int TILE_W = 3;
+  static constexpr int TILE_H = 2;
+  auto tileset = tcod::Tileset{TILE_W, TILE_H};
+  const std::vector<TCOD_ColorRGBA> glyph{
+      {255, 255, 255, 255}, {255, 255, 255, 0}, {255, 128, 0, 128},
+      {10, 20, 30, 255},    {0, 0, 0, 1},       {200, 100, 50, 77}};
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'A', glyph.data()) == TCOD_E_OK);
+  auto console = tcod::Console{70, 5};  // Wider than one 64 tile bitmask word.
+  for (int y = 0; y < console.get_height(); ++y) {
+    for (int x = 0; x < console.get_width(); ++x) {
+      console.at(x, y) = {(x + y) % 3 ? 'A' : ' ', {uint8_t(x * 3), uint8_t(y * 40), 200, 255}, {9, uint8_t(x), 7, 255}};
+    }
+  }
+  const auto check_pixels = [&](const std::vector<TCOD_ColorRGBA>& pixels, int width, int height, int stride) {
+    int mismatches = 0;
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const auto& tile = console.at(x / TILE_W, y / TILE_H);
+        const TCOD_ColorRGBA* graphic = TCOD_tileset_get_tile(tileset.get(), tile.ch);
+        const TCOD_ColorRGBA expected =
+            expected_pixel(tile, graphic ? &graphic[(y % TILE_H) * TILE_W + x % TILE_W] : nullptr);
+        const TCOD_ColorRGBA& got = pixels.at(y * stride + x);
+        mismatches += got.r != expected.r || got.g != expected.g || got.b != expected.b || got.a != expected.a;
+      }
+    }
+    return mismatches;
+  };
+  SECTION("Full image with a cache.") {
+    const int width = console.get_width() * TILE_W;
+    const int height = console.get_height() * TILE_H;
+    std::vector<TCOD_ColorRGBA> pixels(width * height);
+    TCOD_Console* cache = nullptr;
+    REQUIRE(
+        TCOD_tileset_render_to_rgba(
+            tileset.get(), console.get(), &cache, pixels.data(), width, height, width * sizeof(pixels[0])) ==
+        TCOD_E_OK);
+    REQUIRE(cache);
+    CHECK(check_pixels(pixels, width, height, width) == 0);
+    // Unchanged tiles are skipped, so the marker is kept while the changed tile is drawn again.
+    pixels.at(0) = {1, 2, 3, 4};
+    console.at(66, 4).fg = {255, 255, 255, 255};
+    REQUIRE(
+        TCOD_tileset_render_to_rgba(
+            tileset.get(), console.get(), &cache, pixels.data(), width, height, width * sizeof(pixels[0])) ==
+        TCOD_E_OK);
+    CHECK(pixels.at(0).a == 4);
+    pixels.at(0) = console.at(0, 0).bg;
+    CHECK(check_pixels(pixels, width, height, width) == 0);
+    TCOD_console_delete(cache);
+  }
+  SECTION("Clipped image with padded rows.") {
+    const int width = 100;
+    const int height = 7;
+    const int stride = 104;
+    const TCOD_ColorRGBA padding{11, 22, 33, 44};
+    std::vector<TCOD_ColorRGBA> pixels(stride * height, padding);
+    REQUIRE(
+        TCOD_tileset_render_to_rgba(
+            tileset.get(), console.get(), nullptr, pixels.data(), width, height, stride * sizeof(pixels[0])) ==
+        TCOD_E_OK);
+    CHECK(check_pixels(pixels, width, height, stride) == 0);
+    for (int y = 0; y < height; ++y) {
+      for (int x = width; x < stride; ++x) CHECK(pixels.at(y * stride + x).a == padding.a);
+    }
+  }
+  SECTION("Invalid stride.") {
+    std::vector<TCOD_ColorRGBA> pixels(16);
+    CHECK(TCOD_tileset_render_to_rgba(tileset.get(), console.get(), nullptr, pixels.data(), 4, 4, 15) < 0);
+  }
+}
+
+TEST_CASE("Render RGBA blending matches the scalar blend.") {
+  // Every glyph alpha against a range of foreground and background colors, including the opaque fast paths.
+  static constexpr int TILE_SIZE = 16;
+  auto tileset = tcod::Tileset{TILE_SIZE, TILE_SIZE};
+  std::vector<TCOD_ColorRGBA> gradient(TILE_SIZE * TILE_SIZE);
+  std::vector<TCOD_ColorRGBA> mask(TILE_SIZE * TILE_SIZE);
+  for (int i = 0; i < TILE_SIZE * TILE_SIZE; ++i) {
+    gradient.at(i) = {uint8_t(i), uint8_t(255 - i), uint8_t(i * 37), uint8_t(i)};
+    mask.at(i) = (i / 8) % 3 ? TCOD_ColorRGBA{255, 255, 255, 255} : TCOD_ColorRGBA{255, 255, 255, 0};
+  }
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'G', gradient.data()) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'M', mask.data()) == TCOD_E_OK);
+  auto console = tcod::Console{256, 8};
+  for (int y = 0; y < console.get_height(); ++y) {
+    for (int x = 0; x < console.get_width(); ++x) {
+      const uint8_t fg_a = x % 4 == 0 ? 255 : uint8_t(x);
+      const uint8_t bg_a = y == 7 ? 128 : 255;
+      console.at(x, y) = {
+          (x + y) % 2 ? 'G' : 'M',
+          {uint8_t(x), uint8_t(255 - x), uint8_t(x * 7), fg_a},
+          {uint8_t(y * 31), uint8_t(255 - y * 17), uint8_t(y * 3), bg_a}};
+    }
+  }
+  const int width = console.get_width() * TILE_SIZE;
+  const int height = console.get_height() * TILE_SIZE;
+  std::vector<TCOD_ColorRGBA> pixels(width * height);
+  REQUIRE(
+      TCOD_tileset_render_to_rgba(
+          tileset.get(), console.get(), nullptr, pixels.data(), width, height, width * sizeof(pixels[0])) ==
+      TCOD_E_OK);
+  int mismatches = 0;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const auto& tile = console.at(x / TILE_SIZE, y / TILE_SIZE);
+      const auto& glyph = tile.ch == 'G' ? gradient : mask;
+      const TCOD_ColorRGBA expected = expected_pixel(tile, &glyph.at((y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE));
+      const TCOD_ColorRGBA& got = pixels.at(y * width + x);
+      mismatches += got.r != expected.r || got.g != expected.g || got.b != expected.b || got.a != expected.a;
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("Render RGBA on multiple threads.") {
+  static constexpr int TILE_W = 3;
+  static constexpr int TILE_H = 2;
+  auto tileset = tcod::Tileset{TILE_W, TILE_H};
+  const std::vector<TCOD_ColorRGBA> glyph{
+      {255, 255, 255, 255}, {255, 255, 255, 0}, {255, 128, 0, 128},
+      {10, 20, 30, 255},    {0, 0, 0, 1},       {200, 100, 50, 77}};
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'A', glyph.data()) == TCOD_E_OK);
+  // Large enough for 64K pixel jobs on at least 4 threads.
+  auto console = tcod::Console{200, 250};
+  for (int y = 0; y < console.get_height(); ++y) {
+    for (int x = 0; x < console.get_width(); ++x) {
+      console.at(x, y) = {(x + y) % 3 ? 'A' : ' ', {uint8_t(x), uint8_t(y), 200, 255}, {9, uint8_t(x + y), 7, 255}};
+    }
+  }
+  const int width = console.get_width() * TILE_W;
+  const int height = console.get_height() * TILE_H;
+  const auto render = [&](int max_threads, TCOD_Console** cache, std::vector<TCOD_ColorRGBA>& pixels) {
+    TCOD_parallel_set_max_threads_(max_threads);
+    const TCOD_Error err = TCOD_tileset_render_to_rgba(
+        tileset.get(), console.get(), cache, pixels.data(), width, height, width * sizeof(pixels[0]));
+    TCOD_parallel_set_max_threads_(0);
+    REQUIRE(err == TCOD_E_OK);
+  };
+  std::vector<TCOD_ColorRGBA> single(width * height);
+  render(1, nullptr, single);
+  // Every thread must be done once the call returns, check the output of fresh buffers right away.
+  for (int i = 0; i < 4; ++i) {
+    std::vector<TCOD_ColorRGBA> fresh(width * height);
+    render(2 + i, nullptr, fresh);
+    CHECK(std::equal(single.begin(), single.end(), fresh.begin()));
+  }
+  std::vector<TCOD_ColorRGBA> threaded(width * height);
+  TCOD_Console* cache = nullptr;
+  render(4, &cache, threaded);
+  CHECK(std::equal(single.begin(), single.end(), threaded.begin()));
+  // Changed tiles in the slices of different threads are drawn again.
+  for (int y = 0; y < console.get_height(); y += 37) console.at(y % console.get_width(), y).fg = {1, 2, 3, 255};
+  render(1, nullptr, single);
+  render(4, &cache, threaded);
+  CHECK(std::equal(single.begin(), single.end(), threaded.begin()));
+  TCOD_console_delete(cache);
+}
+
+TEST_CASE("Sparse tileset character map.") {
+  auto tileset = tcod::Tileset{1, 1};
+  const TCOD_ColorRGBA pixel{1, 2, 3, 4};
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 'A', &pixel) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x1F600, &pixel) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x10FFFF, &pixel) == TCOD_E_OK);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 'A') == 1);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 0x1F600) == 2);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 0x10FFFF) == 3);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 'B') == 0);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 0x1F601) == 0);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 0x8000) == 0);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), -1) == 0);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 0x7FFFFFFF) == 0);
+  // Only pages with assigned codepoints are allocated.
+  int populated_pages = 0;
+  for (int i = 0; i < tileset.get()->character_map_length / TCOD_CHARMAP_PAGE_SIZE; ++i) {
+    populated_pages += tileset.get()->character_map_pages[i] != tileset.get()->character_map_pages[1];
+  }
+  CHECK(populated_pages == 3);
+  CHECK(TCOD_tileset_assign_tile(tileset.get(), 1, 0x7FFFFFFF) < 0);
+  CHECK(TCOD_tileset_assign_tile(tileset.get(), 1, 0x1F601) == 1);
+  CHECK(TCOD_tileset_get_tile_id(tileset.get(), 0x1F601) == 1);
+}
+
+TEST_CASE("Tileset cache.") {
+  const std::string source_path = get_file("fonts/ucs-fonts/4x6.bdf");
+  const std::string cache_path = std::tmpnam(nullptr);
+  TCOD_TilesetSource source{};
+  source.type = TCOD_TILESET_SOURCE_BDF;
+  source.path = source_path.c_str();
+  uint64_t source_hash = 0;
+  REQUIRE(TCOD_tileset_source_hash(&source, &source_hash) == TCOD_E_OK);
+
+  const auto expected = tcod::load_bdf(source_path);
+  const auto check_matches_source = [&](const TCOD_Tileset* tileset) {
+    REQUIRE(tileset->tile_width == expected->tile_width);
+    REQUIRE(tileset->tile_height == expected->tile_height);
+    std::vector<TCOD_ColorRGBA> got(tileset->tile_length);
+    std::vector<TCOD_ColorRGBA> want(tileset->tile_length);
+    int mismatches = 0;
+    for (int codepoint = 0; codepoint < 0x10000; ++codepoint) {
+      const int tile_id = TCOD_tileset_get_tile_id(expected.get(), codepoint);
+      if (TCOD_tileset_get_tile_id(tileset, codepoint) != tile_id) {
+        ++mismatches;
+        continue;
+      }
+      if (tile_id == 0) continue;
+      REQUIRE(TCOD_tileset_get_tile_(tileset, codepoint, got.data()) == TCOD_E_OK);
+      REQUIRE(TCOD_tileset_get_tile_(expected.get(), codepoint, want.data()) == TCOD_E_OK);
+      for (int i = 0; i < tileset->tile_length; ++i) {
+        mismatches += got[i].a != want[i].a ||
+                      (want[i].a && (got[i].r != want[i].r || got[i].g != want[i].g || got[i].b != want[i].b));
+      }
+    }
+    CHECK(mismatches == 0);
+  };
+
+  std::remove(cache_path.c_str());
+  {
+    auto tileset = tcod::TilesetPtr{TCOD_tileset_load_cached(&source, cache_path.c_str())};
+    REQUIRE(tileset);
+    check_matches_source(tileset.get());
+  }
+  {
+    auto tileset = tcod::TilesetPtr{TCOD_tileset_load_cache(cache_path.c_str(), source_hash)};
+    REQUIRE(tileset);
+    check_matches_source(tileset.get());
+  }
+  // A cache built from a different source is stale.
+  CHECK(!tcod::TilesetPtr{TCOD_tileset_load_cache(cache_path.c_str(), source_hash ^ 1)});
+
+  // Corrupt the last byte of the cache.
+  {
+    std::FILE* file = std::fopen(cache_path.c_str(), "r+b");
+    REQUIRE(file);
+    std::fseek(file, -1, SEEK_END);
+    const int byte = std::fgetc(file);
+    std::fseek(file, -1, SEEK_END);
+    std::fputc(byte ^ 0xFF, file);
+    std::fclose(file);
+  }
+  CHECK(!tcod::TilesetPtr{TCOD_tileset_load_cache(cache_path.c_str(), 0)});
+  {
+    auto tileset = tcod::TilesetPtr{TCOD_tileset_load_cached(&source, cache_path.c_str())};
+    REQUIRE(tileset);
+    check_matches_source(tileset.get());
+  }
+  {
+    auto tileset = tcod::TilesetPtr{TCOD_tileset_load_cache(cache_path.c_str(), source_hash)};
+    REQUIRE(tileset);
+    check_matches_source(tileset.get());
+  }
+  std::remove(cache_path.c_str());
+}
+
+TEST_CASE("Alpha-only tileset storage.") {
+  auto tileset = tcod::load_bdf(get_file("fonts/ucs-fonts/4x6.bdf"));
+  TCOD_Tileset* ptr = tileset.get();
+  REQUIRE(ptr->alpha);
+  CHECK(!ptr->pixels);  // The RGBA view is only made when requested.
+  std::vector<TCOD_ColorRGBA> copied(ptr->tile_length);
+  REQUIRE(TCOD_tileset_get_tile_(ptr, 'A', copied.data()) == TCOD_E_OK);
+  CHECK(!ptr->pixels);  // Copying a tile expands it directly.
+  const TCOD_ColorRGBA* view = TCOD_tileset_get_tile(ptr, 'A');
+  REQUIRE(view);
+  int mismatches = 0;
+  int visible = 0;
+  for (int i = 0; i < ptr->tile_length; ++i) {
+    const TCOD_ColorRGBA expected{255, 255, 255, ptr->alpha[TCOD_tileset_get_tile_id(ptr, 'A') * ptr->tile_length + i]};
+    mismatches += !(view[i] == expected) || !(copied[i] == expected);
+    visible += expected.a != 0;
+  }
+  CHECK(mismatches == 0);
+  CHECK(visible > 0);
+
+  // White tiles keep the alpha-only storage.
+  std::vector<TCOD_ColorRGBA> tile(ptr->tile_length, TCOD_ColorRGBA{255, 255, 255, 128});
+  REQUIRE(TCOD_tileset_set_tile_(ptr, 0x10000, tile.data()) == TCOD_E_OK);
+  REQUIRE(ptr->alpha);
+  REQUIRE(TCOD_tileset_get_tile_(ptr, 0x10000, copied.data()) == TCOD_E_OK);
+  CHECK(copied == tile);
+
+  // A tile with color switches the tileset to RGBA storage.
+  tile.at(0) = TCOD_ColorRGBA{255, 0, 0, 255};
+  REQUIRE(TCOD_tileset_set_tile_(ptr, 0x10001, tile.data()) == TCOD_E_OK);
+  CHECK(!ptr->alpha);
+  REQUIRE(TCOD_tileset_get_tile_(ptr, 0x10001, copied.data()) == TCOD_E_OK);
+  CHECK(copied == tile);
+  REQUIRE(TCOD_tileset_get_tile_(ptr, 'A', copied.data()) == TCOD_E_OK);
+  CHECK(std::equal(copied.begin(), copied.end(), TCOD_tileset_get_tile(ptr, 'A')));
+
+  // Tilesets without color can be compacted again.
+  auto white = tcod::Tileset{2, 2};
+  const TCOD_ColorRGBA white_tile[4]{{255, 255, 255, 0}, {255, 255, 255, 64}, {255, 255, 255, 128}, {0, 0, 0, 0}};
+  REQUIRE(TCOD_tileset_set_tile_(white.get(), 'a', white_tile) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_compact_alpha(white.get()) == TCOD_E_OK);
+  REQUIRE(white.get()->alpha);
+  TCOD_ColorRGBA white_out[4];
+  REQUIRE(TCOD_tileset_get_tile_(white.get(), 'a', white_out) == TCOD_E_OK);
+  CHECK(white_out[2] == white_tile[2]);
+  CHECK(white_out[3] == TCOD_ColorRGBA{255, 255, 255, 0});  // Transparent pixels are read back as white.
+}
+
+namespace {
+/// Records the notifications received by a tileset observer.
+struct ObserverLog {
+  std::vector<int> changed_tiles;  // Tile IDs passed to on_tile_changed.
+  std::vector<std::vector<uint64_t>> batches;  // Bitsets passed to on_tiles_changed.
+};
+int log_tile_changed(TCOD_TilesetObserver* observer, int tile_id) {
+  static_cast<ObserverLog*>(observer->userdata)->changed_tiles.push_back(tile_id);
+  return 0;
+}
+int log_tiles_changed(TCOD_TilesetObserver* observer, const uint64_t* changed, int length) {
+  static_cast<ObserverLog*>(observer->userdata)->batches.emplace_back(changed, changed + length);
+  return 0;
+}
+}  // namespace
+
+TEST_CASE("Tileset batched change notifications.") {
+  ObserverLog batched_log;
+  ObserverLog single_log;
+  auto tileset = tcod::Tileset{2, 2};
+  const std::vector<TCOD_ColorRGBA> pixels(4, TCOD_ColorRGBA{255, 255, 255, 255});
+  for (int i = 0; i < 100; ++i) REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + i, pixels.data()) == TCOD_E_OK);
+  TCOD_TilesetObserver* batched = TCOD_tileset_observer_new(tileset.get());
+  REQUIRE(batched);
+  batched->userdata = &batched_log;
+  batched->on_tile_changed = log_tile_changed;
+  batched->on_tiles_changed = log_tiles_changed;
+  TCOD_TilesetObserver* single = TCOD_tileset_observer_new(tileset.get());
+  REQUIRE(single);
+  single->userdata = &single_log;
+  single->on_tile_changed = log_tile_changed;  // Without on_tiles_changed, batches are delivered one tile at a time.
+  const int low_tile = TCOD_tileset_get_tile_id(tileset.get(), 0x100 + 3);
+  const int high_tile = TCOD_tileset_get_tile_id(tileset.get(), 0x100 + 90);
+  REQUIRE(low_tile < 64);
+  REQUIRE(high_tile >= 64);
+
+  TCOD_tileset_begin_batch(tileset.get());
+  TCOD_tileset_begin_batch(tileset.get());
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + 90, pixels.data()) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + 3, pixels.data()) == TCOD_E_OK);
+  TCOD_tileset_end_batch(tileset.get());
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + 90, pixels.data()) == TCOD_E_OK);  // Changed twice.
+  // Nothing is delivered until the outermost batch ends.
+  CHECK(batched_log.changed_tiles.empty());
+  CHECK(batched_log.batches.empty());
+  CHECK(single_log.changed_tiles.empty());
+  TCOD_tileset_end_batch(tileset.get());
+
+  CHECK(batched_log.changed_tiles.empty());
+  REQUIRE(batched_log.batches.size() == 1);
+  const std::vector<uint64_t>& bits = batched_log.batches.at(0);
+  REQUIRE(static_cast<int>(bits.size()) > high_tile / 64);
+  for (int tile_id = 0; tile_id < static_cast<int>(bits.size()) * 64; ++tile_id) {
+    const bool is_set = (bits.at(tile_id / 64) >> (tile_id % 64)) & 1;
+    CHECK(is_set == (tile_id == low_tile || tile_id == high_tile));
+  }
+  CHECK(single_log.changed_tiles == std::vector<int>{low_tile, high_tile});
+
+  // Unbalanced ends are ignored and changes outside of a batch are delivered immediately.
+  TCOD_tileset_end_batch(tileset.get());
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x100 + 3, pixels.data()) == TCOD_E_OK);
+  CHECK(batched_log.changed_tiles == std::vector<int>{low_tile});
+  CHECK(batched_log.batches.size() == 1);
+  CHECK(single_log.changed_tiles == std::vector<int>{low_tile, high_tile, low_tile});
+  // A batch without changes notifies nobody.
+  TCOD_tileset_begin_batch(tileset.get());
+  TCOD_tileset_end_batch(tileset.get());
+  CHECK(batched_log.batches.size() == 1);
+  TCOD_tileset_observer_delete(single);
+  TCOD_tileset_observer_delete(batched);
+}
+
+namespace {
+/// Renders pending tiles with an alpha of `tile_id * 2` and counts how many were rendered.
+struct TileRenderer {
+  std::atomic<int> rendered{0};
+};
+int render_requested_tile(TCOD_TilesetObserver* observer, int tile_id, unsigned char* alpha) {
+  const TCOD_Tileset* tileset = observer->tileset;
+  for (int i = 0; i < tileset->tile_length; ++i) alpha[i] = static_cast<unsigned char>(tile_id * 2);
+  ++static_cast<TileRenderer*>(observer->userdata)->rendered;
+  return 0;
+}
+/// Add `count` pending tiles for codepoints starting at 0x100, rendered by `renderer`.
+void add_pending_tiles(TCOD_Tileset* tileset, TileRenderer& renderer, int count) {
+  TCOD_TilesetObserver* observer = TCOD_tileset_observer_new(tileset);
+  REQUIRE(observer);
+  observer->userdata = &renderer;
+  observer->on_tile_requested = render_requested_tile;
+  for (int i = 0; i < count; ++i) {
+    const int tile_id = TCOD_tileset_new_pending_tile_(tileset);
+    REQUIRE(tile_id > 0);
+    REQUIRE(TCOD_tileset_assign_tile(tileset, tile_id, 0x100 + i) >= 0);
+  }
+}
+}  // namespace
+
+TEST_CASE("Tileset renders pending tiles on first use.") {
+  TileRenderer renderer;
+  auto tileset = tcod::Tileset{2, 2};
+  add_pending_tiles(tileset.get(), renderer, 2);
+  CHECK(renderer.rendered == 0);
+  TCOD_ColorRGBA tile[4];
+  REQUIRE(TCOD_tileset_get_tile_(tileset.get(), 0x100, tile) == TCOD_E_OK);
+  CHECK(renderer.rendered == 1);
+  const int tile_id = TCOD_tileset_get_tile_id(tileset.get(), 0x100);
+  CHECK(tile[3] == TCOD_ColorRGBA{255, 255, 255, static_cast<uint8_t>(tile_id * 2)});
+  REQUIRE(TCOD_tileset_get_tile_(tileset.get(), 0x100, tile) == TCOD_E_OK);
+  CHECK(renderer.rendered == 1);  // Tiles are only rendered once.
+
+  // Overwriting a pending tile keeps the new pixels instead of rendering over them later.
+  const std::vector<TCOD_ColorRGBA> red(4, TCOD_ColorRGBA{255, 0, 0, 255});
+  REQUIRE(TCOD_tileset_set_tile_(tileset.get(), 0x101, red.data()) == TCOD_E_OK);
+  REQUIRE(TCOD_tileset_get_tile_(tileset.get(), 0x101, tile) == TCOD_E_OK);
+  CHECK(tile[0] == red[0]);
+  CHECK(renderer.rendered == 1);
+}
+
+TEST_CASE("Tileset renders pending tiles ahead of their first use.") {
+  TileRenderer renderer;
+  {
+    auto tileset = tcod::Tileset{2, 2};
+    add_pending_tiles(tileset.get(), renderer, 100);
+    REQUIRE(TCOD_tileset_truetype_render_ahead_(tileset.get(), 0x100, 0x100 + 99) == TCOD_E_OK);
+    REQUIRE(TCOD_tileset_truetype_render_ahead_(tileset.get(), 0, 0x200) == TCOD_E_OK);  // Tiles may be queued twice.
+    for (int i = 0; i < 100; ++i) {
+      TCOD_ColorRGBA tile[4];
+      REQUIRE(TCOD_tileset_get_tile_(tileset.get(), 0x100 + i, tile) == TCOD_E_OK);
+      const int tile_id = TCOD_tileset_get_tile_id(tileset.get(), 0x100 + i);
+      CHECK(tile[0].a == tile_id * 2);
+    }
+    CHECK(renderer.rendered == 100);
+  }
+  // Deleting a tileset stops its background renderer, even with tiles still queued.
+  renderer.rendered = 0;
+  {
+    auto tileset = tcod::Tileset{2, 2};
+    add_pending_tiles(tileset.get(), renderer, 1000);
+    REQUIRE(TCOD_tileset_truetype_render_ahead_(tileset.get(), 0x100, 0x100 + 999) == TCOD_E_OK);
+  }
+  const int rendered = renderer.rendered;
+  CHECK(rendered <= 1000);
+  CHECK(renderer.rendered == rendered);  // Nothing renders after the tileset is gone.
+  // Tilesets without pending tiles have nothing to render ahead.
+  auto tileset = tcod::Tileset{2, 2};
+  CHECK(TCOD_tileset_truetype_render_ahead_(tileset.get(), 0, 0x200) == TCOD_E_OK);
+}